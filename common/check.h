@@ -0,0 +1,38 @@
+/**
+ * @file check.h
+ * @date Oct 18, 2026
+ * @brief The checks of the self-checking programs of fingersTeleop/exe. A check prints what it
+ * checks and whether it holds on a line after the tag of the program, and the program exits with
+ * a failure at the end if one did not hold.
+ *
+ *   check("grasp", detector.state() == GRASP_OPEN, "an open hand is open");
+ *   ...at the end of main:
+ *   checkExit("grasp");
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/// The checks that did not hold so far; a failure found outside a check may be added to it
+inline size_t& checksFailed () {
+	static size_t count = 0;
+	return count;
+}
+
+/// Prints the outcome of a check after the tag of the program and counts it if it failed
+inline void check (const char* prefix, bool condition, const char* what) {
+	printf("[%s] %-60s %s\n", prefix, what, condition ? "ok" : "FAILED");
+	if(!condition) checksFailed()++;
+}
+
+/// Exits with a failure if a check did not hold, and with success otherwise
+inline void checkExit (const char* prefix) {
+	if(checksFailed() > 0) {
+		fprintf(stderr, "[%s] %zu checks failed\n", prefix, checksFailed());
+		exit(EXIT_FAILURE);
+	}
+	exit(EXIT_SUCCESS);
+}
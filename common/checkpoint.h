@@ -0,0 +1,136 @@
+/**
+ * @file checkpoint.h
+ * @date Oct 18, 2026
+ * @brief The hot state of a daemon (filter state, last valid pose, calibration, sequence
+ * counters) kept in a named POSIX shared memory segment, so that a restarted instance resumes
+ * where the last one stopped instead of starting cold. The state is a plain struct that is
+ * copied as bytes; the daemon saves it after every frame under a sequence lock (two release
+ * stores around a copy, no system call) and a new instance restores it once at startup, which
+ * retries while a save is half written. A save always starts from an even sequence, so that one
+ * cut short by the death of its writer is never restored and the next save is whole again. One
+ * process writes a segment: the first save takes an exclusive lock (flock) on it, which the kernel
+ * drops when the process dies, and the saves of another instance are refused until then. The
+ * segment carries the size of the state and a layout version so that a binary with a different
+ * state ignores it, and outlives the process until it is unlinked (ipcrm or a reboot).
+ *
+ *   Checkpoint <PrintState> checkpoint ("/fingers-printLiberty", 1);
+ *   PrintState state;
+ *   double age;
+ *   if(checkpoint.restore(state, &age)) resume(state);
+ *   ...every frame:
+ *   checkpoint.save(state);
+ */
+
+#pragma once
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include "metrics.h"
+
+/// Marks an initialized segment
+#define CHECKPOINT_MAGIC 0x6b706863u
+
+/* ********************************************************************************************* */
+template <class T>
+class Checkpoint {
+public:
+
+	/// Maps the segment of the name ("/name"), creating it if needed; without it (no /dev/shm)
+	/// saves do nothing and restores find nothing, with a message once
+	Checkpoint (const char* name, uint32_t layout = 1) : name(name), layout(layout), segment(NULL), fd(-1),
+			writer(false), refusedAt(-INFINITY) {
+		static_assert(std::is_trivially_copyable <T>::value, "A checkpoint state is copied as bytes");
+		fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+		if(fd < 0 || ftruncate(fd, sizeof(Segment)) != 0) {
+			fprintf(stderr, "[checkpoint] Couldn't open %s: %s\n", name, strerror(errno));
+			if(fd >= 0) close(fd), fd = -1;
+			return;
+		}
+		void* memory = mmap(NULL, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if(memory == MAP_FAILED) fprintf(stderr, "[checkpoint] Couldn't map %s: %s\n", name, strerror(errno));
+		else segment = (Segment*) memory;
+	}
+
+	/// Unmaps the segment and gives up the writer lock
+	~Checkpoint () {
+		if(segment != NULL) munmap(segment, sizeof(Segment));
+		if(fd >= 0) close(fd);
+	}
+
+	/// Copies the last saved state; false if there is none of this layout. 'age' is set to the time
+	/// since it was saved (s, the monotonic clock so only within one boot).
+	bool restore (T& state, double* age = NULL) const {
+		if(segment == NULL) return false;
+		for(size_t attempt = 0; attempt < 1000; attempt++) {
+			uint64_t before = segment->sequence.load(std::memory_order_acquire);
+			if(before & 1) continue;
+			if(segment->magic != CHECKPOINT_MAGIC || segment->size != sizeof(T) || segment->layout != layout) return false;
+			memcpy(&state, (const void*) &segment->state, sizeof(T));
+			double savedAt = segment->savedAt;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(segment->sequence.load(std::memory_order_relaxed) != before) continue;
+			if(age != NULL) *age = metricsNow() - savedAt;
+			return true;
+		}
+		return false;
+	}
+
+	/// Saves the state; false if another instance writes the segment, which is said once and tried
+	/// again every second
+	inline bool save (const T& state) {
+		if(segment == NULL || (!writer && !lock())) return false;
+		uint64_t sequence = segment->sequence.load(std::memory_order_relaxed) & ~(uint64_t) 1;
+		segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		memcpy((void*) &segment->state, &state, sizeof(T));
+		segment->savedAt = metricsNow();
+		segment->magic = CHECKPOINT_MAGIC, segment->size = sizeof(T), segment->layout = layout;
+		segment->sequence.store(sequence + 2, std::memory_order_release);
+		return true;
+	}
+
+	/// Removes the segment so that the next instance starts cold; this one keeps its mapping
+	void unlink () { shm_unlink(name.c_str()); }
+
+	bool mapped () const { return segment != NULL; }
+	bool writing () const { return writer; }								///< Holds the writer lock
+	uint64_t saves () const { return (segment != NULL) ? segment->sequence.load() / 2 : 0; }	///< Across instances
+
+private:
+
+	/// Takes the writer lock unless it was refused less than a second ago
+	bool lock () {
+		double now = metricsNow();
+		if(now - refusedAt < 1.0) return false;
+		if(flock(fd, LOCK_EX | LOCK_NB) == 0) return (writer = true);
+		if(refusedAt == -INFINITY) fprintf(stderr, "[checkpoint] Another instance writes %s, not saving\n", name.c_str());
+		refusedAt = now;
+		return false;
+	}
+
+	struct Segment {
+		std::atomic <uint64_t> sequence;		///< Odd while a save is written
+		uint32_t magic, layout;
+		uint64_t size;
+		double savedAt;
+		T state;
+	};
+
+	std::string name;
+	uint32_t layout;
+	Segment* segment;
+	int fd;									///< Kept open for the writer lock
+	bool writer;
+	double refusedAt;						///< The last time the lock was refused
+};
@@ -0,0 +1,351 @@
+/**
+ * @file eventLoop.h
+ * @date Oct 18, 2026
+ * @brief A re-entrant replacement for the global somatic_d_t / init() / run() / destroy()
+ * skeleton of the daemons. An EventLoop owns the somatic context and dispatches the callbacks of
+ * any number of channel subscriptions and timers from a single thread, so that several pipelines
+ * can share one process (and one core) without polling.
+ *
+ * ach has no way to wait on several channels at once, so each subscription has a helper thread
+ * that only blocks on its own handle of the channel and wakes the loop through an eventfd. The
+ * loop thread reads the frames itself with a second handle, calls the handlers and releases the
+ * somatic memory region after every cycle. A subscription can also read a transport (see
+ * transport.h) instead of a channel, so that a pipeline runs on an in-process channel without ach. SIGINT/SIGTERM are blocked from the construction of the
+ * loop on (the threads started after it inherit that) and read from a signalfd in the epoll set,
+ * so a termination signal always wakes the loop, which sets somatic_sig_received and returns; so
+ * does stop() through an eventfd, also from another thread.
+ *
+ *   EventLoop loop (options);
+ *   loop.subscribe("liberty", [&](const uint8_t* frame, size_t size, ach_status_t r) { ... });
+ *   loop.every(0.1, [&]() { ... });
+ *   loop.readable(socket, [&]() { ... });
+ *   loop.run();
+ */
+
+#pragma once
+
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <ach.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include "trace.h"
+#include "placement.h"
+#include "transport.h"
+
+/// Frames read from a channel per wake up; the rest wait for the next one, after the timers and
+/// the signals that became ready meanwhile
+#define EVENTLOOP_MAX_FRAMES 64
+
+/// Called with every frame read from a channel (or the latest one in the latest-only mode). The
+/// frame lives in the somatic memory region until the end of the cycle. The result is ACH_OK or
+/// ACH_MISSED_FRAME if frames were overwritten before they could be read.
+typedef std::function <void (const uint8_t* frame, size_t size, ach_status_t result)> FrameHandler;
+
+/// Called every period of a timer
+typedef std::function <void ()> TimerHandler;
+
+/// Called when a file descriptor has data; the handler reads it
+typedef std::function <void ()> ReadableHandler;
+
+/* ********************************************************************************************* */
+class EventLoop {
+public:
+
+	/// Initializes the somatic daemon with the given options
+	EventLoop (somatic_d_opts_t& options) : stopping(false), pinnedNode(-1) {
+		somatic_d_init(&somaticContext, &options);
+		epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+		// The termination signals and stop() wake up the loop
+		sigset_t block;
+		sigemptyset(&block);
+		sigaddset(&block, SIGINT);
+		sigaddset(&block, SIGTERM);
+		pthread_sigmask(SIG_BLOCK, &block, &oldMask);
+		signalFd = signalfd(-1, &block, SFD_NONBLOCK | SFD_CLOEXEC);
+		wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if(epollFd < 0 || signalFd < 0 || wakeFd < 0) {
+			perror("Couldn't create the event loop");
+			exit(EXIT_FAILURE);
+		}
+		readable(signalFd, [this]() {
+			struct signalfd_siginfo info;
+			while(read(signalFd, &info, sizeof(info)) == sizeof(info)) somatic_sig_received = 1;
+		});
+		readable(wakeFd, [this]() {
+			uint64_t count;
+			if(read(wakeFd, &count, sizeof(count)) != sizeof(count)) return;
+		});
+	}
+
+	/// Stops the helper threads, closes the channels and destroys the somatic daemon
+	~EventLoop () {
+		stopping = true;
+		for(size_t i = 0; i < subscriptions.size(); i++) {
+			Subscription* s = subscriptions[i];
+			if(s->waiter.joinable()) s->waiter.join();
+			if(s->reading == NULL) {
+				ach_close(&s->waitChannel);
+				somatic_d_channel_close(&somaticContext, &s->channel);
+			}
+			close(s->fd);
+			delete s;
+		}
+		for(size_t i = 0; i < timers.size(); i++) { close(timers[i]->fd); delete timers[i]; }
+		for(size_t i = 0; i < descriptors.size(); i++) delete descriptors[i];
+		for(size_t i = 0; i < outputs.size(); i++) {
+			somatic_d_channel_close(&somaticContext, outputs[i]);
+			delete outputs[i];
+		}
+		close(epollFd), close(signalFd), close(wakeFd);
+		somatic_d_destroy(&somaticContext);
+		pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+	}
+
+	/// The somatic context, i.e. for its memory region and protobuf allocator
+	somatic_d_t* daemon () { return &somaticContext; }
+
+	/// Calls the handler with the frames of the channel, at most EVENTLOOP_MAX_FRAMES of them each
+	/// time the loop wakes up. In the latest-only mode only the newest frame is handled. Returns the
+	/// handle the loop reads with, i.e. to check how many frames are pending.
+	ach_channel_t* subscribe (const char* name, FrameHandler handler, bool latestOnly = false) {
+
+		Subscription* s = new Subscription();
+		s->name = name, s->handler = handler, s->latestOnly = latestOnly;
+		somatic_d_channel_open(&somaticContext, &s->channel, name, NULL);
+		ach_status_t r = ach_open(&s->waitChannel, name, NULL);
+		if(r != ACH_OK) {
+			fprintf(stderr, "Couldn't open channel %s: %s\n", name, ach_result_to_string(r));
+			exit(EXIT_FAILURE);
+		}
+		start(s);
+		return &s->channel;
+	}
+
+	/// Calls the handler with the frames of a transport as subscribe() does with a channel, i.e. of
+	/// an in-process channel. The loop reads with 'reading' and the helper thread waits with
+	/// 'waiting', a second handle of the same channel; both stay owned by the caller, who has to
+	/// keep them as long as the loop.
+	void subscribe (Transport& reading, Transport& waiting, FrameHandler handler, bool latestOnly = false) {
+		Subscription* s = new Subscription();
+		s->name = "transport", s->handler = handler, s->latestOnly = latestOnly;
+		s->reading = &reading, s->waiting = &waiting;
+		start(s);
+	}
+
+	/// Pins the calling thread, which runs the loop, and the helper threads of the subscriptions
+	/// to the cores of a NUMA node (see placement.h); nothing for a negative node
+	void pin (int node) {
+		if(node < 0) return;
+		pinnedNode = node;
+		pinThread(pthread_self(), node);
+		for(size_t i = 0; i < subscriptions.size(); i++) pinThread(subscriptions[i]->waiter.native_handle(), node);
+	}
+
+	/// Calls the handler every 'period' seconds; missed periods are not made up for
+	void every (double period, TimerHandler handler) {
+		Timer* t = new Timer();
+		t->handler = handler;
+		t->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		struct itimerspec spec;
+		spec.it_interval.tv_sec = (time_t) period;
+		spec.it_interval.tv_nsec = (long) ((period - floor(period)) * 1e9);
+		if(spec.it_interval.tv_sec == 0 && spec.it_interval.tv_nsec == 0) spec.it_interval.tv_nsec = 1;
+		spec.it_value = spec.it_interval;
+		timerfd_settime(t->fd, 0, &spec, NULL);
+		watch(t->fd, t);
+		timers.push_back(t);
+	}
+
+	/// Calls the handler while the file descriptor (i.e. a socket) is readable; it stays open and
+	/// owned by the caller, who has to keep it open as long as the loop
+	void readable (int fd, ReadableHandler handler) {
+		Descriptor* d = new Descriptor();
+		d->handler = handler;
+		watch(fd, d);
+		descriptors.push_back(d);
+	}
+
+	/// Opens a channel to put messages on; closed by the loop
+	ach_channel_t* publish (const char* name) {
+		ach_channel_t* chan = new ach_channel_t;
+		somatic_d_channel_open(&somaticContext, chan, name, NULL);
+		outputs.push_back(chan);
+		return chan;
+	}
+
+	/// Dispatches the callbacks until a termination signal is received or stop() is called
+	void run () {
+
+		somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE,
+				SOMATIC__EVENT__CODES__PROC_RUNNING, NULL, NULL);
+
+		struct epoll_event events [16];
+		while(!somatic_sig_received && !stopping) {
+
+			// Sleep until a channel or a timer is ready; every wake up is a trace cycle
+			TRACE_CYCLE();
+			int n;
+			{
+				TRACE_SCOPE("wait");
+				n = epoll_wait(epollFd, events, 16, -1);
+			}
+			if(n < 0 && errno != EINTR) { perror("epoll_wait"); break; }
+
+			// Handle them and free the buffers allocated during this cycle
+			for(int i = 0; i < n; i++) ((Source*) events[i].data.ptr)->dispatch(this);
+			aa_mem_region_release(&somaticContext.memreg);
+		}
+		stopping = true;
+
+		somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE,
+				SOMATIC__EVENT__CODES__PROC_STOPPING, NULL, NULL);
+	}
+
+	/// Makes run() return after the current cycle; callable from the handlers and other threads
+	void stop () {
+		stopping = true;
+		uint64_t one = 1;
+		if(write(wakeFd, &one, sizeof(one)) != sizeof(one)) perror("eventfd");
+	}
+
+private:
+
+	/// Anything the loop waits on
+	struct Source {
+		int fd;
+		virtual void dispatch (EventLoop* loop) = 0;
+		virtual ~Source () {}
+	};
+
+	/// A channel: 'channel' is read by the loop, 'waitChannel' only by the waiter thread; or a
+	/// transport and its two handles, read into 'buffer'
+	struct Subscription : public Source {
+		std::string name;
+		FrameHandler handler;
+		bool latestOnly;
+		ach_channel_t channel, waitChannel;
+		Transport* reading, * waiting;
+		std::vector <uint8_t> buffer;
+		std::thread waiter;
+
+		Subscription () : reading(NULL), waiting(NULL) {}
+
+		/// Reads the next frame of the transport into the buffer, grown to fit it
+		uint8_t* get (int options, size_t& size, int& r) {
+			if(buffer.empty()) buffer.resize(ACH_DEFAULT_FRAME_SIZE);
+			while((r = reading->get(&buffer[0], buffer.size(), &size, NULL, options)) == ACH_OVERFLOW)
+				buffer.resize(size);
+			return &buffer[0];
+		}
+
+		void dispatch (EventLoop* loop) {
+			uint64_t count;
+			if(read(fd, &count, sizeof(count)) != sizeof(count)) return;
+			somatic_d_t* d = loop->daemon();
+			struct timespec now = {0, 0};
+			for(size_t k = 0; ; k++) {
+
+				// Leave the rest to the next wake up, so that a fast publisher does not starve the loop
+				if(k == EVENTLOOP_MAX_FRAMES) {
+					uint64_t one = 1;
+					if(write(fd, &one, sizeof(one)) != sizeof(one)) perror("eventfd");
+					break;
+				}
+				int r, options = latestOnly ? ACH_O_LAST : 0;
+				size_t size = 0;
+				uint8_t* frame;
+				{
+					TRACE_SCOPE("read");
+					if(reading == NULL) frame = (uint8_t*) somatic_d_get(d, &channel, &size, &now, options, &r);
+					else frame = get(options, size, r);
+				}
+				if(!(r == ACH_OK || r == ACH_MISSED_FRAME) || size == 0) break;
+				handler(frame, size, (ach_status_t) r);
+				if(latestOnly) break;
+			}
+		}
+	};
+
+	/// A periodic timer
+	struct Timer : public Source {
+		TimerHandler handler;
+		void dispatch (EventLoop*) {
+			uint64_t expirations;
+			if(read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) handler();
+		}
+	};
+
+	/// A file descriptor of the caller
+	struct Descriptor : public Source {
+		ReadableHandler handler;
+		void dispatch (EventLoop*) { handler(); }
+	};
+
+	/// Wakes the loop when the subscription has frames, from a helper thread
+	void start (Subscription* s) {
+		s->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		watch(s->fd, s);
+		subscriptions.push_back(s);
+
+		// The waiter inherits the termination signals blocked, they are read by the loop
+		s->waiter = std::thread(&EventLoop::wait, this, s);
+		if(pinnedNode >= 0) pinThread(s->waiter.native_handle(), pinnedNode);
+	}
+
+	/// Adds a file descriptor to the epoll set
+	void watch (int fd, Source* source) {
+		source->fd = fd;
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.ptr = source;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+	}
+
+	/// The waiter thread: blocks until the channel has a new frame and wakes up the loop. The
+	/// timeout only bounds how long the destructor waits for it.
+	void wait (Subscription* s) {
+		std::vector <uint8_t> scratch (ACH_DEFAULT_FRAME_SIZE);
+		while(!stopping && !somatic_sig_received) {
+			size_t size = 0;
+			ach_status_t r;
+			if(s->waiting == NULL) {
+				struct timespec abstimeout = aa_tm_future(aa_tm_sec2timespec(1));
+				r = ach_get(&s->waitChannel, &scratch[0], scratch.size(), &size, &abstimeout, ACH_O_WAIT | ACH_O_LAST);
+			}
+			else {
+				struct timespec abstimeout;
+				clock_gettime(CLOCK_MONOTONIC, &abstimeout);
+				abstimeout.tv_sec++;
+				r = s->waiting->get(&scratch[0], scratch.size(), &size, &abstimeout, ACH_O_WAIT | ACH_O_LAST);
+			}
+			if(r == ACH_OVERFLOW) { scratch.resize(size); continue; }
+			if(r == ACH_OK || r == ACH_MISSED_FRAME) {
+				uint64_t one = 1;
+				if(write(s->fd, &one, sizeof(one)) != sizeof(one)) perror("eventfd");
+			}
+		}
+	}
+
+	somatic_d_t somaticContext;
+	int epollFd, signalFd, wakeFd;
+	sigset_t oldMask;						///< Of the constructing thread, restored by the destructor
+	std::atomic <bool> stopping;
+	int pinnedNode;
+	std::vector <Subscription*> subscriptions;
+	std::vector <Timer*> timers;
+	std::vector <Descriptor*> descriptors;
+	std::vector <ach_channel_t*> outputs;
+};
@@ -0,0 +1,168 @@
+/**
+ * @file lazyGraph.h
+ * @date Oct 18, 2026
+ * @brief A demand-driven dataflow graph for the work of a loop cycle. Each node is a step (decode,
+ * correct, a pose, an angle, a filter) that reads the values of its inputs, which were added
+ * before it, and writes its own; the values live with the owner of the graph, which the compute
+ * functions capture. Nothing is computed when a frame starts: the subscribers of the outputs are
+ * called by run() after the nodes they depend on were pulled, and a node is computed at most once
+ * per frame (memoized) however many nodes read it. A branch without subscribers costs nothing, so
+ * adding a derived quantity does not slow down the consumers of the others.
+ *
+ * A node that keeps state from frame to frame (a filter) can be added with everyFrame, so that it
+ * is computed at the start of every frame while something downstream is subscribed and not only
+ * when run() is called. A node that fails (a malformed frame) fails the nodes that read it.
+ *
+ *   LazyGraph graph;
+ *   size_t decode = graph.add("decode", [&]() { return unpack(message, readings); });
+ *   size_t angle = graph.add("angle", [&]() { angle = palmAngle(readings[0]); return true; }, {decode});
+ *   graph.subscribe(angle, [&]() { printf("%f\n", angle); });
+ *   ...every frame:
+ *   graph.next();
+ *   graph.run();
+ */
+
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "trace.h"
+
+/// The most nodes of a graph and inputs of a node
+#define LAZY_MAX_NODES 64
+#define LAZY_MAX_INPUTS 4
+
+/* ********************************************************************************************* */
+class LazyGraph {
+public:
+
+	/// Computes the value of a node from those of its inputs; false if it could not
+	typedef std::function <bool ()> Compute;
+
+	/// Called with the values of the subscribed node
+	typedef std::function <void ()> Sink;
+
+	LazyGraph () : numNodes(0), frame(1), walk(0) {}
+
+	/// Adds a node computed from the given inputs, which must have been added before; the name must
+	/// be a string literal (it marks the node in the trace). Returns its handle.
+	size_t add (const char* name, Compute compute, std::initializer_list <size_t> inputs = {},
+			bool everyFrame = false) {
+		if(numNodes == LAZY_MAX_NODES || inputs.size() > LAZY_MAX_INPUTS) {
+			fprintf(stderr, "Too many nodes or inputs for the node %s\n", name);
+			exit(EXIT_FAILURE);
+		}
+		Node& node = nodes[numNodes];
+		node.name = name, node.compute = compute, node.numInputs = 0, node.everyFrame = everyFrame;
+		node.frame = 0, node.ok = false, node.demand = 0, node.walk = 0, node.evaluations = 0;
+		for(size_t input : inputs) {
+			if(input >= numNodes) {
+				fprintf(stderr, "The input %zu of the node %s was not added before it\n", input, name);
+				exit(EXIT_FAILURE);
+			}
+			node.inputs[node.numInputs++] = input;
+		}
+		return numNodes++;
+	}
+
+	/// Calls the sink in every run() with the value of the node; returns the handle to unsubscribe
+	size_t subscribe (size_t id, Sink sink) {
+		Subscription subscription = {id, sink, true};
+		subscriptions.push_back(subscription);
+		mark(id, 1);
+		return subscriptions.size() - 1;
+	}
+
+	/// Stops calling a sink; what only it needed is not computed anymore
+	void unsubscribe (size_t handle) {
+		Subscription& subscription = subscriptions[handle];
+		if(!subscription.active) return;
+		subscription.active = false;
+		mark(subscription.node, -1);
+	}
+
+	/// Starts a new frame, which outdates every value, and computes the subscribed everyFrame nodes
+	inline void next () {
+		frame++;
+		for(size_t i = 0; i < numNodes; i++) if(nodes[i].everyFrame && nodes[i].demand > 0) get(i);
+	}
+
+	/// Starts a new frame in which the owner set the values of the given nodes itself, e.g. from a
+	/// checkpoint; they are not computed in it and nothing else is computed yet
+	void provide (const std::vector <size_t>& provided) {
+		frame++;
+		for(size_t id : provided) nodes[id].frame = frame, nodes[id].ok = true;
+	}
+
+	/// Computes the node and its inputs unless they were in this frame; false if one failed
+	bool get (size_t id) {
+		Node& node = nodes[id];
+		if(node.frame == frame) return node.ok;
+		node.frame = frame, node.ok = false;
+		for(size_t i = 0; i < node.numInputs; i++) if(!get(node.inputs[i])) return false;
+		TRACE_SCOPE(node.name);
+		node.ok = node.compute();
+		node.evaluations++;
+		return node.ok;
+	}
+
+	/// Calls the sinks whose node could be computed, in the order they subscribed; returns how many
+	size_t run () {
+		size_t called = 0;
+		for(size_t i = 0; i < subscriptions.size(); i++) {
+			Subscription& subscription = subscriptions[i];
+			if(!subscription.active || !get(subscription.node)) continue;
+			subscription.sink();
+			called++;
+		}
+		return called;
+	}
+
+	/// True if a subscriber needs the node
+	bool demanded (size_t id) const { return nodes[id].demand > 0; }
+	uint64_t evaluations (size_t id) const { return nodes[id].evaluations; }	///< Times it was computed
+	const char* name (size_t id) const { return nodes[id].name; }
+	size_t size () const { return numNodes; }
+
+private:
+
+	/// Adds to the demand of the node and, once each, of what it depends on
+	void mark (size_t id, int delta) {
+		walk++;
+		std::vector <size_t> stack (1, id);
+		while(!stack.empty()) {
+			Node& node = nodes[stack.back()];
+			stack.pop_back();
+			if(node.walk == walk) continue;
+			node.walk = walk, node.demand += delta;
+			for(size_t i = 0; i < node.numInputs; i++) stack.push_back(node.inputs[i]);
+		}
+	}
+
+	struct Node {
+		const char* name;
+		Compute compute;
+		size_t inputs [LAZY_MAX_INPUTS];
+		size_t numInputs;
+		bool everyFrame, ok;				///< ok is the result of the computation in 'frame'
+		uint64_t frame, walk;
+		int demand;							///< Subscriptions that need the node
+		uint64_t evaluations;
+	};
+
+	struct Subscription {
+		size_t node;
+		Sink sink;
+		bool active;
+	};
+
+	Node nodes [LAZY_MAX_NODES];
+	size_t numNodes;
+	uint64_t frame, walk;
+	std::vector <Subscription> subscriptions;
+};
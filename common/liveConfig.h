@@ -0,0 +1,260 @@
+/**
+ * @file liveConfig.h
+ * @date Oct 18, 2026
+ * @brief Runtime parameters that can be changed while a loop runs, without restarting it and
+ * without locks or allocation on the loop. The parameters are an immutable snapshot behind an
+ * atomic pointer (read-copy-update): a writer copies the current snapshot, changes the copy and
+ * swaps it in, and the old one is deleted once every reader has moved past it. A reader moves
+ * past a snapshot by asking for the current one again, i.e. at the start of its next cycle, so a
+ * change applies within a cycle. A ConfigWatcher thread does the writing from a file of
+ * "key = value" lines which it polls for changes.
+ *
+ *   LiveConfig <Params> config (Params());
+ *   ConfigWatcher <Params> watcher (config, "teleop.conf", parseParam, validParams);
+ *   LiveConfig <Params>::Reader reader (config);
+ *   while(...) { const Params& params = *reader.get(); ... }
+ *
+ * The daemons take the file from the FINGERS_CONFIG environment variable; without one (NULL) the
+ * watcher does nothing, so that it can always be a local of main and its thread joined.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <ctype.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/// The number of reader threads of a config
+#define LIVE_CONFIG_MAX_READERS 16
+
+/// A reader that holds no snapshot
+#define LIVE_CONFIG_IDLE UINT64_MAX
+
+/* ********************************************************************************************* */
+template <class T>
+class LiveConfig {
+public:
+
+	/// A reading thread's view of the config; not shared between threads
+	class Reader {
+	public:
+
+		Reader (LiveConfig& config) : config(config), seenVersion(0) {
+			slot = config.numReaders.fetch_add(1);
+			if(slot >= LIVE_CONFIG_MAX_READERS) {
+				fprintf(stderr, "More than %d readers of a config\n", LIVE_CONFIG_MAX_READERS);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		/// Hot path: returns the current snapshot, which stays valid until the next get() (or
+		/// release()) of this reader. Two atomic loads and a store.
+		inline const T* get () {
+			seenVersion = config.generation.load();
+			config.seen[slot].store(seenVersion);
+			return config.current.load();
+		}
+
+		/// Holds no snapshot until the next get(), so that an idle reader does not keep old ones
+		inline void release () { config.seen[slot].store(LIVE_CONFIG_IDLE); }
+
+		/// The version at the last get(): the snapshot is this one or newer, and a later change is
+		/// always seen as a higher version, so a reader can apply the parameters only when it rises
+		/// (comparing the pointers could be fooled by a new snapshot at a freed address)
+		inline uint64_t version () const { return seenVersion; }
+
+	private:
+		LiveConfig& config;
+		size_t slot;
+		uint64_t seenVersion;
+	};
+
+	LiveConfig (const T& initial) : current(new T(initial)), generation(0), numReaders(0) {
+		for(size_t i = 0; i < LIVE_CONFIG_MAX_READERS; i++) seen[i].store(LIVE_CONFIG_IDLE);
+	}
+
+	/// Must outlive the readers and the watchers
+	~LiveConfig () {
+		delete current.load();
+		for(size_t i = 0; i < retired.size(); i++) delete retired[i].second;
+	}
+
+	/// Returns a copy of the current snapshot to change and publish
+	T copy () {
+		std::lock_guard <std::mutex> lock (writeMutex);
+		return *current.load();
+	}
+
+	/// Swaps in a new snapshot and deletes the old ones that no reader holds anymore
+	void publish (const T& next) {
+		std::lock_guard <std::mutex> lock (writeMutex);
+		const T* old = current.exchange(new T(next));
+		retired.push_back(std::make_pair(++generation, old));
+		reclaim();
+	}
+
+	/// Deletes the retired snapshots that every reader has moved past; called by publish() and
+	/// periodically by the watchers
+	void collect () {
+		std::lock_guard <std::mutex> lock (writeMutex);
+		reclaim();
+	}
+
+	/// The number of snapshots published so far
+	uint64_t version () const { return generation.load(); }
+
+private:
+
+	/// A snapshot retired at generation g is free once every reader has seen g: they loaded the
+	/// generation after the swap and so the new pointer
+	void reclaim () {
+		uint64_t oldest = LIVE_CONFIG_IDLE;
+		size_t n = std::min(numReaders.load(), (size_t) LIVE_CONFIG_MAX_READERS);
+		for(size_t i = 0; i < n; i++) oldest = std::min(oldest, seen[i].load());
+		size_t kept = 0;
+		for(size_t i = 0; i < retired.size(); i++) {
+			if(retired[i].first <= oldest) delete retired[i].second;
+			else retired[kept++] = retired[i];
+		}
+		retired.resize(kept);
+	}
+
+	std::atomic <const T*> current;
+	std::atomic <uint64_t> generation;
+	std::atomic <size_t> numReaders;
+	std::atomic <uint64_t> seen [LIVE_CONFIG_MAX_READERS];	///< The generation each reader last saw
+	std::mutex writeMutex;
+	std::vector <std::pair <uint64_t, const T*> > retired;	///< Snapshots readers may still hold
+};
+
+/* ********************************************************************************************* */
+/// Polls a file of "key = value" lines ('#' starts a comment) and publishes the parameters read
+/// from it whenever it changes. Keys that are not in the file keep their current values; a file
+/// with an unknown key or a bad value, or whose parameters are not valid together, is reported
+/// and not applied.
+template <class T>
+class ConfigWatcher {
+public:
+
+	/// Sets a parameter from its key and value; false if the key or the value is bad
+	typedef std::function <bool (const char* key, const char* value, T& params)> Parser;
+
+	/// Checks the parameters of a whole file, i.e. the ones that depend on each other
+	typedef std::function <bool (const T& params)> Validator;
+
+	/// Loads the file and starts the watcher thread, which checks it every 'period' seconds;
+	/// nothing without a file (NULL)
+	ConfigWatcher (LiveConfig <T>& config, const char* path, Parser parser, Validator validator = Validator(),
+			double period = 0.2) : config(config), path(path ? path : ""), parser(parser), validator(validator),
+			period(period), modified(0), stopping(false) {
+		if(path == NULL) return;
+		load();
+
+		// Start with the termination signals blocked so they reach the main thread
+		sigset_t block, old;
+		sigemptyset(&block);
+		sigaddset(&block, SIGINT);
+		sigaddset(&block, SIGTERM);
+		pthread_sigmask(SIG_BLOCK, &block, &old);
+		thread = std::thread(&ConfigWatcher::watch, this);
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+	}
+
+	~ConfigWatcher () {
+		stopping = true;
+		if(thread.joinable()) thread.join();
+	}
+
+	/// Reads the file and publishes it if it parses; false otherwise
+	bool load () {
+		FILE* file = fopen(path.c_str(), "r");
+		if(file == NULL) {
+			fprintf(stderr, "[config] couldn't open %s\n", path.c_str());
+			return false;
+		}
+		T next = config.copy();
+		char line [256];
+		size_t numLine = 0, numErrors = 0;
+		while(fgets(line, sizeof(line), file) != NULL) {
+			numLine++;
+			char* comment = strchr(line, '#');
+			if(comment != NULL) *comment = '\0';
+			char* equals = strchr(line, '=');
+			char* key = trim(line, equals);
+			if(*key == '\0' && equals == NULL) continue;
+			char* value = (equals == NULL) ? NULL : trim(equals + 1, NULL);
+			if(value == NULL || *value == '\0' || !parser(key, value, next)) {
+				fprintf(stderr, "[config] %s:%zu: bad line '%s'\n", path.c_str(), numLine, key);
+				numErrors++;
+			}
+		}
+		fclose(file);
+		if(numErrors == 0 && validator && !validator(next)) {
+			fprintf(stderr, "[config] %s: the parameters are not valid together\n", path.c_str());
+			numErrors++;
+		}
+		if(numErrors > 0) {
+			fprintf(stderr, "[config] %s not applied\n", path.c_str());
+			return false;
+		}
+		config.publish(next);
+		fprintf(stderr, "[config] %s applied, version %lu\n", path.c_str(), (unsigned long) config.version());
+		return true;
+	}
+
+private:
+
+	/// Strips the spaces around the text up to the end (or the string end if NULL)
+	static char* trim (char* text, char* end) {
+		if(end == NULL) end = text + strlen(text);
+		*end = '\0';
+		while(end > text && isspace(end[-1])) *--end = '\0';
+		while(isspace(*text)) text++;
+		return text;
+	}
+
+	/// The modification time of the file in nanoseconds, 0 if it does not exist
+	int64_t modificationTime () const {
+		struct stat info;
+		if(stat(path.c_str(), &info) != 0) return 0;
+		return info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+	}
+
+	/// Reloads the file when its modification time changes (also when an editor replaces it)
+	void watch () {
+		modified = modificationTime();
+		useconds_t sleep = (useconds_t) (period * 1e6);
+		while(!stopping) {
+			usleep(sleep);
+			int64_t time = modificationTime();
+			if(time != 0 && time != modified) {
+				modified = time;
+				load();
+			}
+			config.collect();
+		}
+	}
+
+	LiveConfig <T>& config;
+	std::string path;
+	Parser parser;
+	Validator validator;
+	double period;
+	int64_t modified;
+	std::atomic <bool> stopping;
+	std::thread thread;
+};
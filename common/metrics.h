@@ -0,0 +1,324 @@
+/**
+ * @file metrics.h
+ * @date Oct 18, 2026
+ * @brief Lightweight runtime statistics for the somatic daemons. Counters, gauges and latency
+ * histograms are updated from the real-time loops with relaxed atomics on per-thread slots and
+ * only summed up by a separate exporter thread which serves them in the Prometheus text format
+ * over a unix-domain socket or a local tcp port.
+ *
+ * Usage: declare the metrics as globals, update them in the loop and call metricsServe() once
+ * from main, i.e. with the METRICS_ENDPOINT environment variable which is either
+ * "unix:/tmp/server.prom" or a tcp port such as "9101". Scrape with
+ * "curl --unix-socket /tmp/server.prom http://x/metrics" or "curl localhost:9101/metrics".
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/// Number of per-thread slots in each metric; threads beyond this share slots (still correct)
+#define METRICS_MAX_THREADS 16
+
+/// Upper bounds (in seconds) of the latency histogram buckets, the last one is +Inf
+static const double metricsBuckets [] = {1e-6, 2e-6, 5e-6, 1e-5, 2e-5, 5e-5, 1e-4, 2e-4, 5e-4,
+	1e-3, 2e-3, 5e-3, 1e-2, 2e-2, 5e-2, 1e-1, 2e-1, 5e-1, 1.0};
+#define METRICS_NUM_BUCKETS (sizeof(metricsBuckets) / sizeof(double) + 1)
+
+/* ********************************************************************************************* */
+/// Returns the CLOCK_MONOTONIC time in seconds
+inline double metricsNow() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* ********************************************************************************************* */
+/// Returns the slot of the calling thread, assigned the first time the thread touches a metric
+inline size_t metricsThreadSlot() {
+	static std::atomic <size_t> nextSlot (0);
+	static thread_local size_t slot = nextSlot.fetch_add(1) % METRICS_MAX_THREADS;
+	return slot;
+}
+
+/* ********************************************************************************************* */
+/// The base of all the metrics which registers itself to the global list for the exporter
+class Metric {
+public:
+	enum Type { COUNTER, GAUGE, HISTOGRAM };
+
+	/// The name should follow the prometheus conventions; labels are i.e. 'channel="liberty"'
+	Metric (Type type, const char* name, const char* help, const char* labels) :
+			type(type), name(name), help(help), labels(labels ? labels : "") {
+		std::lock_guard <std::mutex> lock (registryMutex());
+		registry().push_back(this);
+	}
+
+	virtual ~Metric () {
+		std::lock_guard <std::mutex> lock (registryMutex());
+		std::vector <Metric*>& all = registry();
+		for(size_t i = 0; i < all.size(); i++) if(all[i] == this) { all.erase(all.begin() + i); break; }
+	}
+
+	/// Appends the prometheus text representation of the metric
+	virtual void format (std::string& out) = 0;
+
+	/// Replaces the labels, i.e. with the channel a daemon was told to read after parsing its arguments
+	void relabel (const char* newLabels) {
+		std::lock_guard <std::mutex> lock (registryMutex());
+		labels = newLabels;
+	}
+
+	static std::vector <Metric*>& registry () { static std::vector <Metric*> all; return all; }
+	static std::mutex& registryMutex () { static std::mutex m; return m; }
+
+	const Type type;
+	const std::string name, help;
+	std::string labels;						///< Changed under the registry lock, which the exporter holds
+
+protected:
+
+	/// Writes '# HELP' and '# TYPE' lines for the given suffix and prometheus type
+	void header (std::string& out, const char* suffix, const char* promType) {
+		out += "# HELP " + name + suffix + " " + help + "\n";
+		out += "# TYPE " + name + suffix + " " + promType + "\n";
+	}
+
+	/// Writes a single sample line, 'extra' is an additional label such as le="0.001"
+	void sample (std::string& out, const char* suffix, const std::string& extra, double value) {
+		char buf [64];
+		snprintf(buf, sizeof(buf), " %.9g\n", value);
+		std::string all = labels;
+		if(!extra.empty()) all += (all.empty() ? "" : ",") + extra;
+		out += name + suffix + (all.empty() ? "" : "{" + all + "}") + buf;
+	}
+};
+
+/// A per-thread slot padded to a cache line so that threads never share lines
+struct alignas(64) MetricSlot {
+	std::atomic <uint64_t> value;
+	MetricSlot () : value(0) {}
+};
+
+/* ********************************************************************************************* */
+/// A monotonically increasing count, i.e. messages or missed frames. The exporter also reports
+/// the rate over the last second as <name>_per_second.
+class MetricCounter : public Metric {
+public:
+	MetricCounter (const char* name, const char* help, const char* labels = NULL) :
+		Metric(COUNTER, name, help, labels), lastTotal(0), lastTime(metricsNow()), rate(0.0) {}
+
+	/// Hot path: a single uncontended relaxed add on the thread's own cache line
+	inline void add (uint64_t n = 1) {
+		slots[metricsThreadSlot()].value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	uint64_t total () const {
+		uint64_t sum = 0;
+		for(size_t i = 0; i < METRICS_MAX_THREADS; i++) sum += slots[i].value.load(std::memory_order_relaxed);
+		return sum;
+	}
+
+	/// Called by the exporter thread; updates the rate once at least a second has passed
+	void tick (double now) {
+		if(now - lastTime < 1.0) return;
+		uint64_t t = total();
+		rate = (t - lastTotal) / (now - lastTime);
+		lastTotal = t, lastTime = now;
+	}
+
+	void format (std::string& out) {
+		header(out, "_total", "counter");
+		sample(out, "_total", "", total());
+		header(out, "_per_second", "gauge");
+		sample(out, "_per_second", "", rate);
+	}
+
+private:
+	MetricSlot slots [METRICS_MAX_THREADS];
+	uint64_t lastTotal;
+	double lastTime, rate;
+};
+
+/* ********************************************************************************************* */
+/// A value that is overwritten, i.e. the queue depth. Last writer wins.
+class MetricGauge : public Metric {
+public:
+	MetricGauge (const char* name, const char* help, const char* labels = NULL) :
+		Metric(GAUGE, name, help, labels), value(0.0) {}
+
+	inline void set (double v) { value.store(v, std::memory_order_relaxed); }
+	double get () const { return value.load(std::memory_order_relaxed); }
+
+	void format (std::string& out) {
+		header(out, "", "gauge");
+		sample(out, "", "", get());
+	}
+
+private:
+	std::atomic <double> value;
+};
+
+/* ********************************************************************************************* */
+/// A latency distribution in seconds with fixed buckets from 1us to 1s so that the tail can be
+/// read off with histogram_quantile(). Observations are per-thread bucket increments.
+class MetricHistogram : public Metric {
+public:
+	MetricHistogram (const char* name, const char* help, const char* labels = NULL) :
+		Metric(HISTOGRAM, name, help, labels) {}
+
+	inline void observe (double seconds) {
+		size_t b = 0;
+		while(b < METRICS_NUM_BUCKETS - 1 && seconds > metricsBuckets[b]) b++;
+		Slot& s = slots[metricsThreadSlot()];
+		s.counts[b].fetch_add(1, std::memory_order_relaxed);
+		s.sumNs.fetch_add((uint64_t) (seconds * 1e9), std::memory_order_relaxed);
+	}
+
+	void format (std::string& out) {
+		uint64_t counts [METRICS_NUM_BUCKETS] = {0}, sumNs = 0;
+		for(size_t i = 0; i < METRICS_MAX_THREADS; i++) {
+			for(size_t b = 0; b < METRICS_NUM_BUCKETS; b++)
+				counts[b] += slots[i].counts[b].load(std::memory_order_relaxed);
+			sumNs += slots[i].sumNs.load(std::memory_order_relaxed);
+		}
+		header(out, "", "histogram");
+		uint64_t cumulative = 0;
+		char le [32];
+		for(size_t b = 0; b < METRICS_NUM_BUCKETS; b++) {
+			cumulative += counts[b];
+			if(b < METRICS_NUM_BUCKETS - 1) snprintf(le, sizeof(le), "le=\"%g\"", metricsBuckets[b]);
+			else snprintf(le, sizeof(le), "le=\"+Inf\"");
+			sample(out, "_bucket", le, cumulative);
+		}
+		sample(out, "_sum", "", sumNs * 1e-9);
+		sample(out, "_count", "", cumulative);
+	}
+
+private:
+	struct alignas(64) Slot {
+		std::atomic <uint64_t> counts [METRICS_NUM_BUCKETS];
+		std::atomic <uint64_t> sumNs;
+		Slot () : sumNs(0) { for(size_t b = 0; b < METRICS_NUM_BUCKETS; b++) counts[b] = 0; }
+	};
+	Slot slots [METRICS_MAX_THREADS];
+};
+
+/* ********************************************************************************************* */
+/// Renders all the registered metrics in the prometheus text exposition format
+inline std::string metricsFormat() {
+	std::string out;
+	std::lock_guard <std::mutex> lock (Metric::registryMutex());
+	std::vector <Metric*>& all = Metric::registry();
+	for(size_t i = 0; i < all.size(); i++) all[i]->format(out);
+	return out;
+}
+
+/* ********************************************************************************************* */
+/// Opens the listening socket for "unix:<path>" or "<port>" (bound to 127.0.0.1 only)
+inline int metricsListen(const char* endpoint) {
+
+	int fd = -1;
+	if(strncmp(endpoint, "unix:", 5) == 0) {
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, endpoint + 5, sizeof(addr.sun_path) - 1);
+		unlink(addr.sun_path);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0 || bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) { if(fd >= 0) close(fd); return -1; }
+	}
+	else {
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(atoi(endpoint));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		int on = 1;
+		if(fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+		if(fd < 0 || bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) { if(fd >= 0) close(fd); return -1; }
+	}
+	if(listen(fd, 4) != 0) { close(fd); return -1; }
+	return fd;
+}
+
+/* ********************************************************************************************* */
+/// The exporter loop: updates the counter rates every second and answers scrapes. Nothing here
+/// runs on the real-time threads.
+inline void metricsExporter(int fd) {
+
+	while(true) {
+
+		// Wait for a connection for at most a second
+		struct pollfd p = {fd, POLLIN, 0};
+		int ready = poll(&p, 1, 1000);
+
+		// Update the rates
+		double now = metricsNow();
+		{
+			std::lock_guard <std::mutex> lock (Metric::registryMutex());
+			std::vector <Metric*>& all = Metric::registry();
+			for(size_t i = 0; i < all.size(); i++)
+				if(all[i]->type == Metric::COUNTER) ((MetricCounter*) all[i])->tick(now);
+		}
+		if(ready <= 0) continue;
+
+		// Answer the scrape; the request itself is irrelevant, every path returns the metrics
+		int client = accept(fd, NULL, NULL);
+		if(client < 0) continue;
+		char request [1024];
+		struct pollfd c = {client, POLLIN, 0};
+		if(poll(&c, 1, 100) > 0) (void) !read(client, request, sizeof(request));
+		std::string body = metricsFormat();
+		char head [128];
+		snprintf(head, sizeof(head), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+			"Content-Length: %zu\r\n\r\n", body.size());
+		std::string response = head + body;
+		for(size_t sent = 0; sent < response.size(); ) {
+			ssize_t n = write(client, response.data() + sent, response.size() - sent);
+			if(n <= 0) break;
+			sent += n;
+		}
+		close(client);
+	}
+}
+
+/* ********************************************************************************************* */
+/// Starts the exporter thread on the given endpoint; does nothing if the endpoint is NULL so
+/// that it can be called directly with getenv("METRICS_ENDPOINT").
+inline bool metricsServe(const char* endpoint) {
+	if(endpoint == NULL || *endpoint == '\0') return false;
+	int fd = metricsListen(endpoint);
+	if(fd < 0) {
+		fprintf(stderr, "Couldn't open the metrics endpoint %s: %s\n", endpoint, strerror(errno));
+		return false;
+	}
+
+	// The termination signals are blocked in the exporter so that they reach the daemon's loop
+	sigset_t block, old;
+	sigemptyset(&block);
+	sigaddset(&block, SIGINT);
+	sigaddset(&block, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &block, &old);
+	std::thread(metricsExporter, fd).detach();
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	return true;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file placement.h
+ * @date Oct 18, 2026
+ * @brief NUMA placement of ach channels and daemon threads from a topology file, so that on
+ * multi-socket hosts the frames of a channel live on the node of the cores that put and read
+ * them. The file (PLACEMENT) has a rule per line:
+ *
+ *   channel chan_liberty 0 huge      # the memory of the channel on node 0, in huge pages
+ *   daemon server 0                  # the threads of the daemon on the cores of node 0
+ *
+ * The creator of a channel binds its shared memory segment to the node with mbind (the policy
+ * stays with the segment for the pages allocated later; the pages ach already wrote are first read
+ * into the mapping, as mbind only moves mapped pages, and then moved), and asks for transparent
+ * huge pages if the rule says so; this needs shmem_enabled set to advise or within_size, and the
+ * mapping is kept so that khugepaged can collapse it later if it could not be done at once. A
+ * daemon pins its threads to the cores of its node, or of the node of its channel without a rule
+ * of its own. Without a file, or on a host with a single node, nothing changes. libnuma is not
+ * needed: the system calls are made directly.
+ *
+ *   Placement placement (getenv("PLACEMENT"));
+ *   ach_create(channelName, ...);
+ *   placement.placeChannel(channelName);
+ *   EventLoop loop (options);
+ *   loop.pin(placement.daemonNode(options.ident, channelName));
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+/// The name of the shared memory segment of an ach channel is this prefix and the channel name
+#ifndef PLACEMENT_ACH_PREFIX
+#define PLACEMENT_ACH_PREFIX "/achshm-"
+#endif
+
+/// The largest node number handled
+#define PLACEMENT_MAX_NODES 64
+
+/* ********************************************************************************************* */
+/// The number of NUMA nodes of the host (1 without NUMA support)
+inline int numaNodes () {
+	FILE* file = fopen("/sys/devices/system/node/online", "r");
+	if(file == NULL) return 1;
+	int first = 0, last = 0;
+	int n = fscanf(file, "%d-%d", &first, &last);
+	fclose(file);
+	return (n == 2) ? last + 1 : 1;
+}
+
+/* ********************************************************************************************* */
+/// The cores of a node; false if there is no such node
+inline bool nodeCpus (int node, cpu_set_t& cpus) {
+	CPU_ZERO(&cpus);
+	char path [96];
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+	FILE* file = fopen(path, "r");
+	if(file == NULL) return (node == 0 && sched_getaffinity(0, sizeof(cpus), &cpus) == 0);
+
+	// i.e. "0-7,16-23"
+	int first, last;
+	char separator;
+	while(fscanf(file, "%d", &first) == 1) {
+		last = first;
+		if(fscanf(file, "%c", &separator) == 1 && separator == '-') {
+			if(fscanf(file, "%d", &last) != 1) break;
+			if(fscanf(file, "%c", &separator) != 1) separator = '\n';
+		}
+		for(int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &cpus);
+		if(separator != ',') break;
+	}
+	fclose(file);
+	return CPU_COUNT(&cpus) > 0;
+}
+
+/* ********************************************************************************************* */
+/// Pins a thread to the cores of a node
+inline bool pinThread (pthread_t thread, int node) {
+	cpu_set_t cpus;
+	if(!nodeCpus(node, cpus)) {
+		fprintf(stderr, "[placement] No cores on node %d\n", node);
+		return false;
+	}
+	int r = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+	if(r != 0) fprintf(stderr, "[placement] Couldn't pin a thread to node %d: %s\n", node, strerror(r));
+	return r == 0;
+}
+
+/* ********************************************************************************************* */
+/// Binds memory (page aligned) to a node, moving the pages of it this process has mapped, and asks
+/// for huge pages if 'huge'; false if the binding failed. A huge page request that cannot be met
+/// only warns.
+inline bool bindMemory (void* address, size_t length, int node, bool huge) {
+	if(node < 0 || node >= PLACEMENT_MAX_NODES) return false;
+	unsigned long mask [PLACEMENT_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+	mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+	if(syscall(SYS_mbind, address, length, MPOL_BIND, mask, PLACEMENT_MAX_NODES + 1, MPOL_MF_MOVE) != 0) {
+		fprintf(stderr, "[placement] Couldn't bind memory to node %d: %s\n", node, strerror(errno));
+		return false;
+	}
+	if(!huge) return true;
+
+	// Collapsed at once where the kernel can, otherwise marked for khugepaged
+	char mode [128] = "";
+	FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/shmem_enabled", "r");
+	if(file != NULL) {
+		if(fgets(mode, sizeof(mode), file) == NULL) mode[0] = '\0';
+		fclose(file);
+	}
+	if(strstr(mode, "[never]") != NULL || strstr(mode, "[deny]") != NULL)
+		fprintf(stderr, "[placement] No huge pages for shared memory, shmem_enabled is %s", mode);
+#ifdef MADV_COLLAPSE
+	else if(madvise(address, length, MADV_COLLAPSE) == 0) return true;
+#endif
+	if(madvise(address, length, MADV_HUGEPAGE) != 0) fprintf(stderr, "[placement] No huge pages: %s\n", strerror(errno));
+	return true;
+}
+
+/* ********************************************************************************************* */
+/// The node of the page of an address, faulting it in; -1 if unknown
+inline int memoryNode (void* address) {
+	int node = -1;
+	if(syscall(SYS_get_mempolicy, &node, NULL, 0, address, MPOL_F_NODE | MPOL_F_ADDR) != 0) return -1;
+	return node;
+}
+
+/* ********************************************************************************************* */
+/// The rules of a topology file and the channel mappings kept for the huge pages
+class Placement {
+public:
+
+	/// Reads the rules of the file; without one (NULL) nothing is placed. Exits on a malformed rule.
+	Placement (const char* path = NULL) {
+		if(path == NULL) return;
+		FILE* file = fopen(path, "r");
+		if(file == NULL) {
+			fprintf(stderr, "[placement] Couldn't open %s: %s\n", path, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		char line [256], kind [32], name [128], option [32];
+		for(size_t number = 1; fgets(line, sizeof(line), file) != NULL; number++) {
+			char* comment = strchr(line, '#');
+			if(comment != NULL) *comment = '\0';
+			Rule rule;
+			option[0] = '\0';
+			int n = sscanf(line, "%31s %127s %d %31s", kind, name, &rule.node, option);
+			if(n <= 0) continue;
+			rule.channel = (strcmp(kind, "channel") == 0), rule.huge = (strcmp(option, "huge") == 0);
+			if(n < 3 || (!rule.channel && strcmp(kind, "daemon") != 0) || rule.node < 0 ||
+					rule.node >= PLACEMENT_MAX_NODES || (n == 4 && !(rule.channel && rule.huge))) {
+				fprintf(stderr, "[placement] %s:%zu: expected 'channel <name> <node> [huge]' or "
+					"'daemon <ident> <node>'\n", path, number);
+				exit(EXIT_FAILURE);
+			}
+			add(rule.channel, name, rule.node, rule.huge);
+		}
+		fclose(file);
+	}
+
+	/// Adds a rule for a channel or a daemon, i.e. one that is not in the file
+	void add (bool channel, const char* name, int node, bool huge = false) {
+		Rule rule;
+		rule.channel = channel, rule.name = name, rule.node = node, rule.huge = huge;
+		rules.push_back(rule);
+	}
+
+	~Placement () { for(size_t i = 0; i < mappings.size(); i++) munmap(mappings[i].first, mappings[i].second); }
+
+	/// The node of a channel or a daemon; -1 without a rule
+	int channelNode (const char* name) const { const Rule* r = find(true, name); return r ? r->node : -1; }
+	int daemonNode (const char* ident, const char* channel = NULL) const {
+		const Rule* r = find(false, ident);
+		return r ? r->node : (channel != NULL) ? channelNode(channel) : -1;
+	}
+
+	/// Binds the memory of an ach channel this process created to the node of its rule, if any;
+	/// false if that failed
+	bool placeChannel (const char* name) {
+		const Rule* rule = find(true, name);
+		if(rule == NULL) return true;
+		std::string segment = std::string(PLACEMENT_ACH_PREFIX) + name;
+		int fd = shm_open(segment.c_str(), O_RDWR, 0);
+		struct stat status;
+		if(fd < 0 || fstat(fd, &status) != 0) {
+			fprintf(stderr, "[placement] Couldn't open the memory of %s: %s\n", name, strerror(errno));
+			if(fd >= 0) close(fd);
+			return false;
+		}
+		void* memory = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if(memory == MAP_FAILED) {
+			fprintf(stderr, "[placement] Couldn't map the memory of %s: %s\n", name, strerror(errno));
+			return false;
+		}
+
+		// Read every page so that the ones ach wrote are in the mapping and get moved
+		const volatile uint8_t* bytes = (const volatile uint8_t*) memory;
+		for(off_t at = 0; at < status.st_size; at += sysconf(_SC_PAGESIZE)) (void) bytes[at];
+		bool ok = bindMemory(memory, status.st_size, rule->node, rule->huge);
+		if(rule->huge) mappings.push_back(std::make_pair(memory, (size_t) status.st_size));
+		else munmap(memory, status.st_size);
+		return ok;
+	}
+
+	size_t size () const { return rules.size(); }
+
+private:
+
+	struct Rule {
+		bool channel, huge;
+		std::string name;
+		int node;
+	};
+
+	const Rule* find (bool channel, const char* name) const {
+		for(size_t i = 0; i < rules.size(); i++)
+			if(rules[i].channel == channel && rules[i].name == name) return &rules[i];
+		return NULL;
+	}
+
+	std::vector <Rule> rules;
+	std::vector <std::pair <void*, size_t> > mappings;
+};
@@ -0,0 +1,168 @@
+/**
+ * @file shedder.h
+ * @date Oct 18, 2026
+ * @brief Load shedding for the outputs of a serial loop. Each output (sending the robot command,
+ * logging, the console display) is registered with a priority tier and a cost budget, and runs
+ * through the shedder, which measures the busy share of the loop thread. When the share goes over
+ * the budget the lower tiers are decimated and then dropped one step per window, best effort
+ * first and critical never, so that the control path keeps its rate when the host is busy; they
+ * come back step by step once the load drops under half the budget. Within a cycle, an output
+ * that would not finish within the period is skipped too. What was shed is counted per
+ * output and exported with the metrics (as gauges, updated every window).
+ *
+ *   LoadShedder shedder ("server", 1.0 / 240);
+ *   size_t display = shedder.add("display", SHED_BEST_EFFORT, 2e-4);
+ *   ...every frame:
+ *   shedder.begin();
+ *   command();														// critical work may run directly
+ *   shedder.run(display, [&]() { print(); });
+ *   shedder.end();
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "metrics.h"
+
+/// The most outputs of a shedder
+#define SHED_MAX_TASKS 16
+
+/// The decimation steps of a tier before it is dropped: 1 in 2, 4 and 8
+#define SHED_STEPS 4
+
+/// The tiers, in the order they are kept
+enum ShedPriority {
+	SHED_CRITICAL = 0,		///< Never shed
+	SHED_NORMAL,
+	SHED_BEST_EFFORT
+};
+
+/* ********************************************************************************************* */
+class LoadShedder {
+public:
+
+	/// The period of the loop's cycles (s) and the share of the thread they may keep busy; the
+	/// load is measured over windows of 'window' periods
+	LoadShedder (const char* prefix, double period, double budget = 0.8, size_t window = 24) :
+			prefix(prefix), period(period), budget(budget), window(window * period), numTasks(0), shedLevel(0), lateCycles(0),
+			cycleStart(0.0), windowStart(metricsNow()), busy(0.0), utilization(0.0), cycles(0),
+			levelMetric((this->prefix + "_shed_level").c_str(), "Shedding step: 0 runs everything, 4 drops the "
+				"best effort outputs and 8 the normal ones"),
+			utilizationMetric((this->prefix + "_utilization").c_str(), "Busy share of the loop thread") {}
+
+	~LoadShedder () {
+		for(size_t i = 0; i < numTasks; i++) delete tasks[i].shedMetric;
+	}
+
+	/// Registers an output with the time (s) it is expected to take, used until it was measured;
+	/// returns its handle
+	size_t add (const char* name, ShedPriority priority, double cost) {
+		if(numTasks == SHED_MAX_TASKS) {
+			fprintf(stderr, "More than %d outputs in the shedder %s\n", SHED_MAX_TASKS, prefix.c_str());
+			exit(EXIT_FAILURE);
+		}
+		Task& task = tasks[numTasks];
+		task.name = name, task.priority = priority, task.budget = cost, task.cost = cost;
+		task.runs = task.shed = task.overruns = 0;
+		std::string metric = prefix + "_shed_" + name, help = std::string("Times the ") + name + " output was shed";
+		task.shedMetric = new MetricGauge(metric.c_str(), help.c_str());
+		return numTasks++;
+	}
+
+	/// Starts a cycle
+	inline void begin () { cycleStart = metricsNow(); }
+
+	/// Runs the output unless its tier is shed in this cycle or it would not finish within the period;
+	/// returns true if it ran
+	template <class Function>
+	inline bool run (size_t id, Function function) {
+		Task& task = tasks[id];
+		double start = metricsNow();
+		if(task.priority != SHED_CRITICAL) {
+			size_t step = tierStep(task.priority);
+			bool decimated = (step >= SHED_STEPS) || ((cycles & ((1u << step) - 1)) != 0);
+			bool late = (start - cycleStart + task.cost > period);
+			if(decimated || late) {
+				if(late) task.cost += 0.1 * (task.budget - task.cost);		// so that it is tried again
+				task.shed++;
+				return false;
+			}
+		}
+		function();
+		double cost = metricsNow() - start;
+		task.cost += 0.1 * (cost - task.cost);
+		if(cost > task.budget) task.overruns++;
+		task.runs++;
+		return true;
+	}
+
+	/// Ends the cycle. Three cycles in a row longer than the period shed a step at once; otherwise
+	/// the busy share over the window sheds a step or, if the share with the step restored would
+	/// still be within the budget, restores one.
+	inline void end () {
+		double now = metricsNow();
+		busy += now - cycleStart;
+		cycles++;
+		lateCycles = (now - cycleStart > period) ? lateCycles + 1 : 0;
+		if(lateCycles < 3 && now - windowStart < window) return;
+		utilization = busy / std::max(now - windowStart, period);
+		if((lateCycles >= 3 || utilization > budget) && shedLevel < 2 * SHED_STEPS) shedLevel++;
+		else if(lateCycles == 0 && shedLevel > 0 && utilization + restoredShare() < 0.9 * budget) shedLevel--;
+		for(size_t i = 0; i < numTasks; i++) tasks[i].shedMetric->set(tasks[i].shed);
+		levelMetric.set(shedLevel);
+		utilizationMetric.set(utilization);
+		windowStart = now, busy = 0.0, lateCycles = 0;
+	}
+
+	/// Adds time the thread was busy outside the cycles, in another callback of its loop, to the load
+	inline void account (double seconds) { busy += seconds; }
+
+	/// 0 runs everything, SHED_STEPS drops the best effort tier and 2 * SHED_STEPS the normal one
+	size_t level () const { return shedLevel; }
+	double load () const { return utilization; }				///< Of the last window
+	const char* name (size_t id) const { return tasks[id].name; }
+	uint64_t runs (size_t id) const { return tasks[id].runs; }
+	uint64_t shed (size_t id) const { return tasks[id].shed; }
+	uint64_t overruns (size_t id) const { return tasks[id].overruns; }	///< Runs over the budget
+	double cost (size_t id) const { return tasks[id].cost; }				///< Moving average (s)
+	size_t size () const { return numTasks; }
+
+private:
+
+	/// The decimation step of a tier: 1 in 2^step of its outputs run, none at SHED_STEPS
+	inline size_t tierStep (ShedPriority priority) const {
+		size_t offset = (priority == SHED_BEST_EFFORT) ? 0 : SHED_STEPS;
+		return (shedLevel > offset) ? std::min(shedLevel - offset, (size_t) SHED_STEPS) : 0;
+	}
+
+	/// The busy share that restoring the last shed step would add, from the measured costs
+	double restoredShare () const {
+		ShedPriority tier = (shedLevel > SHED_STEPS) ? SHED_NORMAL : SHED_BEST_EFFORT;
+		size_t step = tierStep(tier);
+		double share = (step >= SHED_STEPS) ? 0.0 : 1.0 / (1u << step), restored = 1.0 / (1u << (step - 1));
+		double cost = 0.0;
+		for(size_t i = 0; i < numTasks; i++) if(tasks[i].priority == tier) cost += tasks[i].cost;
+		return cost * (restored - share) / period;
+	}
+
+	struct Task {
+		const char* name;
+		ShedPriority priority;
+		double budget, cost;
+		uint64_t runs, shed, overruns;
+		MetricGauge* shedMetric;				///< The count; counters are cache line aligned and new does not align in C++11
+	};
+
+	std::string prefix;
+	double period, budget, window;
+	Task tasks [SHED_MAX_TASKS];
+	size_t numTasks, shedLevel, lateCycles;		///< Cycles in a row longer than the period
+	double cycleStart, windowStart, busy, utilization;
+	uint64_t cycles;
+	MetricGauge levelMetric, utilizationMetric;
+};
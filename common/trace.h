@@ -0,0 +1,250 @@
+/**
+ * @file trace.h
+ * @date Oct 18, 2026
+ * @brief Scoped timeline markers for the stages of a loop cycle (channel wait, unpack, conversion,
+ * math, printing) that export to the Chrome trace JSON format, which chrome://tracing and
+ * ui.perfetto.dev open directly. A marker stores its name and the TSC (CLOCK_MONOTONIC off x86)
+ * at its start and end in a ring buffer of the calling thread, with a single relaxed load and a
+ * release store; the exporter copies the rings and drops the events that were overwritten while
+ * it read. The rings keep the last TRACE_BUFFER_EVENTS events of each thread, so a trace can stay
+ * on for days.
+ *
+ * Usage: mark the stages with TRACE_SCOPE("unpack") (the name must be a string literal), start a
+ * cycle with TRACE_CYCLE() (the EventLoop does it every wake up) and call traceStart() once from
+ * main, i.e. with the TRACE environment variable which is "<file>" to record every cycle or
+ * "<file>:<n>" to record one cycle in n. The file is written at exit. Without TRACE the markers
+ * cost a branch; compiled with -DTRACE_ENABLED=0 they are gone.
+ */
+
+#pragma once
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+/// Events kept per thread; a power of two
+#define TRACE_BUFFER_EVENTS 65536
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if TRACE_ENABLED
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/// A finished scope; the times are in ticks
+struct TraceEvent {
+	const char* name;
+	uint64_t start, end;
+};
+
+/// The ring of a thread; only the thread writes it
+struct TraceBuffer {
+	std::atomic <uint64_t> written;		///< Events so far; the newest is at (written - 1) % size
+	long tid;
+	char threadName [16];
+	TraceEvent events [TRACE_BUFFER_EVENTS];
+	TraceBuffer () : written(0), tid(0) { threadName[0] = '\0'; }
+};
+
+/// The settings and the rings of all the threads
+struct TraceState {
+	std::atomic <bool> enabled;
+	uint64_t sampleEvery;					///< Record one cycle in this many
+	std::string path;
+	uint64_t startTicks;						///< The ticks and the monotonic time at traceStart()
+	double startTime;
+	std::mutex mutex;							///< Guards the list of rings, not the rings
+	std::vector <TraceBuffer*> buffers;
+	TraceState () : enabled(false), sampleEvery(1), startTicks(0), startTime(0.0) {}
+};
+
+/// What a thread needs on the hot path
+struct TraceThread {
+	TraceBuffer* buffer;
+	bool recording;							///< The current cycle is sampled
+	uint64_t cycles;
+};
+
+/* ********************************************************************************************* */
+inline TraceState& traceState() { static TraceState state; return state; }
+inline TraceThread& traceThread() { static thread_local TraceThread thread = {NULL, true, 0}; return thread; }
+
+/* ********************************************************************************************* */
+/// The CLOCK_MONOTONIC time in seconds
+inline double traceNow() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* ********************************************************************************************* */
+/// The timestamp of a marker: the TSC (assumed invariant, as on every x86 of the last decade) or
+/// the monotonic clock in nanoseconds
+inline uint64_t traceTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ull + t.tv_nsec;
+#endif
+}
+
+/* ********************************************************************************************* */
+/// True if the markers of the calling thread record now
+inline bool traceRecording() {
+	return traceState().enabled.load(std::memory_order_relaxed) && traceThread().recording;
+}
+
+/* ********************************************************************************************* */
+/// Starts a cycle of the calling thread and decides whether it is sampled. Threads that never
+/// start cycles record every event.
+inline void traceCycle() {
+	TraceThread& thread = traceThread();
+	thread.recording = (thread.cycles++ % traceState().sampleEvery == 0);
+}
+
+/* ********************************************************************************************* */
+/// Gives the calling thread its ring; once per thread
+inline TraceBuffer* traceRegister() {
+	TraceBuffer* buffer = new TraceBuffer();
+	buffer->tid = syscall(SYS_gettid);
+	pthread_getname_np(pthread_self(), buffer->threadName, sizeof(buffer->threadName));
+	TraceState& state = traceState();
+	std::lock_guard <std::mutex> lock (state.mutex);
+	state.buffers.push_back(buffer);
+	return buffer;
+}
+
+/* ********************************************************************************************* */
+/// Hot path: writes the event into the thread's ring and publishes it
+inline void traceRecord(const char* name, uint64_t start, uint64_t end) {
+	TraceThread& thread = traceThread();
+	if(thread.buffer == NULL) thread.buffer = traceRegister();
+	TraceBuffer* buffer = thread.buffer;
+	uint64_t k = buffer->written.load(std::memory_order_relaxed);
+	TraceEvent& event = buffer->events[k & (TRACE_BUFFER_EVENTS - 1)];
+	event.name = name, event.start = start, event.end = end;
+	buffer->written.store(k + 1, std::memory_order_release);
+}
+
+/* ********************************************************************************************* */
+/// Records the time from its construction to the end of the enclosing block
+class TraceScope {
+public:
+	inline TraceScope (const char* name) : name(name), on(traceRecording()) { if(on) start = traceTicks(); }
+	inline ~TraceScope () { if(on) traceRecord(name, start, traceTicks()); }
+private:
+	const char* name;
+	bool on;
+	uint64_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__) (name)
+#define TRACE_CYCLE() traceCycle()
+
+/* ********************************************************************************************* */
+/// Writes the events in the rings as a Chrome trace with the times in microseconds of
+/// CLOCK_MONOTONIC; callable while the threads keep recording. Returns false if the file could
+/// not be written.
+inline bool traceExport(const char* path) {
+
+	// Convert the ticks with the rate since the start, measured over at least 10 ms
+	TraceState& state = traceState();
+	double toMicroseconds = 1e-3;
+#if defined(__x86_64__) || defined(__i386__)
+	while(traceNow() - state.startTime < 0.01) usleep(1000);
+	toMicroseconds = 1e6 * (traceNow() - state.startTime) / (traceTicks() - state.startTicks);
+#endif
+
+	FILE* file = fopen(path, "w");
+	if(file == NULL) return false;
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	long pid = getpid();
+	size_t numEvents = 0;
+	std::lock_guard <std::mutex> lock (state.mutex);
+	std::vector <TraceEvent> events;
+	for(size_t b = 0; b < state.buffers.size(); b++) {
+		TraceBuffer* buffer = state.buffers[b];
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+			(b == 0) ? "" : ",\n", pid, buffer->tid, buffer->threadName);
+
+		// Copy the ring and keep what was not overwritten meanwhile; the slot after the last one
+		// may be half written
+		uint64_t before = buffer->written.load(std::memory_order_acquire);
+		uint64_t first = (before > TRACE_BUFFER_EVENTS) ? before - TRACE_BUFFER_EVENTS : 0;
+		events.resize(before - first);
+		for(uint64_t k = first; k < before; k++) events[k - first] = buffer->events[k & (TRACE_BUFFER_EVENTS - 1)];
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t after = buffer->written.load(std::memory_order_relaxed);
+		uint64_t valid = (after + 1 > TRACE_BUFFER_EVENTS) ? after + 1 - TRACE_BUFFER_EVENTS : 0;
+		for(uint64_t k = std::max(first, valid); k < before; k++) {
+			const TraceEvent& e = events[k - first];
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%ld,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f}", e.name,
+				pid, buffer->tid, 1e6 * state.startTime + (int64_t) (e.start - state.startTicks) * toMicroseconds,
+				(e.end - e.start) * toMicroseconds);
+			numEvents++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	bool ok = (fclose(file) == 0);
+	if(ok) fprintf(stderr, "[trace] %zu events written to %s\n", numEvents, path);
+	return ok;
+}
+
+/* ********************************************************************************************* */
+inline void traceAtExit() {
+	TraceState& state = traceState();
+	state.enabled = false;
+	if(!traceExport(state.path.c_str())) fprintf(stderr, "Couldn't write the trace %s\n", state.path.c_str());
+}
+
+/* ********************************************************************************************* */
+/// Starts recording for "<file>" or "<file>:<one cycle in n>" and writes the file at exit; does
+/// nothing if the spec is NULL so that it can be called directly with getenv("TRACE")
+inline bool traceStart(const char* spec) {
+	if(spec == NULL || *spec == '\0') return false;
+	TraceState& state = traceState();
+	state.path = spec;
+	size_t colon = state.path.rfind(':');
+	if(colon != std::string::npos && colon + 1 < state.path.size() &&
+			strspn(spec + colon + 1, "0123456789") == state.path.size() - colon - 1) {
+		state.sampleEvery = std::max(atol(spec + colon + 1), 1l);
+		state.path.resize(colon);
+	}
+	state.startTicks = traceTicks(), state.startTime = traceNow();
+	state.enabled = true;
+	atexit(traceAtExit);
+	return true;
+}
+
+#else
+
+#define TRACE_SCOPE(name) ((void) 0)
+#define TRACE_CYCLE() ((void) 0)
+
+inline bool traceExport(const char*) { return false; }
+
+/* ********************************************************************************************* */
+inline bool traceStart(const char* spec) {
+	if(spec != NULL && *spec != '\0') fprintf(stderr, "[trace] compiled with TRACE_ENABLED=0, not tracing\n");
+	return false;
+}
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file transport.h
+ * @date Oct 18, 2026
+ * @brief A frame transport with the semantics of an ach channel handle so that the same decode
+ * and update code can read either a real ach channel or an in-process ring buffer. The memory
+ * transport needs no /dev/shm channel, no publisher process and no wall-clock pacing, which
+ * makes runs deterministic and lets us measure the pipeline without IPC or scheduler noise.
+ *
+ * Like ach, every handle keeps its own position in the stream: get() without options returns
+ * the next frame in sequence (ACH_MISSED_FRAME if some were overwritten), ACH_O_LAST returns
+ * the newest one and ACH_O_WAIT blocks until a new frame or the absolute timeout.
+ */
+
+#pragma once
+
+#include <ach.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/* ********************************************************************************************* */
+class Transport {
+public:
+	virtual ~Transport () {}
+
+	/// Puts a frame on the channel
+	virtual ach_status_t put (const void* frame, size_t size) = 0;
+
+	/// Copies a frame into the buffer, see ach_get; 'abstime' is only used with ACH_O_WAIT and
+	/// is a CLOCK_MONOTONIC time
+	virtual ach_status_t get (void* buffer, size_t capacity, size_t* frameSize,
+		const struct timespec* abstime, int options) = 0;
+
+	/// The sequence number of the last frame this handle got, 0 before the first one
+	virtual uint64_t sequence () const = 0;
+};
+
+/* ********************************************************************************************* */
+/// A handle of an existing ach channel
+class AchTransport : public Transport {
+public:
+
+	AchTransport () : opened(false) {}
+	~AchTransport () { if(opened) ach_close(&channel); }
+
+	ach_status_t open (const char* name) {
+		ach_status_t r = ach_open(&channel, name, NULL);
+		opened = (r == ACH_OK);
+		return r;
+	}
+
+	ach_status_t put (const void* frame, size_t size) { return ach_put(&channel, frame, size); }
+
+	ach_status_t get (void* buffer, size_t capacity, size_t* frameSize, const struct timespec* abstime,
+			int options) {
+		return ach_get(&channel, buffer, capacity, frameSize, abstime, options);
+	}
+
+	uint64_t sequence () const { return channel.seq_num; }
+
+	ach_channel_t* handle () { return &channel; }
+
+private:
+	ach_channel_t channel;
+	bool opened;
+};
+
+/* ********************************************************************************************* */
+/// The in-process equivalent of an ach channel: a ring of 'count' frames of at most 'frameSize'
+/// bytes each, allocated once
+class MemoryChannel {
+public:
+
+	MemoryChannel (size_t count = 16, size_t frameSize = ACH_DEFAULT_FRAME_SIZE) : count(count),
+		maxFrameSize(frameSize), data(count * frameSize), sizes(count, 0), last(0) {}
+
+	/// Copies the frame into the next slot, overwriting the oldest one
+	ach_status_t put (const void* frame, size_t size) {
+		if(size > maxFrameSize) return ACH_OVERFLOW;
+		{
+			std::lock_guard <std::mutex> lock (mutex);
+			size_t slot = last % count;
+			memcpy(&data[slot * maxFrameSize], frame, size);
+			sizes[slot] = size;
+			last++;
+		}
+		changed.notify_all();
+		return ACH_OK;
+	}
+
+	/// Gets the frame after 'seq' (or the newest one) and updates 'seq'
+	ach_status_t get (uint64_t& seq, void* buffer, size_t capacity, size_t* frameSize,
+			const struct timespec* abstime, int options) {
+
+		std::unique_lock <std::mutex> lock (mutex);
+
+		// Wait for a new frame if asked to
+		while((options & ACH_O_WAIT) && last <= seq) {
+			if(abstime == NULL) { changed.wait(lock); continue; }
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			double remaining = (abstime->tv_sec - now.tv_sec) + (abstime->tv_nsec - now.tv_nsec) * 1e-9;
+			if(remaining <= 0.0) return ACH_TIMEOUT;
+			changed.wait_for(lock, std::chrono::duration <double> (remaining));
+		}
+		if(last <= seq) return ACH_STALE_FRAMES;
+
+		// Pick the frame: the newest, the next one or the oldest one kept if we fell behind
+		ach_status_t result = ACH_OK;
+		uint64_t oldest = (last > count) ? (last - count + 1) : 1, want;
+		if(options & ACH_O_LAST) want = last;
+		else if(seq + 1 < oldest) want = oldest, result = ACH_MISSED_FRAME;
+		else want = seq + 1;
+
+		// Copy it out
+		size_t slot = (want - 1) % count;
+		*frameSize = sizes[slot];
+		if(sizes[slot] > capacity) return ACH_OVERFLOW;
+		memcpy(buffer, &data[slot * maxFrameSize], sizes[slot]);
+		seq = want;
+		return result;
+	}
+
+private:
+	size_t count, maxFrameSize;
+	std::vector <uint8_t> data;
+	std::vector <size_t> sizes;
+	uint64_t last;						///< The sequence number of the newest frame, 0 if none
+	std::mutex mutex;
+	std::condition_variable changed;
+};
+
+/* ********************************************************************************************* */
+/// A handle of a memory channel with its own position in the stream
+class MemoryTransport : public Transport {
+public:
+
+	MemoryTransport (MemoryChannel& channel) : channel(channel), seq(0) {}
+
+	ach_status_t put (const void* frame, size_t size) { return channel.put(frame, size); }
+
+	ach_status_t get (void* buffer, size_t capacity, size_t* frameSize, const struct timespec* abstime,
+			int options) {
+		return channel.get(seq, buffer, capacity, frameSize, abstime, options);
+	}
+
+	uint64_t sequence () const { return seq; }
+
+private:
+	MemoryChannel& channel;
+	uint64_t seq;
+};
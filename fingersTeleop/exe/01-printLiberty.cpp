@@ -3,7 +3,20 @@
  * @author Can Erdogan, Greg Tracy
  * @date Sept 21, 2013
  * @brief This executable shows how to get and print the liberty data reading 
- * from the "liberty" ach channel.
+ * from the "liberty" ach channel, or the one named with -c. With -m it reads synthetic frames put
+ * at 240 Hz on an in-process channel instead (see Synthetic.h and transport.h), so that it runs
+ * without ach or a publisher; its channel is then called "synthetic". The calibration offsets, health
+ * limits and deadline handling can be changed while it runs from the file in FINGERS_CONFIG (see
+ * parseFingersParam). Only the outputs named on the command line are computed (see
+ * LibertyGraph.h); without any it prints the position, the 4 matrices, the 4 angles and the
+ * quality. With SHADOW set to an engine name (see Shadow.h), every frame is also run through that
+ * engine on another core and compared with the poses and angles of the graph, which are then
+ * computed for every frame; the comparison is printed at exit. The state of the graph and the
+ * sequence number are saved after every frame in the shared memory segment named by CHECKPOINT
+ * (default /fingers-printLiberty-<channel>, "none" for none; see checkpoint.h), so that a
+ * restarted instance prints the last frame at once if it is still valid and continues its filters
+ * and health statistics instead of starting cold. Only one running instance saves to a segment.
+ * Usage: 01-printLiberty [-c channel | -m] [position|matrix1-4|angle1-4|filtered1-4|quality]...
  */
 
 #include <Eigen/Dense>
@@ -15,171 +28,162 @@
 #include <unistd.h>
 #include <syslog.h>
 #include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "metrics.h"
+#include "Liberty.h"
+#include "eventLoop.h"
+#include "trace.h"
+#include "Deadline.h"
+#include "SensorHealth.h"
+#include "FingersCore.h"
+#include "LibertyGraph.h"
+#include "Shadow.h"
+#include "liveConfig.h"
+#include "checkpoint.h"
+#include "shedder.h"
+#include "transport.h"
+#include "Synthetic.h"
 
-somatic_d_t somaticContext;
 somatic_d_opts_t somaticOptions;
-ach_channel_t achChannel;
 const char *channelName = "liberty";
 
+// Runtime statistics, exported if METRICS_ENDPOINT is set; the ones of the channel are labelled
+// with its name in main
+MetricCounter framesMetric ("printLiberty_frames", "Liberty frames decoded");
+MetricCounter skippedMetric ("printLiberty_skipped_frames", "Frames overwritten before being read");
+MetricGauge depthMetric ("printLiberty_queue_depth", "Unread frames on the channel before a read");
+MetricHistogram decodeMetric ("printLiberty_decode_seconds", "Time to unpack and convert a frame");
+MetricHistogram latencyMetric ("printLiberty_latency_seconds", "Time from the frame stamp to its decode");
+MetricCounter expiredMetric ("printLiberty_expired_frames", "Frames dropped past their validity deadline");
+Metric* const channelMetrics [] = {&framesMetric, &skippedMetric, &depthMetric, &decodeMetric, &latencyMetric,
+	&expiredMetric};
+MetricHistogram periodMetric ("printLiberty_loop_period_seconds", "Time between loop iterations");
+
+// The load of the decoding of the 240 Hz frames, and of the loop thread as a whole: the print
+// shedder is charged the decoding too, so the 10 Hz printing is shed when the thread is busy
+LoadShedder shedder ("printLiberty", 1.0 / 240);
+LoadShedder printShedder ("printLiberty_print", 0.1);
+size_t printOutput = printShedder.add("print", SHED_BEST_EFFORT, 5e-4);
+
 using namespace Eigen;
 using namespace std;
-#define M_EPSILON 1e-10
 
-/* ********************************************************************************************* */
-Eigen::Vector3d matrixToEuler(Matrix3d& m) {
-
-	double x, y, z;
-	if(m(2, 0) > (1.0-M_EPSILON)) {
-		x = atan2(m(0, 1), m(0, 2));
-		y = -M_PI / 2.0;
-		z = 0.0;
-	}   
-	if(m(2, 0) < -(1.0-M_EPSILON)) {
-		x = atan2(m(0, 1), m(0, 2));
-		y = M_PI / 2.0;
-		z = 0.0;
-	}   
-	x = atan2(m(2, 1), m(2, 2));
-	y = -asin(m(2, 0));
-	z = atan2(m(1, 0), m(0, 0));
-	return Vector3d(x,y,z); 
-}   
+/// The latest frame and what is printed of it
+struct LibertyState {
+	LibertyGraph graph;				///< Drops expired frames and replaces the glitches before the angles
+	bool fresh;							///< Set when a frame arrives, cleared when it is printed
+	ShadowRunner* shadow;			///< Compares a candidate engine with the graph if set
+	LibertyState () : fresh(false), shadow(NULL) {}
+};
+
+/// What a restarted instance resumes from
+struct PrintCheckpoint {
+	LibertyGraphState graph;
+	uint64_t lastSeq;					///< Of the last frame read
+};
+
+/// An output that can be printed: its name on the command line and its node in the graph
+struct Output {
+	const char* name;
+	size_t node;
+	bool printed;						///< By default
+};
+
+const Output outputs [] = {
+	{"position", LIBERTY_POSE, true},
+	{"matrix1", LIBERTY_MATRIX, true}, {"matrix2", LIBERTY_MATRIX + 1, true},
+	{"matrix3", LIBERTY_MATRIX + 2, true}, {"matrix4", LIBERTY_MATRIX + 3, true},
+	{"angle1", LIBERTY_ANGLE, true}, {"angle2", LIBERTY_ANGLE + 1, true},
+	{"angle3", LIBERTY_ANGLE + 2, true}, {"angle4", LIBERTY_ANGLE + 3, true},
+	{"quality", LIBERTY_CORRECT, true},
+	{"filtered1", LIBERTY_FILTERED, false}, {"filtered2", LIBERTY_FILTERED + 1, false},
+	{"filtered3", LIBERTY_FILTERED + 2, false}, {"filtered4", LIBERTY_FILTERED + 3, false}
+};
+const size_t numOutputs = sizeof(outputs) / sizeof(outputs[0]);
 
 /* ********************************************************************************************* */
-bool getLiberty(Eigen::VectorXd& config, Eigen::VectorXd& config2, Eigen::VectorXd& config3, Eigen::VectorXd& config4) {
-
-	// Get the data
-	int r = 0;
-	config.setZero(); 
-	Somatic__Liberty *l_msg = SOMATIC_GET_LAST_UNPACK( r, somatic__liberty,
-													   &protobuf_c_system_allocator, 1024, &achChannel);
-	if(!(ACH_OK == r || ACH_MISSED_FRAME == r) || (l_msg == NULL)) return false;
-
-	// Set the values for the position
-	Somatic__Vector* s1 = l_msg->sensor1;
-	Somatic__Vector* s2 = l_msg->sensor2;
-	Somatic__Vector* s3 = l_msg->sensor3;
-	Somatic__Vector* s4 = l_msg->sensor4;
-
-	config << s1->data[0], -s1->data[1], -s1->data[2], 0.0, 0.0, 0.0;
-	config2 << s2->data[0], -s2->data[1], -s2->data[2], 0.0, 0.0, 0.0;
-	config3 << s3->data[0], -s3->data[1], -s3->data[2], 0.0, 0.0, 0.0;
-	config4 << s4->data[0], -s4->data[1], -s4->data[2], 0.0, 0.0, 0.0;
-
-	// Convert from a quaternion to rpy representation
-
-	//s1
-	Eigen::Quaternion <double> oriQ (s1->data[6], s1->data[3], s1->data[4], s1->data[5]);
-	Eigen::Matrix3d oriM = oriQ.matrix();
-	Eigen::Vector3d oriE = matrixToEuler(oriM);
-	config.bottomLeftCorner<3,1>() << -oriE[2], -oriE[1], oriE[0];
-
-	//s2
-	Eigen::Quaternion <double> oriQ2 (s2->data[6], s2->data[3], s2->data[4], s2->data[5]);
-	Eigen::Matrix3d oriM2 = oriQ2.matrix();
-	Eigen::Vector3d oriE2 = matrixToEuler(oriM2);
-	config2.bottomLeftCorner<3,1>() << -oriE2[2], -oriE2[1], oriE2[0];
-
-	//s3
-	Eigen::Quaternion <double> oriQ3 (s3->data[6], s3->data[3], s3->data[4], s3->data[5]);
-	Eigen::Matrix3d oriM3 = oriQ3.matrix();
-	Eigen::Vector3d oriE3 = matrixToEuler(oriM3);
-	config3.bottomLeftCorner<3,1>() << -oriE3[2], -oriE3[1], oriE3[0];
-
-	//s4
-	Eigen::Quaternion <double> oriQ4 (s4->data[6], s4->data[3], s4->data[4], s4->data[5]);
-	Eigen::Matrix3d oriM4 = oriQ4.matrix();
-	Eigen::Vector3d oriE4 = matrixToEuler(oriM4);
-	config4.bottomLeftCorner<3,1>() << -oriE4[2], -oriE4[1], oriE4[0];
-
-
-	return true;
+/// Subscribes the printing of an output to the graph
+void subscribe(LibertyGraph& graph, const Output& output) {
+	size_t node = output.node;
+	if(node == LIBERTY_POSE) graph.graph().subscribe(node, [&graph]() {
+		cout << "position: " << graph.pose(0).position.transpose() << endl;
+	});
+
+	// Sensor 1 is the palm and 2, 3, 4 the fingers
+	else if(node >= LIBERTY_MATRIX && node < LIBERTY_MATRIX + 4) graph.graph().subscribe(node, [&graph, node]() {
+		size_t i = node - LIBERTY_MATRIX;
+		if(i == 0) cout << "matrix: \n" << graph.matrix(i) << "\n" << endl;
+		else cout << "matrix" << i + 1 << ": \n" << graph.matrix(i) << "\n" << endl;
+	});
+
+	// The angle of sensor 1 relative to the polhemus cube and of sensor 1 relative to 2, 3, 4
+	else if(node >= LIBERTY_ANGLE && node < LIBERTY_ANGLE + 4) graph.graph().subscribe(node, [&graph, node]() {
+		size_t i = node - LIBERTY_ANGLE;
+		cout << "angle" << i + 1 << ": " << graph.angle(i) / M_PI * 180.0 << endl;
+	});
+	else if(node >= LIBERTY_FILTERED && node < LIBERTY_FILTERED + 4) graph.graph().subscribe(node, [&graph, node]() {
+		size_t i = node - LIBERTY_FILTERED;
+		cout << "filtered" << i + 1 << ": " << graph.filtered(i) / M_PI * 180.0 << endl;
+	});
+
+	// The quality of the sensors, 0 to 1
+	else graph.graph().subscribe(node, [&graph]() {
+		const HealthReport& report = graph.report();
+		cout << "quality: " << report.score[0] << " " << report.score[1] << " " << report.score[2] << " " <<
+			report.score[3] << endl;
+	});
 }
 
 /* ********************************************************************************************* */
-void run() {
-
-	// Send a message; set the event code and the priority
-	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE, 
-			SOMATIC__EVENT__CODES__PROC_RUNNING, NULL, NULL);
-
-	// Unless an interrupt or terminate message is received, process the new message
-	while(!somatic_sig_received) {
-
-		// Get the liberty data
-		Eigen::VectorXd config = VectorXd::Zero(6);
-		Eigen::VectorXd config2 = VectorXd::Zero(6);
-		Eigen::VectorXd config3 = VectorXd::Zero(6);
-		Eigen::VectorXd config4 = VectorXd::Zero(6);
-		bool success = false;
-		while(!success) success = getLiberty(config, config2, config3, config4);
-		cout << "config: " << config.transpose() << endl;
-		
-		//sensor 1 (palm)
-		Eigen::Matrix3d matrix = (Eigen::AngleAxis <double> (config(5), Eigen::Vector3d(0.0, 0.0, 1.0)) *
-					Eigen::AngleAxis <double> (config(4), Eigen::Vector3d(0.0, 1.0, 0.0)) *
-					Eigen::AngleAxis <double> (config(3), Eigen::Vector3d(1.0, 0.0, 0.0))).matrix();
-		cout << "matrix: \n" << matrix << "\n" << endl;
-	
-		//sensor 2 (finger 1)
-		Eigen::Matrix3d matrix2 = (Eigen::AngleAxis <double> (config2(5), Eigen::Vector3d(0.0, 0.0, 1.0)) *
-					Eigen::AngleAxis <double> (config2(4), Eigen::Vector3d(0.0, 1.0, 0.0)) *
-					Eigen::AngleAxis <double> (config2(3), Eigen::Vector3d(1.0, 0.0, 0.0))).matrix();
-		cout << "matrix2: \n" << matrix2 << "\n" << endl;
-
-		//sensor 3 (finger 2)
-		Eigen::Matrix3d matrix3 = (Eigen::AngleAxis <double> (config3(5), Eigen::Vector3d(0.0, 0.0, 1.0)) *
-					Eigen::AngleAxis <double> (config3(4), Eigen::Vector3d(0.0, 1.0, 0.0)) *
-					Eigen::AngleAxis <double> (config3(3), Eigen::Vector3d(1.0, 0.0, 0.0))).matrix();
-		cout << "matrix3: \n" << matrix3 << "\n" << endl;
-
-
-		//sensor 4 (finger 3)
-		Eigen::Matrix3d matrix4 = (Eigen::AngleAxis <double> (config4(5), Eigen::Vector3d(0.0, 0.0, 1.0)) *
-					Eigen::AngleAxis <double> (config4(4), Eigen::Vector3d(0.0, 1.0, 0.0)) *
-					Eigen::AngleAxis <double> (config4(3), Eigen::Vector3d(1.0, 0.0, 0.0))).matrix();
-		cout << "matrix4: \n" << matrix4 << "\n" << endl;
-
-
-		//angle of sensor 1 relative to polhemus cube
-		Eigen::Vector3d localZ (matrix(0,2), matrix(1,2), matrix(2,2));
-		double angle = acos(localZ.dot(Eigen::Vector3d(0.0, 0.0, 1.0)));
-		cout << "angle1: " << angle / M_PI * 180.0 << endl;
-
-		//angle of sensor 1 relative to sensor 2, 3
-		Eigen::Vector3d sensor2Z (matrix2(0,2), matrix2(1,2), matrix2(2,2));
-		double angle2 = acos(sensor2Z.dot(Eigen::Vector3d(-matrix(0,2), -matrix(1,2), -matrix(2,2))));
-		cout << "angle2: " << angle2 / M_PI * 180.0 << endl;
-		//angle of sensor 1 relative to sensor 2, 3
-		Eigen::Vector3d sensor3Z (matrix3(0,2), matrix3(1,2), matrix3(2,2));
-		double angle3 = acos(sensor3Z.dot(Eigen::Vector3d(-matrix(0,2), -matrix(1,2), -matrix(2,2))));
-		cout << "angle3: " << angle3 / M_PI * 180.0 << endl;
-
-		//angle of sensor 1 relative to sensor 2, 3
-		Eigen::Vector3d sensor4Z (matrix4(0,2), matrix4(1,2), matrix4(2,2));
-		double angle4 = acos(sensor4Z.dot(Eigen::Vector3d(-matrix(0,2), -matrix(1,2), -matrix(2,2))));
-		cout << "angle4: " << angle4 / M_PI * 180.0 << endl;
-
-		usleep(1e5);
-		// Free buffers allocated during this cycle
-		aa_mem_region_release(&somaticContext.memreg);	
+bool getLiberty(EventLoop& loop, const uint8_t* buffer, size_t numBytes, LibertyState& state) {
+
+	// Decode, check and correct the frame; the rest waits for the printing
+	double start = metricsNow();
+	size_t expired = state.graph.deadline().expired();
+	if(!state.graph.frame(buffer, numBytes, &(loop.daemon()->pballoc), start)) {
+		if(state.graph.deadline().expired() > expired) expiredMetric.add();
+		return false;
+	}
+	state.fresh = true;
+
+	// The graph is the primary engine of a shadow run
+	if(state.shadow != NULL) {
+		double primaryStart = metricsNow();
+		EngineOutput output;
+		bool ok = true;
+		LazyGraph& graph = state.graph.graph();
+		for(size_t i = 0; i < 4; i++) {
+			ok &= graph.get(LIBERTY_MATRIX + i) && graph.get(LIBERTY_ANGLE + i);
+			if(!ok) break;
+			output.positions[i] = state.graph.pose(i).position;
+			output.matrices[i] = state.graph.matrix(i);
+			output.angles[i] = state.graph.angle(i);
+		}
+		state.shadow->submit(state.graph.corrected(), output, ok, metricsNow() - primaryStart);
 	}
 
-	// Send the stoppig event
-	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE,
-					 SOMATIC__EVENT__CODES__PROC_STOPPING, NULL, NULL);
+	framesMetric.add();
+	decodeMetric.observe(metricsNow() - start);
+	latencyMetric.observe(metricsNow() - state.graph.time());
+	return true;
 }
 
 /* ********************************************************************************************* */
-void init() {
-	somatic_d_init(&somaticContext, &somaticOptions);
-	somatic_d_channel_open(&somaticContext, &achChannel, channelName, NULL);
-}
+void print(LibertyState& state) {
 
-/* ********************************************************************************************* */
-void destroy() {
-	somatic_d_channel_close(&somaticContext, &achChannel);
-	somatic_d_destroy(&somaticContext);
+	// Wait for a new frame; say once when the last one expires
+	DeadlineGuard& guard = state.graph.deadline();
+	if(guard.stalled(metricsNow())) cout << "stale: no valid frame since " << guard.deadline() << endl;
+	if(!state.fresh) return;
+	state.fresh = false;
+
+	// Compute what the subscribed outputs need and print them
+	TRACE_SCOPE("print");
+	state.graph.run();
 }
 
 /* ********************************************************************************************* */
@@ -190,10 +194,142 @@ int main(int argc, char* argv[]) {
 	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE; 
 	somaticOptions.skip_mlock = 1; 		
 
-	// Initialize the code and run until a somatic_sig is received (?)
-	init();
-	run();
-	destroy();
+	// Read the channel and subscribe the outputs to print
+	vector <const char*> names;
+	bool synthetic = false;
+	for(int k = 1; k < argc; k++) {
+		if(strcmp(argv[k], "-c") == 0 && k + 1 < argc) channelName = argv[++k];
+		else if(strcmp(argv[k], "-m") == 0) synthetic = true;
+		else names.push_back(argv[k]);
+	}
+	if(synthetic) channelName = "synthetic";
+	std::string labels = std::string("channel=\"") + channelName + "\"";
+	for(size_t i = 0; i < sizeof(channelMetrics) / sizeof(channelMetrics[0]); i++)
+		channelMetrics[i]->relabel(labels.c_str());
+	LibertyState state;
+	for(size_t i = 0; i < numOutputs; i++) {
+		bool named = false;
+		for(size_t k = 0; k < names.size(); k++) named |= (strcmp(names[k], outputs[i].name) == 0);
+		if(named || (names.empty() && outputs[i].printed)) subscribe(state.graph, outputs[i]);
+	}
+	for(size_t k = 0; k < names.size(); k++) {
+		bool known = false;
+		for(size_t i = 0; i < numOutputs; i++) known |= (strcmp(names[k], outputs[i].name) == 0);
+		if(known) continue;
+		fprintf(stderr, "Unknown output '%s'\n", names[k]);
+		exit(EXIT_FAILURE);
+	}
+	const char* shadowName = getenv("SHADOW");
+	if(shadowName != NULL) {
+		if(findEngine(shadowName) == NULL) {
+			fprintf(stderr, "Unknown shadow engine '%s', use pose or euler\n", shadowName);
+			exit(EXIT_FAILURE);
+		}
+		state.shadow = new ShadowRunner ("printLiberty", NULL, findEngine(shadowName));
+	}
+
+	// Resume from the last instance
+	std::string checkpointName = getenv("CHECKPOINT") ? getenv("CHECKPOINT") : "";
+	if(checkpointName.empty()) checkpointName = std::string("/fingers-printLiberty-") + channelName;
+	Checkpoint <PrintCheckpoint>* checkpoint = NULL;
+	PrintCheckpoint saved;
+	uint64_t lastSeq = 0;
+	if(checkpointName != "none") {
+		checkpoint = new Checkpoint <PrintCheckpoint> (checkpointName.c_str());
+		double age;
+		if(checkpoint->restore(saved, &age)) {
+			lastSeq = saved.lastSeq;
+			state.fresh = state.graph.restore(saved.graph, metricsNow());
+			fprintf(stderr, "Resumed from a checkpoint of %.3f s ago%s\n", age,
+				state.fresh ? "" : ", its last frame has expired");
+			print(state);
+		}
+	}
+
+	metricsServe(getenv("METRICS_ENDPOINT"));
+	traceStart(getenv("TRACE"));
+
+	// Watch the config file
+	LiveConfig <FingersCoreParams> config ((FingersCoreParams()));
+	ConfigWatcher <FingersCoreParams> watcher (config, getenv("FINGERS_CONFIG"), parseFingersParam, validFingersParams);
+	LiveConfig <FingersCoreParams>::Reader reader (config);
+	uint64_t configured = 0;
+
+	// The channel, or the in-process one of the synthetic frames; the loop reads with one handle
+	// and waits with the other
+	AchTransport achReading, achWaiting;
+	MemoryChannel memory (16, 1024);
+	MemoryTransport memoryReading (memory), memoryWaiting (memory);
+	Transport* reading = &memoryReading, * waiting = &memoryWaiting;
+	if(!synthetic) {
+		ach_status_t r = achReading.open(channelName);
+		if(r == ACH_OK) r = achWaiting.open(channelName);
+		if(r != ACH_OK) {
+			fprintf(stderr, "Couldn't open channel %s: %s\n", channelName, ach_result_to_string(r));
+			exit(EXIT_FAILURE);
+		}
+		reading = &achReading, waiting = &achWaiting;
+	}
+
+	// Decode the latest frame when one arrives and print it every 0.1s until a somatic_sig is received
+	EventLoop loop (somaticOptions);
+	loop.subscribe(*reading, *waiting, [&](const uint8_t* frame, size_t size, ach_status_t) {
+		uint64_t seq = reading->sequence();
+		if(lastSeq > 0 && seq > lastSeq) {
+			depthMetric.set(seq - lastSeq);
+			if(seq > lastSeq + 1) skippedMetric.add(seq - lastSeq - 1);
+		}
+		lastSeq = seq;
+		const FingersCoreParams* params = reader.get();
+		if(reader.version() != configured) {
+			state.graph.configure(*params);
+			configured = reader.version();
+		}
+		double start = metricsNow();
+		shedder.begin();
+		if(getLiberty(loop, frame, size, state) && checkpoint != NULL) {
+			state.graph.save(saved.graph);
+			saved.lastSeq = lastSeq;
+			checkpoint->save(saved);
+		}
+		shedder.end();
+		printShedder.account(metricsNow() - start);
+	}, true);
+	double lastCycle = metricsNow();
+	loop.every(0.1, [&]() {
+		double now = metricsNow();
+		periodMetric.observe(now - lastCycle);
+		lastCycle = now;
+		printShedder.begin();
+		printShedder.run(printOutput, [&]() { print(state); });
+		printShedder.end();
+	});
+
+	// The synthetic frames, stamped now and valid for 0.1s; the thread starts after the loop so
+	// that it inherits the termination signals blocked
+	std::atomic <bool> producing (true);
+	std::thread producer;
+	if(synthetic) producer = std::thread([&]() {
+		SyntheticLiberty liberty;
+		uint8_t frame [1024];
+		struct timespec next;
+		clock_gettime(CLOCK_MONOTONIC, &next);
+		while(producing) {
+			double now = metricsNow();
+			memory.put(frame, liberty.pack(now, 0.1, frame, sizeof(frame)));
+			next.tv_nsec += 1000000000 / 240;
+			if(next.tv_nsec >= 1000000000) next.tv_sec++, next.tv_nsec -= 1000000000;
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		}
+	});
+	loop.run();
+	producing = false;
+	if(producer.joinable()) producer.join();
+	if(state.shadow != NULL) {
+		state.shadow->drain();
+		state.shadow->print(stdout);
+		delete state.shadow;
+	}
 
-	exit(EXIT_SUCCESS);
+	return 0;
 }
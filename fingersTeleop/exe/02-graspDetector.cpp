@@ -0,0 +1,125 @@
+/**
+ * @file 02-graspDetector.cpp
+ * @date Oct 18, 2026
+ * @brief Classifies the operator's hand as open, closing, closed or pinching from every frame on
+ * the "liberty" ach channel and puts a GraspEvent on the "grasp" channel when the state changes.
+ * Create the output channel first, i.e. "ach mk grasp". Usage: 02-graspDetector [input] [hand]
+ */
+
+#include <Eigen/Dense>
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <somatic.pb-c.h>
+#include <argp.h>
+#include <ach.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include "Liberty.h"
+#include "GraspDetector.h"
+#include "Deadline.h"
+
+somatic_d_t somaticContext;
+somatic_d_opts_t somaticOptions;
+ach_channel_t libertyChannel, graspChannel;
+const char *libertyName = "liberty", *graspName = "grasp";
+uint32_t hand = 0;
+
+GraspDetector detector;
+DeadlineGuard deadlineGuard;
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+void update() {
+
+	// Wait for the next frame
+	struct timespec abstimeout = aa_tm_future( aa_tm_sec2timespec(1) );
+	int result;
+	size_t numBytes = 0;
+	uint8_t* buffer = (uint8_t*) somatic_d_get(&somaticContext, &libertyChannel, &numBytes, &abstimeout,
+		ACH_O_WAIT, &result);
+	if(numBytes == 0) return;
+	Somatic__Liberty* l_msg = somatic__liberty__unpack(&(somaticContext.pballoc), numBytes, buffer);
+	if(l_msg == NULL) return;
+
+	// Drop the frame if it arrived after its validity deadline
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double time = now.tv_sec + now.tv_nsec * 1e-9;
+	if(!deadlineGuard.accept(metadataUntil(l_msg->meta), time)) return;
+
+	// Compute the finger flexions: 0 when a finger is straight with the palm
+	Pose <RobotFrame> palm = sensorToPose(l_msg->sensor1->data);
+	Somatic__Vector* sensors [GRASP_NUM_FINGERS] = {l_msg->sensor2, l_msg->sensor3, l_msg->sensor4};
+	double flexion [GRASP_NUM_FINGERS];
+	for(size_t i = 0; i < GRASP_NUM_FINGERS; i++)
+		flexion[i] = M_PI - fingerAngle(palm, sensorToPose(sensors[i]->data));
+
+	// Update the detector and publish the change
+	if(!detector.update(time, flexion)) return;
+	GraspEvent event;
+	event.hand = hand;
+	event.state = detector.state();
+	event.previous = detector.previousState();
+	event.time = time;
+	for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) event.flexion[i] = detector.finger(i).mean();
+	ach_status_t r = ach_put(&graspChannel, &event, sizeof(event));
+	if(r != ACH_OK) fprintf(stderr, "Couldn't send the grasp event: %s\n", ach_result_to_string(r));
+	printf("[grasp] hand %u: %s -> %s\n", hand, graspStateName(detector.previousState()),
+		graspStateName(detector.state()));
+	fflush(stdout);
+}
+
+/* ********************************************************************************************* */
+void run() {
+
+	// Send a message; set the event code and the priority
+	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE,
+			SOMATIC__EVENT__CODES__PROC_RUNNING, NULL, NULL);
+
+	// Unless an interrupt or terminate message is received, process the new message
+	while(!somatic_sig_received) {
+		update();
+		aa_mem_region_release(&somaticContext.memreg);	// free buffers allocated during this cycle
+	}
+
+	// Send the stoppig event
+	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE,
+					 SOMATIC__EVENT__CODES__PROC_STOPPING, NULL, NULL);
+}
+
+/* ********************************************************************************************* */
+void init() {
+	somatic_d_init(&somaticContext, &somaticOptions);
+	somatic_d_channel_open(&somaticContext, &libertyChannel, libertyName, NULL);
+	somatic_d_channel_open(&somaticContext, &graspChannel, graspName, NULL);
+}
+
+/* ********************************************************************************************* */
+void destroy() {
+	printf("[grasp] %zu frames used, %zu expired\n", deadlineGuard.accepted(), deadlineGuard.expired());
+	somatic_d_channel_close(&somaticContext, &graspChannel);
+	somatic_d_channel_close(&somaticContext, &libertyChannel);
+	somatic_d_destroy(&somaticContext);
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Read the input channel and the hand id
+	if(argc > 1) libertyName = argv[1];
+	if(argc > 2) hand = atoi(argv[2]);
+
+	// Set the somatic context options
+	somaticOptions.ident = "02-graspDetector";
+	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE;
+	somaticOptions.skip_mlock = 1;
+
+	init();
+	run();
+	destroy();
+
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file 03-fuseLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief This executable shows how to match the liberty frames with the arm state and the
+ * force/torque readings that arrive on other channels at other rates. A thread per channel keeps
+ * a time-indexed history using the somatic metadata timestamps and the main loop samples all of
+ * them at the same instant at 100 Hz.
+ * Usage: 03-fuseLiberty [liberty] [arm state] [force/torque]
+ */
+
+#include <Eigen/Dense>
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+#include "TimeAlign.h"
+
+somatic_d_t somaticContext;
+somatic_d_opts_t somaticOptions;
+const char *libertyName = "liberty", *armName = "llwa-state", *ftName = "llwa_ft";
+
+// The histories: 4 liberty sensors (x, y, z, qx, qy, qz, qw), 7 arm joints and force + moment
+const size_t libertyQuats [] = {3, 10, 17, 24};
+ChannelHistory libertyHistory (28, std::vector <size_t> (libertyQuats, libertyQuats + 4));
+ChannelHistory armHistory (7);
+ChannelHistory ftHistory (6);
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+/// Returns the time stamp of a message, or now if the sender did not set it
+double messageTime(Somatic__Metadata* meta) {
+	if(meta != NULL && meta->time != NULL) return meta->time->sec + meta->time->nsec * 1e-9;
+	return aa_tm_timespec2sec(aa_tm_now());
+}
+
+/* ********************************************************************************************* */
+/// Copies at most n entries of a somatic vector, zero-filling the rest
+void copyVector(Somatic__Vector* v, double* out, size_t n) {
+	for(size_t i = 0; i < n; i++) out[i] = (v != NULL && i < v->n_data) ? v->data[i] : 0.0;
+}
+
+/* ********************************************************************************************* */
+/// Reads every frame of a channel and pushes it to its history
+void reader(const char* name, ChannelHistory* history) {
+
+	ach_channel_t chan;
+	ach_status_t r = ach_open(&chan, name, NULL);
+	if(r != ACH_OK) {
+		fprintf(stderr, "Couldn't open channel %s: %s\n", name, ach_result_to_string(r));
+		return;
+	}
+
+	vector <uint8_t> frame (4096);
+	double values [HISTORY_MAX_VALUES];
+	while(!somatic_sig_received) {
+
+		// Wait for the next frame
+		size_t frameSize = 0;
+		struct timespec abstimeout = aa_tm_future(aa_tm_sec2timespec(1));
+		r = ach_get(&chan, &frame[0], frame.size(), &frameSize, &abstimeout, ACH_O_WAIT);
+		if(r == ACH_OVERFLOW) {
+			frame.resize(frameSize);						// the frame is read again with room for it
+			continue;
+		}
+		const uint8_t* buffer = &frame[0];
+		if(!(r == ACH_OK || r == ACH_MISSED_FRAME) || frameSize == 0) continue;
+
+		// Decode it according to the channel
+		double time;
+		if(history == &libertyHistory) {
+			Somatic__Liberty* msg = somatic__liberty__unpack(&protobuf_c_system_allocator, frameSize, buffer);
+			if(msg == NULL) continue;
+			Somatic__Vector* sensors [] = {msg->sensor1, msg->sensor2, msg->sensor3, msg->sensor4};
+			for(size_t i = 0; i < 4; i++) copyVector(sensors[i], values + 7 * i, 7);
+			time = messageTime(msg->meta);
+			somatic__liberty__free_unpacked(msg, &protobuf_c_system_allocator);
+		}
+		else if(history == &armHistory) {
+			Somatic__MotorState* msg = somatic__motor_state__unpack(&protobuf_c_system_allocator, frameSize, buffer);
+			if(msg == NULL) continue;
+			copyVector(msg->position, values, 7);
+			time = messageTime(msg->meta);
+			somatic__motor_state__free_unpacked(msg, &protobuf_c_system_allocator);
+		}
+		else {
+			Somatic__ForceMoment* msg = somatic__force_moment__unpack(&protobuf_c_system_allocator, frameSize, buffer);
+			if(msg == NULL) continue;
+			copyVector(msg->force, values, 3);
+			copyVector(msg->moment, values + 3, 3);
+			time = messageTime(msg->meta);
+			somatic__force_moment__free_unpacked(msg, &protobuf_c_system_allocator);
+		}
+		if(!history->push(time, values)) somatic_verbprintf(1, "Dropped a frame of %s out of order\n", name);
+	}
+	ach_close(&chan);
+}
+
+/* ********************************************************************************************* */
+void run() {
+
+	// Send a message; set the event code and the priority
+	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE,
+			SOMATIC__EVENT__CODES__PROC_RUNNING, NULL, NULL);
+
+	// Start the readers
+	thread libertyThread (reader, libertyName, &libertyHistory);
+	thread armThread (reader, armName, &armHistory);
+	thread ftThread (reader, ftName, &ftHistory);
+
+	// Sample all the channels at the latest instant they all cover
+	const ChannelHistory* channels [] = {&libertyHistory, &armHistory, &ftHistory};
+	double liberty [HISTORY_MAX_VALUES], arm [HISTORY_MAX_VALUES], ft [HISTORY_MAX_VALUES];
+	while(!somatic_sig_received) {
+		usleep(1e4);
+		double time;
+		if(!snapshotTime(channels, 3, time)) continue;
+		if(libertyHistory.at(time, liberty) != HISTORY_OK || armHistory.at(time, arm) != HISTORY_OK ||
+			ftHistory.at(time, ft) != HISTORY_OK) continue;
+		cout << "t: " << fixed << time << "\n  palm: " << Map <VectorXd> (liberty, 7).transpose()
+			<< "\n  arm: " << Map <VectorXd> (arm, 7).transpose() << "\n  ft: " << Map <VectorXd> (ft, 6).transpose()
+			<< endl;
+	}
+
+	libertyThread.join();
+	armThread.join();
+	ftThread.join();
+
+	// Send the stoppig event
+	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE,
+					 SOMATIC__EVENT__CODES__PROC_STOPPING, NULL, NULL);
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Read the channel names
+	if(argc > 1) libertyName = argv[1];
+	if(argc > 2) armName = argv[2];
+	if(argc > 3) ftName = argv[3];
+
+	// Set the somatic context options
+	somaticOptions.ident = "03-fuseLiberty";
+	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE;
+	somaticOptions.skip_mlock = 1;
+
+	somatic_d_init(&somaticContext, &somaticOptions);
+	run();
+	somatic_d_destroy(&somaticContext);
+
+	exit(EXIT_SUCCESS);
+}
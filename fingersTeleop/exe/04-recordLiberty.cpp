@@ -0,0 +1,76 @@
+/**
+ * @file 04-recordLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Records every frame of the "liberty" ach channel to a file for offline analysis, see
+ * 05-exportLiberty. With 'compact' the frames are stored with the PoseCodec, which takes about
+ * a sixth of the space but keeps only the readings and their time, not the rest of the message.
+ * Usage: 04-recordLiberty <file> [channel] [compact]
+ */
+
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include <unistd.h>
+#include "eventLoop.h"
+#include "Recording.h"
+#include "Liberty.h"
+#include "PoseCodec.h"
+
+somatic_d_opts_t somaticOptions;
+const char *channelName = "liberty";
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Open the output
+	if(argc < 2) {
+		fprintf(stderr, "Usage: %s <file> [channel] [compact]\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if(argc > 2) channelName = argv[2];
+	bool compact = (argc > 3) && (strcmp(argv[3], "compact") == 0);
+	RecordingWriter writer;
+	if(!writer.open(argv[1], compact ? RECORDING_MAGIC_POSES : RECORDING_MAGIC)) {
+		fprintf(stderr, "Couldn't create %s: %s\n", argv[1], strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	// Set the somatic context options
+	somaticOptions.ident = "04-recordLiberty";
+	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE;
+	somaticOptions.skip_mlock = 1;
+
+	// Write every frame until a somatic_sig is received
+	EventLoop loop (somaticOptions);
+	size_t count = 0, bytes = 0;
+	PoseEncoder encoder;
+	uint8_t encoded [POSE_CODEC_MAX_FRAME];
+	loop.subscribe(channelName, [&](const uint8_t* frame, size_t size, ach_status_t result) {
+		double receiveTime = aa_tm_timespec2sec(aa_tm_now());
+		if(result == ACH_MISSED_FRAME) fprintf(stderr, "[record] missed frames before #%zu\n", count);
+
+		// Encode the readings; a frame without them or its time is left out
+		if(compact) {
+			double time, readings [4][7];
+			if(!unpackReadings(frame, size, &(loop.daemon()->pballoc), time, readings) || isnan(time) ||
+					isnan(readings[0][0] + readings[1][0] + readings[2][0] + readings[3][0])) {
+				fprintf(stderr, "[record] skipped incomplete frame #%zu\n", count);
+				return;
+			}
+			size = encoder.encode(time, readings, encoded);
+			frame = encoded;
+		}
+		bytes += size;
+		if(!writer.write(receiveTime, frame, size)) {
+			fprintf(stderr, "Couldn't write to %s: %s\n", argv[1], strerror(errno));
+			loop.stop();
+		}
+		count++;
+	});
+	loop.run();
+	writer.close();
+	printf("[record] %zu frames, %zu bytes\n", count, bytes);
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file 05-exportLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Converts a recording of liberty frames (see 04-recordLiberty) to one .npy array per
+ * field: the message and receive times, the raw position and quaternion of each sensor, the
+ * pose in the robot convention and the palm and finger angles. The frames are decoded and the
+ * poses recomputed on all the cores; compact recordings are decoded in order first.
+ * Usage: 05-exportLiberty <recording> <output directory>
+ */
+
+#include <Eigen/Dense>
+#include "somatic.h"
+#include <somatic.pb-c.h>
+#include <sys/stat.h>
+#include "Liberty.h"
+#include "Recording.h"
+#include "Columnar.h"
+#include "Parallel.h"
+#include "PoseCodec.h"
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Map the recording
+	if(argc < 3) {
+		fprintf(stderr, "Usage: %s <recording> <output directory>\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	double start = aa_tm_timespec2sec(aa_tm_now());
+	RecordingReader recording;
+	if(!recording.open(argv[1])) {
+		fprintf(stderr, "Couldn't read the recording %s\n", argv[1]);
+		exit(EXIT_FAILURE);
+	}
+	const size_t n = recording.size();
+
+	// Create the columns: the times, then per sensor the raw reading and the robot pose, then angles
+	ColumnTable table (n);
+	size_t timeColumn = table.add("time"), receiveColumn = table.add("receive_time");
+	const char* raw [] = {"x", "y", "z", "qx", "qy", "qz", "qw"};
+	const char* pose [] = {"px", "py", "pz", "roll", "pitch", "yaw"};
+	size_t rawColumns [4][7], poseColumns [4][6], angleColumns [4];
+	char name [32];
+	for(size_t s = 0; s < 4; s++) {
+		for(size_t i = 0; i < 7; i++) sprintf(name, "s%zu_%s", s + 1, raw[i]), rawColumns[s][i] = table.add(name);
+		for(size_t i = 0; i < 6; i++) sprintf(name, "s%zu_%s", s + 1, pose[i]), poseColumns[s][i] = table.add(name);
+	}
+	for(size_t s = 0; s < 4; s++) sprintf(name, "angle%zu", s + 1), angleColumns[s] = table.add(name);
+
+	// Encoded recordings hold delta frames, so they are decoded in order up front; a row that can
+	// not be decoded has a NaN time
+	struct Frame { double time, readings [4][7]; };
+	vector <Frame> decoded (recording.encoded() ? n : 0);
+	if(recording.encoded()) {
+		PoseDecoder decoder;
+		for(size_t r = 0; r < n; r++)
+			if(!decoder.decode(recording[r].message, recording[r].size, decoded[r].time, decoded[r].readings))
+				decoded[r].time = NAN;
+	}
+
+	// Read the frames and recompute the poses and angles in parallel; undecodable rows stay NaN
+	parallelFor(n, 4096, [&](size_t begin, size_t end) {
+		Eigen::VectorXd config = VectorXd::Zero(6);
+		double time, readings [4][7];
+		for(size_t r = begin; r < end; r++) {
+			table.column(receiveColumn)[r] = recording[r].receiveTime;
+			if(recording.encoded()) {
+				time = decoded[r].time;
+				if(isnan(time)) continue;
+				memcpy(readings, decoded[r].readings, sizeof(readings));
+			}
+			else if(!unpackReadings(recording[r].message, recording[r].size, &protobuf_c_system_allocator, time,
+				readings)) continue;
+			table.column(timeColumn)[r] = time;
+			Eigen::Matrix3d matrices [4];
+			bool complete = true;
+			for(size_t s = 0; s < 4; s++) {
+				if(isnan(readings[s][0])) { complete = false; continue; }
+				for(size_t i = 0; i < 7; i++) table.column(rawColumns[s][i])[r] = readings[s][i];
+				sensorToConfig(readings[s], config);
+				for(size_t i = 0; i < 6; i++) table.column(poseColumns[s][i])[r] = config(i);
+				matrices[s] = configToMatrix(config);
+			}
+			if(complete) {
+				table.column(angleColumns[0])[r] = palmAngle(matrices[0]);
+				for(size_t s = 1; s < 4; s++) table.column(angleColumns[s])[r] = fingerAngle(matrices[0], matrices[s]);
+			}
+		}
+	});
+
+	// Write the columns
+	mkdir(argv[2], 0755);
+	if(!table.write(argv[2])) {
+		fprintf(stderr, "Couldn't write the columns to %s: %s\n", argv[2], strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	printf("[export] %zu frames, %zu columns in %.3f s\n", n, table.numColumns(),
+		aa_tm_timespec2sec(aa_tm_now()) - start);
+
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file 06-benchLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Drives the liberty decode and angle code as fast as possible from synthetic frames over
+ * an in-process transport (or an existing ach channel for comparison) and reports the peak
+ * frames per second. The checksum of the angles only depends on the number of frames: it is
+ * compared with the angles computed from the synthetic readings without the transport and the
+ * decoding, and a mismatch (a regression after editing the pipeline, or another writer on the ach
+ * channel) or a lost frame exits with a failure.
+ * Usage: 06-benchLiberty [frames, default 1000000] [ach channel]
+ */
+
+#include <Eigen/Dense>
+#include "somatic.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include "transport.h"
+#include "Liberty.h"
+#include "Synthetic.h"
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	size_t numFrames = (argc > 1) ? atol(argv[1]) : 1000000;
+
+	// Pick the transport
+	MemoryChannel memory (16, 1024);
+	MemoryTransport memoryTransport (memory);
+	AchTransport achTransport;
+	Transport* transport = &memoryTransport;
+	if(argc > 2) {
+		ach_status_t r = achTransport.open(argv[2]);
+		if(r != ACH_OK) {
+			fprintf(stderr, "Couldn't open channel %s: %s\n", argv[2], ach_result_to_string(r));
+			exit(EXIT_FAILURE);
+		}
+		ach_flush(achTransport.handle());	// skip the old frames
+		transport = &achTransport;
+	}
+
+	// Pack a second of frames at 240 Hz up front so that only the pipeline is measured
+	const size_t numPacked = 240;
+	SyntheticLiberty synthetic;
+	vector <vector <uint8_t> > packed (numPacked, vector <uint8_t> (1024));
+	for(size_t i = 0; i < numPacked; i++) packed[i].resize(synthetic.pack(i / 240.0, 0.1, &packed[i][0], 1024));
+
+	// The angles of the same frames straight from the readings
+	vector <double> angles (numPacked);
+	double readings [4][7];
+	for(size_t i = 0; i < numPacked; i++) {
+		synthetic.sample(i / 240.0, readings);
+		Pose <RobotFrame> palm = sensorToPose(readings[0]);
+		angles[i] = palmAngle(palm) + fingerAngle(palm, sensorToPose(readings[1])) +
+			fingerAngle(palm, sensorToPose(readings[2])) + fingerAngle(palm, sensorToPose(readings[3]));
+	}
+	double expected = 0.0;
+	for(size_t i = 0; i < numFrames; i++) expected += angles[i % numPacked];
+
+	// Put a frame, get it back, decode it and compute the angles
+	Pose <RobotFrame> poses [4];
+	uint8_t buffer [1024];
+	double checksum = 0.0;
+	size_t decoded = 0;
+	double start = aa_tm_timespec2sec(aa_tm_now());
+	for(size_t i = 0; i < numFrames; i++) {
+		const vector <uint8_t>& frame = packed[i % numPacked];
+		transport->put(&frame[0], frame.size());
+		size_t size = 0;
+		ach_status_t r = transport->get(buffer, sizeof(buffer), &size, NULL, 0);
+		if(!(r == ACH_OK || r == ACH_MISSED_FRAME)) continue;
+		if(!decodeLiberty(buffer, size, &protobuf_c_system_allocator, poses)) continue;
+		checksum += palmAngle(poses[0]) + fingerAngle(poses[0], poses[1]) + fingerAngle(poses[0], poses[2]) +
+			fingerAngle(poses[0], poses[3]);
+		decoded++;
+	}
+	double elapsed = aa_tm_timespec2sec(aa_tm_now()) - start;
+
+	printf("[bench] %s: %zu/%zu frames in %.3f s, %.0f frames/s, %.0f ns/frame, checksum %.9f\n",
+		(transport == &memoryTransport) ? "memory" : argv[2], decoded, numFrames, elapsed, decoded / elapsed,
+		1e9 * elapsed / numFrames, checksum);
+	if(decoded != numFrames || !(fabs(checksum - expected) <= 1e-9 * max(1.0, fabs(expected)))) {
+		fprintf(stderr, "[bench] checksum %.9f of %zu frames, expected %.9f of %zu\n", checksum, decoded, expected,
+			numFrames);
+		exit(EXIT_FAILURE);
+	}
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,136 @@
+/**
+ * @file 07-armTeleop.cpp
+ * @date Oct 18, 2026
+ * @brief Makes Krang's arm follow the operator's palm (liberty sensor 1): every frame becomes an
+ * end-effector target which is solved with damped least-squares IK warm-started from the last
+ * solution and sent as a position command. The arm state is only read once to clutch in.
+ * Frames past their validity deadline are dropped; when the palm goes stale the arm holds,
+ * decays back to where it was engaged or disengages until the next fresh frame (the policy).
+ * Every command moves the joints at most IKParams::maxCommandStep from the last one.
+ * Usage: 07-armTeleop [arm state, default llwa-state] [arm command, default llwa-cmd] [scale]
+ *	[hold|decay|event, default hold]
+ */
+
+#include <Eigen/Dense>
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include "eventLoop.h"
+#include "metrics.h"
+#include "Liberty.h"
+#include "WorkspaceControl.h"
+#include "Deadline.h"
+
+somatic_d_opts_t somaticOptions;
+const char *libertyName = "liberty", *stateName = "llwa-state", *commandName = "llwa-cmd";
+
+// Runtime statistics, exported if METRICS_ENDPOINT is set
+MetricHistogram solveMetric ("armTeleop_solve_seconds", "Time to compute the target and solve the IK");
+MetricGauge errorMetric ("armTeleop_ik_error", "Pose error norm left after the last solve");
+MetricCounter commandsMetric ("armTeleop_commands", "Position commands sent", "channel=\"llwa-cmd\"");
+MetricCounter expiredMetric ("armTeleop_expired_frames", "Liberty frames dropped past their deadline",
+	"channel=\"liberty\"");
+MetricCounter stallsMetric ("armTeleop_stalls", "Times the palm pose went stale", "channel=\"liberty\"");
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+/// Sends the joint positions as a motor command
+void sendCommand(ach_channel_t* chan, const Vector7d& q) {
+	double values [7];
+	Eigen::Map <Vector7d> map (values);
+	map = q;
+	Somatic__Vector vector = SOMATIC__VECTOR__INIT;
+	vector.n_data = 7, vector.data = values;
+	Somatic__MotorCmd command = SOMATIC__MOTOR_CMD__INIT;
+	command.param = SOMATIC__MOTOR_PARAM__MOTOR_POSITION, command.has_param = 1;
+	command.values = &vector;
+	ach_status_t r = SOMATIC_PACK_SEND(chan, somatic__motor_cmd, &command);
+	if(r != ACH_OK) fprintf(stderr, "Couldn't send the arm command: %s\n", ach_result_to_string(r));
+	else commandsMetric.add();
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Read the channel names and the workspace scaling
+	if(argc > 1) stateName = argv[1];
+	if(argc > 2) commandName = argv[2];
+	WorkspaceControl control;
+	if(argc > 3) control.scale = atof(argv[3]);
+	DeadlineParams deadlineParams;
+	if(argc > 4 && !parseStalePolicy(argv[4], deadlineParams.policy)) {
+		fprintf(stderr, "Unknown stale policy '%s', use hold, decay or event\n", argv[4]);
+		exit(EXIT_FAILURE);
+	}
+	DeadlineGuard guard (deadlineParams);
+
+	// Set the somatic context options
+	somaticOptions.ident = "07-armTeleop";
+	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE;
+	somaticOptions.skip_mlock = 1;
+	metricsServe(getenv("METRICS_ENDPOINT"));
+
+	EventLoop loop (somaticOptions);
+	ach_channel_t* commandChannel = loop.publish(commandName);
+
+	// Keep the latest measured arm configuration for clutching in
+	Vector7d measured;
+	bool haveState = false;
+	loop.subscribe(stateName, [&](const uint8_t* frame, size_t size, ach_status_t) {
+		Somatic__MotorState* state = somatic__motor_state__unpack(&(loop.daemon()->pballoc), size, frame);
+		if(state == NULL || state->position == NULL || state->position->n_data < 7) return;
+		for(size_t i = 0; i < 7; i++) measured(i) = state->position->data[i];
+		haveState = true;
+	}, true);
+
+	// Follow the palm with every new liberty frame that is still valid
+	Pose <RobotFrame> poses [4];
+	Vector7d command, engagedAt;
+	bool decayed = false;
+	loop.subscribe(libertyName, [&](const uint8_t* frame, size_t size, ach_status_t) {
+		double until, start = metricsNow();
+		if(!decodeLiberty(frame, size, &(loop.daemon()->pballoc), poses, &until)) return;
+		if(!guard.accept(until, start)) {
+			expiredMetric.add();
+			return;
+		}
+		Eigen::Isometry3d palm = poses[0].isometry();
+		if(decayed) control.disengage(), decayed = false;		// clutch in again from where the arm is
+		if(!control.engaged()) {
+			if(!haveState) return;
+			control.engage(palm, measured);
+			engagedAt = measured;
+			cout << "[armTeleop] engaged at q = " << measured.transpose() << endl;
+		}
+		control.update(palm, command);
+		solveMetric.observe(metricsNow() - start);
+		errorMetric.set(control.error());
+		sendCommand(commandChannel, command);
+	}, true);
+
+	// Apply the policy while the palm is stale: holding needs nothing as the arm keeps the last
+	// position command
+	loop.every(0.01, [&]() {
+		double now = metricsNow();
+		if(!control.engaged() || !guard.stale(now)) return;
+		if(guard.stalled(now)) {
+			stallsMetric.add();
+			fprintf(stderr, "[armTeleop] palm pose stale, %s\n", stalePolicyName(deadlineParams.policy));
+		}
+		if(deadlineParams.policy == STALE_DECAY) {
+			double decay = guard.decay(now);
+			Vector7d decaying = (1.0 - decay) * command + decay * engagedAt;
+			control.limit(decaying);
+			sendCommand(commandChannel, decaying);
+			decayed = true;
+			if(decay >= 1.0) control.disengage();
+		}
+		else if(deadlineParams.policy == STALE_EVENT) control.disengage();
+	});
+
+	loop.run();
+	return 0;
+}
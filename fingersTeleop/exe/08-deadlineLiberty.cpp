@@ -0,0 +1,113 @@
+/**
+ * @file 08-deadlineLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Runs synthetic liberty frames through an in-process transport and the deadline guard on
+ * a simulated clock: frames delivered in time, frames delivered late, and a publisher stall
+ * under each policy. Prints each check and exits with a failure if one does not hold, then
+ * reports the cost of checking a frame with a real clock read.
+ * Usage: 08-deadlineLiberty [validity (s), default 0.1]
+ */
+
+#include <Eigen/Dense>
+#include "check.h"
+#include "somatic.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include "metrics.h"
+#include "transport.h"
+#include "Liberty.h"
+#include "Synthetic.h"
+#include "Deadline.h"
+
+using namespace Eigen;
+using namespace std;
+
+double validity = 0.1;
+const double period = 1.0 / 240.0;
+MemoryChannel channel (16, 1024);
+MemoryTransport transport (channel);
+SyntheticLiberty synthetic;
+
+/* ********************************************************************************************* */
+/// Publishes the frame of the given time, receives it at the given time and passes it to the guard
+bool deliver(DeadlineGuard& guard, double sent, double received) {
+	uint8_t buffer [1024];
+	transport.put(buffer, synthetic.pack(sent, validity, buffer, sizeof(buffer)));
+	size_t size = 0;
+	ach_status_t r = transport.get(buffer, sizeof(buffer), &size, NULL, 0);
+	if(!(r == ACH_OK || r == ACH_MISSED_FRAME)) return false;
+	Pose <RobotFrame> poses [4];
+	double until;
+	if(!decodeLiberty(buffer, size, &protobuf_c_system_allocator, poses, &until)) return false;
+	return guard.accept(until, received);
+}
+
+/* ********************************************************************************************* */
+/// Sends a second of frames, stops for two seconds while polling at 100 Hz as a consumer's timer
+/// would, and then sends one more frame
+void stall(StalePolicy policy) {
+
+	DeadlineParams params;
+	params.policy = policy;
+	params.decayTime = 0.5;
+	DeadlineGuard guard (params);
+	double t = 0.0;
+	for(size_t i = 0; i < 240; i++, t += period) deliver(guard, t, t + 0.002);
+	double lastSent = t - period;
+
+	size_t events = 0;
+	double halfway = -1.0, full = -1.0;
+	for(double now = t; now < t + 2.0; now += 0.01) {
+		if(!guard.stale(now)) continue;
+		if(guard.stalled(now)) events++;
+		double decay = guard.decay(now);
+		if(halfway < 0.0 && decay >= 0.5) halfway = now;
+		if(full < 0.0 && decay >= 1.0) full = now;
+	}
+
+	char what [128];
+	sprintf(what, "%s: one stall reported", stalePolicyName(policy));
+	check("deadline", events == 1 && guard.stalls() == 1, what);
+	sprintf(what, "%s: decays halfway at the deadline + 0.25 s", stalePolicyName(policy));
+	check("deadline", fabs(halfway - (lastSent + validity + 0.25)) < 0.011, what);
+	sprintf(what, "%s: fully decayed at the deadline + 0.5 s", stalePolicyName(policy));
+	check("deadline", fabs(full - (lastSent + validity + 0.5)) < 0.011, what);
+
+	t += 2.0;
+	sprintf(what, "%s: fresh again after the next frame", stalePolicyName(policy));
+	check("deadline", deliver(guard, t, t + 0.002) && !guard.stale(t + 0.002) && guard.decay(t + 0.002) == 0.0, what);
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	if(argc > 1) validity = atof(argv[1]);
+
+	// Frames received within their validity are all used
+	DeadlineGuard onTime;
+	double t = 0.0;
+	for(size_t i = 0; i < 240; i++, t += period) deliver(onTime, t, t + validity / 2.0);
+	check("deadline", onTime.accepted() == 240 && onTime.expired() == 0, "frames in time are accepted");
+
+	// Frames received after it are all dropped and counted, and the guard never becomes fresh
+	DeadlineGuard late;
+	for(size_t i = 0; i < 240; i++, t += period) deliver(late, t, t + 2.0 * validity);
+	check("deadline", late.accepted() == 0 && late.expired() == 240, "late frames are dropped and counted");
+	check("deadline", late.stale(t) && late.decay(t) == 1.0 && !late.stalled(t),
+		"no frame yet is stale but not a stall");
+
+	// A stall under each policy; the guard reports the same timing and the consumer acts on it
+	stall(STALE_HOLD);
+	stall(STALE_DECAY);
+	stall(STALE_EVENT);
+
+	// The cost of a check with the clock read a consumer does per frame
+	const size_t numChecks = 10000000;
+	DeadlineGuard guard;
+	double start = metricsNow();
+	for(size_t i = 0; i < numChecks; i++) guard.accept(start + 1e3, metricsNow());
+	double elapsed = metricsNow() - start;
+	printf("[deadline] %.1f ns per frame (clock read and check)\n", 1e9 * elapsed / numChecks);
+
+	checkExit("deadline");
+}
@@ -0,0 +1,102 @@
+/**
+ * @file 09-codecLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Measures the PoseCodec on a recording of packed liberty frames (see 04-recordLiberty) or,
+ * without one, on a minute of synthetic frames at 240 Hz: the packed and the encoded sizes, the
+ * largest position and angle errors after decoding and the encode and decode times per frame.
+ * Usage: 09-codecLiberty [recording, - for synthetic] [keyframe interval, default 240]
+ */
+
+#include <Eigen/Dense>
+#include "somatic.h"
+#include <somatic.pb-c.h>
+#include "Liberty.h"
+#include "Recording.h"
+#include "Synthetic.h"
+#include "PoseCodec.h"
+
+using namespace Eigen;
+using namespace std;
+
+/// A frame of readings and its time
+struct Frame {
+	double time, readings [4][7];
+};
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Read the frames and the sum of their packed sizes
+	vector <Frame> frames;
+	size_t packedBytes = 0;
+	if(argc > 1 && strcmp(argv[1], "-") != 0) {
+		RecordingReader recording;
+		if(!recording.open(argv[1]) || recording.encoded()) {
+			fprintf(stderr, "Couldn't read the packed recording %s\n", argv[1]);
+			exit(EXIT_FAILURE);
+		}
+		for(size_t r = 0; r < recording.size(); r++) {
+			Frame frame;
+			if(!unpackReadings(recording[r].message, recording[r].size, &protobuf_c_system_allocator, frame.time,
+				frame.readings) || isnan(frame.time)) continue;
+			frames.push_back(frame);
+			packedBytes += recording[r].size;
+		}
+	}
+	else {
+		SyntheticLiberty synthetic;
+		uint8_t buffer [1024];
+		frames.resize(240 * 60);
+		for(size_t i = 0; i < frames.size(); i++) {
+			frames[i].time = 1e4 + i / 240.0;
+			packedBytes += synthetic.pack(frames[i].time, 0.1, buffer, sizeof(buffer));
+			synthetic.sample(frames[i].time, frames[i].readings);
+		}
+	}
+	const size_t n = frames.size();
+	if(n == 0) {
+		fprintf(stderr, "No complete frames\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// Encode all the frames, then decode them
+	PoseCodecParams params;
+	if(argc > 2) params.keyframeInterval = atol(argv[2]);
+	PoseEncoder encoder (params);
+	PoseDecoder decoder (params);
+	vector <uint8_t> encoded (n * POSE_CODEC_MAX_FRAME);
+	vector <size_t> sizes (n);
+	size_t encodedBytes = 0;
+	double start = aa_tm_timespec2sec(aa_tm_now());
+	for(size_t i = 0; i < n; i++) {
+		sizes[i] = encoder.encode(frames[i].time, frames[i].readings, &encoded[i * POSE_CODEC_MAX_FRAME]);
+		encodedBytes += sizes[i];
+	}
+	double encodeTime = aa_tm_timespec2sec(aa_tm_now()) - start;
+	vector <Frame> decoded (n);
+	size_t numDecoded = 0;
+	start = aa_tm_timespec2sec(aa_tm_now());
+	for(size_t i = 0; i < n; i++)
+		numDecoded += decoder.decode(&encoded[i * POSE_CODEC_MAX_FRAME], sizes[i], decoded[i].time, decoded[i].readings);
+	double decodeTime = aa_tm_timespec2sec(aa_tm_now()) - start;
+
+	// Compare the decoded frames to the originals
+	double positionError = 0.0, angleError = 0.0, timeError = 0.0;
+	for(size_t i = 0; i < n; i++) {
+		timeError = max(timeError, fabs(decoded[i].time - frames[i].time));
+		for(size_t s = 0; s < 4; s++) {
+			const double *a = frames[i].readings[s], *b = decoded[i].readings[s];
+			positionError = max(positionError, (Vector3d(a[0], a[1], a[2]) - Vector3d(b[0], b[1], b[2])).norm());
+			angleError = max(angleError, Quaterniond(a[6], a[3], a[4], a[5]).normalized().angularDistance(
+				Quaterniond(b[6], b[3], b[4], b[5])));
+		}
+	}
+
+	printf("[codec] %zu frames, %zu decoded\n", n, numDecoded);
+	printf("[codec] packed %.1f bytes/frame, encoded %.1f bytes/frame, %.1fx smaller\n", (double) packedBytes / n,
+		(double) encodedBytes / n, (double) packedBytes / encodedBytes);
+	printf("[codec] largest errors: position %.2g m, angle %.2g rad, time %.2g s\n", positionError, angleError,
+		timeError);
+	printf("[codec] encode %.0f ns/frame, decode %.0f ns/frame\n", 1e9 * encodeTime / n, 1e9 * decodeTime / n);
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,175 @@
+/**
+ * @file 10-bridgeLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Carries a liberty channel to another machine. The sending side subscribes to the channel
+ * and sends its frames in batches over UDP or TCP; the receiving side puts them on a local channel
+ * of the same kind. With 'latest' only the newest frame matters: it is sent right away and the
+ * receiver republishes only the newest of what arrived together. With 'compact' (both sides) the
+ * frames travel as PoseCodec frames, and delta frames are only used over TCP without 'latest'.
+ * The metadata times are then moved to the receiver's clock; otherwise the frames are forwarded
+ * byte for byte and their deadlines only hold if the two clocks are synchronized.
+ * Usage: 10-bridgeLiberty send <channel> <udp|tcp://host:port> [latest] [compact]
+ *	10-bridgeLiberty receive <udp|tcp://host:port> <channel> [latest] [compact]
+ */
+
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include <string.h>
+#include "eventLoop.h"
+#include "metrics.h"
+#include "Bridge.h"
+#include "CompactLiberty.h"
+
+somatic_d_opts_t somaticOptions;
+
+// Runtime statistics, exported if METRICS_ENDPOINT is set
+MetricCounter sentMetric ("bridgeLiberty_sent_frames", "Frames sent to the receiver");
+MetricCounter droppedMetric ("bridgeLiberty_dropped_frames", "Frames not sent as the socket was not ready");
+MetricCounter receivedMetric ("bridgeLiberty_received_frames", "Frames received and republished");
+MetricCounter lostMetric ("bridgeLiberty_lost_frames", "Gaps in the frame sequence");
+MetricHistogram latencyMetric ("bridgeLiberty_latency_seconds", "From the sender's receipt to the republish");
+
+/* ********************************************************************************************* */
+/// Sends the frames of the channel until interrupted
+void runSender(const char* channel, const struct sockaddr_in& address, const BridgeParams& params) {
+
+	EventLoop loop (somaticOptions);
+	BridgeSender sender (params);
+	sender.open(address);
+	CompactLibertyEncoder encoder (params);
+	size_t connections = 0;
+	uint8_t encoded [POSE_CODEC_MAX_FRAME];
+
+	// Queue every frame (or the newest) with its receipt time
+	loop.subscribe(channel, [&](const uint8_t* frame, size_t size, ach_status_t) {
+		double now = bridgeMonotonic();
+		if(!params.compact) {
+			sender.push(frame, size, now);
+			return;
+		}
+
+		// A new connection has to start from a keyframe
+		if(sender.connections() != connections) encoder.reset(), connections = sender.connections();
+		size_t encodedSize = 0;
+		float validity = 0.0f;
+		if(!encoder.encode(frame, size, &(loop.daemon()->pballoc), encoded, encodedSize, validity)) return;
+		sender.push(encoded, encodedSize, now, validity);
+	}, params.latestOnly);
+
+	// Flush the batches that waited long enough, and send the queued ones when the socket has room
+	loop.every(params.flushTimeout / 2, [&]() { sender.poll(bridgeMonotonic()); });
+	loop.readable(sender.fd(), [&]() { sender.resume(bridgeMonotonic()); });
+
+	// Report once a second
+	size_t lastFrames = 0, lastDropped = 0;
+	loop.every(1.0, [&]() {
+		sentMetric.add(sender.frames() - lastFrames);
+		droppedMetric.add(sender.dropped() - lastDropped);
+		printf("[bridge] sent %zu frames/s, %zu batches, %zu dropped, %zu bytes\n", sender.frames() - lastFrames,
+			sender.batches(), sender.dropped(), sender.bytes());
+		fflush(stdout);
+		lastFrames = sender.frames(), lastDropped = sender.dropped();
+	});
+
+	loop.run();
+	sender.flush();
+}
+
+/* ********************************************************************************************* */
+/// Republishes the received frames on the channel until interrupted
+void runReceiver(const struct sockaddr_in& address, const char* channel, BridgeParams params) {
+
+	// No frame is larger than the memory of the channel it goes on
+	EventLoop loop (somaticOptions);
+	ach_channel_t* output = loop.publish(channel);
+	params.maxFrame = output->len;
+	BridgeReceiver receiver (params);
+	if(!receiver.open(params.tcp, address)) {
+		fprintf(stderr, "Couldn't open the bridge receiver: %s\n", strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	CompactLibertyDecoder decoder;
+	uint8_t packed [1024];
+	size_t published = 0;
+	double latencySum = 0.0, latencyMax = 0.0;
+
+	// Republish the frames; compact frames all have to be decoded as they may be deltas
+	loop.readable(receiver.fd(), [&]() {
+		receiver.receive([&](const BridgeFrame& frame) {
+			const uint8_t* data = frame.data;
+			size_t size = frame.size;
+			if(frame.compact) {
+				size = decoder.decode(frame, packed, sizeof(packed));
+				data = packed;
+				if(size == 0) return;
+			}
+			if(params.latestOnly && !frame.newest) return;
+			ach_status_t r = ach_put(output, data, size);
+			if(r != ACH_OK) {
+				fprintf(stderr, "Couldn't put the frame on %s: %s\n", channel, ach_result_to_string(r));
+				return;
+			}
+			published++;
+			receivedMetric.add();
+			latencyMetric.observe(frame.latency);
+			latencySum += frame.latency;
+			if(frame.latency > latencyMax) latencyMax = frame.latency;
+		});
+	});
+
+	// Report once a second
+	size_t lastPublished = 0, lastLost = 0;
+	loop.every(1.0, [&]() {
+		lostMetric.add(receiver.lost() - lastLost);
+		size_t n = published - lastPublished;
+		printf("[bridge] received %zu frames/s, %zu lost, %zu late, latency avg %.1f us max %.1f us\n", n,
+			receiver.lost(), receiver.late(), n ? 1e6 * latencySum / n : 0.0, 1e6 * latencyMax);
+		fflush(stdout);
+		lastPublished = published, lastLost = receiver.lost();
+		latencySum = latencyMax = 0.0;
+	});
+
+	loop.run();
+	printf("[bridge] %zu frames republished, %zu lost, %zu late, %zu malformed\n", published, receiver.lost(),
+		receiver.late(), receiver.malformed());
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Read the direction, the endpoints and the modes
+	bool sending = (argc > 1 && strcmp(argv[1], "send") == 0);
+	if(argc < 4 || !(sending || strcmp(argv[1], "receive") == 0)) {
+		fprintf(stderr, "Usage: %s send <channel> <udp|tcp://host:port> [latest] [compact]\n"
+			"       %s receive <udp|tcp://host:port> <channel> [latest] [compact]\n", argv[0], argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	const char* channel = sending ? argv[2] : argv[3];
+	const char* endpoint = sending ? argv[3] : argv[2];
+	BridgeParams params;
+	struct sockaddr_in address;
+	if(!parseEndpoint(endpoint, params.tcp, address)) {
+		fprintf(stderr, "Bad endpoint '%s', use udp://host:port or tcp://host:port\n", endpoint);
+		exit(EXIT_FAILURE);
+	}
+	for(int i = 4; i < argc; i++) {
+		if(strcmp(argv[i], "latest") == 0) params.latestOnly = true;
+		else if(strcmp(argv[i], "compact") == 0) params.compact = true;
+		else {
+			fprintf(stderr, "Unknown mode '%s', use latest or compact\n", argv[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// Set the somatic context options
+	somaticOptions.ident = sending ? "10-bridgeLiberty-send" : "10-bridgeLiberty-receive";
+	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE;
+	somaticOptions.skip_mlock = 1;
+	metricsServe(getenv("METRICS_ENDPOINT"));
+
+	if(sending) runSender(channel, address, params);
+	else runReceiver(address, channel, params);
+	exit(EXIT_SUCCESS);
+}
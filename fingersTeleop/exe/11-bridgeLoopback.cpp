@@ -0,0 +1,208 @@
+/**
+ * @file 11-bridgeLoopback.cpp
+ * @date Oct 18, 2026
+ * @brief Runs synthetic liberty frames through the bridge over 127.0.0.1 in one process, for
+ * UDP and TCP, batched and latest-only, raw and compact. Checks that the frames arrive in order,
+ * none is lost, raw frames are unchanged and compact ones decode within the codec steps. Over TCP
+ * also checks that a receiver that stops reading never blocks the sender, and that a batch header
+ * announcing more than a frame is refused before it is buffered. Prints the latencies and exits
+ * with a failure if a check does not hold.
+ * Usage: 11-bridgeLoopback [frames per mode, default 2400] [first port, default 47100]
+ */
+
+#include "check.h"
+#include "somatic.h"
+#include <somatic.pb-c.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <vector>
+#include "Bridge.h"
+#include "CompactLiberty.h"
+#include "Synthetic.h"
+
+using namespace std;
+
+size_t numFrames = 2400;
+int port = 47100;
+/* ********************************************************************************************* */
+/// Sends the frames of a 240 Hz stream in bursts with the given modes and checks what arrives
+void run(bool tcp, bool latestOnly, bool compact) {
+
+	BridgeParams params;
+	params.tcp = tcp, params.latestOnly = latestOnly, params.compact = compact;
+	char endpoint [64], name [64], what [128];
+	sprintf(endpoint, "%s://127.0.0.1:%d", tcp ? "tcp" : "udp", port++);
+	sprintf(name, "%s %s %s", tcp ? "tcp" : "udp", latestOnly ? "latest" : "batch", compact ? "compact" : "raw");
+	struct sockaddr_in address;
+	BridgeReceiver receiver;
+	if(!parseEndpoint(endpoint, params.tcp, address) || !receiver.open(params.tcp, address)) {
+		fprintf(stderr, "[loopback] %s: couldn't open %s: %s\n", name, endpoint, strerror(errno));
+		checksFailed()++;
+		return;
+	}
+	BridgeSender sender (params);
+	sender.open(address);
+
+	// Pack the frames up front; compact frames are encoded as the bridge sender would
+	SyntheticLiberty synthetic;
+	CompactLibertyEncoder encoder (params);
+	vector <vector <uint8_t> > sent (numFrames);
+	vector <float> validities (numFrames, 0.0f);
+	for(size_t i = 0; i < numFrames; i++) {
+		uint8_t packed [1024];
+		size_t size = synthetic.pack(i / 240.0, 0.1, packed, sizeof(packed));
+		if(!compact) { sent[i].assign(packed, packed + size); continue; }
+		sent[i].resize(POSE_CODEC_MAX_FRAME);
+		encoder.encode(packed, size, &protobuf_c_system_allocator, &sent[i][0], size, validities[i]);
+		sent[i].resize(size);
+	}
+
+	// Receive: check the order, the contents and the decoded readings
+	CompactLibertyDecoder decoder;
+	size_t received = 0, bad = 0, newest = 0;
+	long last = -1;
+	bool ordered = true;
+	double latencySum = 0.0, latencyMax = 0.0, errorMax = 0.0;
+	BridgeHandler handler = [&](const BridgeFrame& frame) {
+		if((long) frame.sequence <= last) ordered = false;
+		last = frame.sequence, received++, newest += frame.newest;
+		latencySum += frame.latency;
+		if(frame.latency > latencyMax) latencyMax = frame.latency;
+		if(!compact) {
+			if(latestOnly) return;
+			const vector <uint8_t>& original = sent[frame.sequence];
+			if(frame.size != original.size() || memcmp(frame.data, &original[0], frame.size) != 0) bad++;
+			return;
+		}
+		uint8_t packed [1024];
+		double time, until, readings [4][7], expected [4][7];
+		size_t size = decoder.decode(frame, packed, sizeof(packed));
+		if(size == 0 || !unpackReadings(packed, size, &protobuf_c_system_allocator, time, readings, &until)) {
+			bad++;
+			return;
+		}
+		size_t index = (size_t) floor(time * 240.0 + 0.5);
+		if(index >= numFrames || fabs(until - time - 0.1) > 1e-4) { bad++; return; }
+		synthetic.sample(index / 240.0, expected);
+		for(size_t s = 0; s < 4; s++)
+			for(size_t k = 0; k < 7; k++) errorMax = max(errorMax, fabs(readings[s][k] - expected[s][k]));
+	};
+
+	// Push the frames in bursts of 10 with a millisecond between them so that batches also flush
+	// on the timeout
+	struct epoll_event event;
+	for(size_t i = 0; i < numFrames; i++) {
+		double now = bridgeMonotonic();
+		sender.push(&sent[i][0], sent[i].size(), now, validities[i]);
+		sender.poll(now);
+		if(epoll_wait(receiver.fd(), &event, 1, 0) > 0) receiver.receive(handler);
+		if(i % 10 == 9) usleep(1000);
+	}
+	sender.flush();
+	for(double end = bridgeMonotonic() + 0.2; bridgeMonotonic() < end; ) {
+		sender.poll(bridgeMonotonic());
+		if(epoll_wait(receiver.fd(), &event, 1, 10) > 0) receiver.receive(handler);
+	}
+
+	printf("[loopback] %s: %zu frames in %zu batches, %zu dropped, %.1f bytes/frame, latency avg %.1f us "
+		"max %.1f us\n", name, sender.frames(), sender.batches(), sender.dropped(),
+		(double) sender.bytes() / max(sender.frames(), (size_t) 1), 1e6 * latencySum / max(received, (size_t) 1),
+		1e6 * latencyMax);
+	sprintf(what, "%s: all frames arrive in order", name);
+	check("loopback", ordered && received == sender.frames() && received + sender.dropped() == numFrames &&
+		receiver.lost() == 0 && receiver.late() == 0 && receiver.malformed() == 0, what);
+	if(!latestOnly) {
+		sprintf(what, "%s: nothing dropped", name);
+		check("loopback", sender.dropped() == 0, what);
+	}
+	sprintf(what, "%s: %s", name, compact ? "readings within the codec steps" : "frames unchanged");
+	check("loopback", bad == 0 && (!compact || errorMax < 1e-4), what);
+	sprintf(what, "%s: the last frame is the newest delivered", name);
+	check("loopback", last == (long) sender.frames() - 1 && newest > 0, what);
+}
+
+/* ********************************************************************************************* */
+/// Pushes frames at a TCP receiver that never reads them; the queue fills up and the frames are
+/// dropped, but no push waits for the socket
+void stalled() {
+
+	BridgeParams params;
+	params.tcp = true;
+	char endpoint [64];
+	sprintf(endpoint, "tcp://127.0.0.1:%d", port++);
+	struct sockaddr_in address;
+	BridgeReceiver receiver;
+	if(!parseEndpoint(endpoint, params.tcp, address) || !receiver.open(params.tcp, address)) {
+		fprintf(stderr, "[loopback] stalled: couldn't open %s: %s\n", endpoint, strerror(errno));
+		checksFailed()++;
+		return;
+	}
+	BridgeSender sender (params);
+	sender.open(address);
+	vector <uint8_t> frame (1000, 0x5a);
+	double slowest = 0.0;
+	for(size_t i = 0; i < 100000 && sender.dropped() == 0; i++) {
+		double start = bridgeMonotonic();
+		sender.push(&frame[0], frame.size(), start);
+		sender.flush();
+		slowest = max(slowest, bridgeMonotonic() - start);
+		if(i == 0) usleep(10000);			// connected
+	}
+	printf("[loopback] stalled: %zu frames sent, %zu dropped, slowest push %.1f us\n", sender.frames(),
+		sender.dropped(), 1e6 * slowest);
+	check("loopback", sender.dropped() > 0 && slowest < 0.05, "tcp: a stalled receiver does not block the sender");
+}
+
+/// Sends a batch header announcing a gigabyte to a TCP receiver
+void oversized() {
+
+	char endpoint [64];
+	sprintf(endpoint, "tcp://127.0.0.1:%d", port++);
+	bool tcp;
+	struct sockaddr_in address;
+	BridgeReceiver receiver;
+	int sock = socket(AF_INET, SOCK_STREAM, 0);
+	if(!parseEndpoint(endpoint, tcp, address) || !receiver.open(tcp, address) ||
+			connect(sock, (const struct sockaddr*) &address, sizeof(address)) != 0) {
+		fprintf(stderr, "[loopback] oversized: couldn't connect to %s: %s\n", endpoint, strerror(errno));
+		checksFailed()++;
+		close(sock);
+		return;
+	}
+	BridgeBatch header;
+	memset(&header, 0, sizeof(header));
+	header.magic = BRIDGE_MAGIC, header.bytes = 1u << 30, header.count = 1;
+	ssize_t n = send(sock, &header, sizeof(header), MSG_NOSIGNAL);
+	struct epoll_event event;
+	size_t delivered = 0;
+	for(double end = bridgeMonotonic() + 0.2; bridgeMonotonic() < end; )
+		if(epoll_wait(receiver.fd(), &event, 1, 10) > 0) receiver.receive([&](const BridgeFrame&) { delivered++; });
+
+	// The receiver closed the connection
+	char byte;
+	bool closed = (recv(sock, &byte, 1, MSG_DONTWAIT) == 0);
+	close(sock);
+	check("loopback", n == sizeof(header) && receiver.malformed() == 1 && delivered == 0 && closed,
+		"tcp: an oversized batch drops the connection");
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	if(argc > 1) numFrames = atol(argv[1]);
+	if(argc > 2) port = atoi(argv[2]);
+
+	for(int compact = 0; compact < 2; compact++) {
+		for(int latestOnly = 0; latestOnly < 2; latestOnly++) {
+			run(false, latestOnly, compact);
+			run(true, latestOnly, compact);
+		}
+	}
+	stalled();
+	oversized();
+
+	checkExit("loopback");
+}
@@ -0,0 +1,142 @@
+/**
+ * @file 12-decimateLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Reads the full-rate liberty channel once and republishes it at lower rates for the slow
+ * consumers (display, logger, retargeting), which then read only what they need and stop
+ * missing frames on the main channel. Each output frame is the average of the frames it stands
+ * for (see Decimator.h), and the outputs chain from the fastest to the slowest so that each rate
+ * must divide the one above it. A frame with a reading or a time that is not finite is dropped so
+ * that it does not spoil the averages. Create the output channels first, i.e. "ach mk liberty-60".
+ * Usage: 12-decimateLiberty [input, default liberty] [input rate (Hz), default 240]
+ *	[channel:rate ..., default liberty-60:60 liberty-10:10]
+ */
+
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "eventLoop.h"
+#include "metrics.h"
+#include "Liberty.h"
+#include "Decimator.h"
+#include "Deadline.h"
+
+somatic_d_opts_t somaticOptions;
+const char* libertyName = "liberty";
+
+// Runtime statistics, exported if METRICS_ENDPOINT is set
+MetricCounter inputMetric ("decimateLiberty_input_frames", "Full-rate frames read", "channel=\"liberty\"");
+MetricCounter missedMetric ("decimateLiberty_missed_frames", "Times full-rate frames were overwritten unread",
+	"channel=\"liberty\"");
+MetricCounter rejectedMetric ("decimateLiberty_rejected_frames", "Frames dropped for a reading that is not finite",
+	"channel=\"liberty\"");
+MetricCounter outputMetric ("decimateLiberty_output_frames", "Averaged frames published on all the outputs");
+
+/// An output channel and the stage that feeds it from the one above
+struct Output {
+	std::string name;
+	double rate;
+	LibertyDecimator decimator;
+	LibertyPacker packer;
+	ach_channel_t* channel;
+	size_t published;
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+using namespace std;
+
+/* ********************************************************************************************* */
+/// True if the time and every reading are finite
+bool finite(double time, const double readings [4][7]) {
+	if(!isfinite(time)) return false;
+	for(size_t s = 0; s < 4; s++) for(size_t k = 0; k < 7; k++) if(!isfinite(readings[s][k])) return false;
+	return true;
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Read the input and the output rates
+	if(argc > 1) libertyName = argv[1];
+	double inputRate = (argc > 2) ? atof(argv[2]) : 240.0;
+	vector <string> specs;
+	for(int i = 3; i < argc; i++) specs.push_back(argv[i]);
+	if(specs.empty()) specs.push_back("liberty-60:60"), specs.push_back("liberty-10:10");
+
+	// Set up the stages from the fastest; each factor is relative to the stage above
+	vector <Output*> outputs;
+	double previousRate = inputRate;
+	for(size_t i = 0; i < specs.size(); i++) {
+		size_t colon = specs[i].rfind(':');
+		double rate = (colon == string::npos) ? 0.0 : atof(specs[i].c_str() + colon + 1);
+		double factor = (rate > 0.0) ? previousRate / rate : 0.0;
+		if(factor < 1.0 || fabs(factor - floor(factor + 0.5)) > 1e-6) {
+			fprintf(stderr, "Bad output '%s': use channel:rate with each rate dividing the one before (%g Hz)\n",
+				specs[i].c_str(), previousRate);
+			exit(EXIT_FAILURE);
+		}
+		Output* output = new Output();
+		output->name = specs[i].substr(0, colon);
+		output->rate = rate;
+		output->decimator = LibertyDecimator((size_t) floor(factor + 0.5));
+		output->published = 0;
+		outputs.push_back(output);
+		previousRate = rate;
+	}
+
+	// Set the somatic context options
+	somaticOptions.ident = "12-decimateLiberty";
+	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE;
+	somaticOptions.skip_mlock = 1;
+	metricsServe(getenv("METRICS_ENDPOINT"));
+
+	EventLoop loop (somaticOptions);
+	for(size_t i = 0; i < outputs.size(); i++) outputs[i]->channel = loop.publish(outputs[i]->name.c_str());
+
+	// Feed every frame down the chain of stages as far as it completes windows
+	size_t input = 0, missed = 0, rejected = 0;
+	const double defaultValidity = DeadlineParams().defaultValidity;
+	loop.subscribe(libertyName, [&](const uint8_t* frame, size_t size, ach_status_t result) {
+		if(result == ACH_MISSED_FRAME) missed++, missedMetric.add();
+		double time, until, readings [4][7];
+		if(!unpackReadings(frame, size, &(loop.daemon()->pballoc), time, readings, &until)) return;
+		input++, inputMetric.add();
+		if(!finite(time, readings)) {
+			rejected++, rejectedMetric.add();
+			return;
+		}
+		if(isnan(until)) until = time + defaultValidity;
+		for(size_t i = 0; i < outputs.size(); i++) {
+			Output& output = *outputs[i];
+			if(!output.decimator.add(time, until, readings)) break;
+			time = output.decimator.time(), until = output.decimator.until();
+			memcpy(readings, output.decimator.output(), sizeof(readings));
+			uint8_t packed [1024];
+			size_t packedSize = output.packer.pack(time, until, readings, packed, sizeof(packed));
+			ach_status_t r = ach_put(output.channel, packed, packedSize);
+			if(r != ACH_OK) {
+				fprintf(stderr, "Couldn't put the frame on %s: %s\n", output.name.c_str(), ach_result_to_string(r));
+				continue;
+			}
+			output.published++, outputMetric.add();
+		}
+	});
+
+	// Report once a second
+	loop.every(1.0, [&]() {
+		printf("[decimate] %zu input frames, %zu missed, %zu rejected", input, missed, rejected);
+		for(size_t i = 0; i < outputs.size(); i++)
+			printf(", %s %zu", outputs[i]->name.c_str(), outputs[i]->published);
+		printf("\n");
+		fflush(stdout);
+	});
+
+	loop.run();
+	for(size_t i = 0; i < outputs.size(); i++) delete outputs[i];
+	return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file 13-aliasLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Shows why the decimated channels average instead of skipping frames. A minute of
+ * synthetic frames at 240 Hz gets a tremor at 97 Hz (1 mm and 1 degree), and the 240 -> 60 -> 10
+ * Hz chain of 12-decimateLiberty is compared with keeping every 24th frame: the tremor that is
+ * left in the 10 Hz stream is what a slow consumer would see as drift. Also checks the quaternion
+ * average itself, prints each check and exits with a failure if one does not hold, and reports
+ * the cost per input frame.
+ * Usage: 13-aliasLiberty [tremor frequency (Hz), default 97]
+ */
+
+#include <Eigen/Dense>
+#include <math.h>
+#include <string.h>
+#include "check.h"
+#include "metrics.h"
+#include "Synthetic.h"
+#include "Decimator.h"
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+/// The largest position and angle differences between two sets of readings
+void difference(const double a [4][7], const double b [4][7], double& position, double& angle) {
+	position = angle = 0.0;
+	for(size_t s = 0; s < 4; s++) {
+		position = max(position, (Vector3d(a[s][0], a[s][1], a[s][2]) - Vector3d(b[s][0], b[s][1], b[s][2])).norm());
+		Quaterniond qa (a[s][6], a[s][3], a[s][4], a[s][5]), qb (b[s][6], b[s][3], b[s][4], b[s][5]);
+		angle = max(angle, qa.angularDistance(qb));
+	}
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	double tremor = (argc > 1) ? atof(argv[1]) : 97.0;
+	const size_t numFrames = 240 * 60;
+
+	// The clean and the trembling streams go through the same chain; the decimation is linear in
+	// the positions so the difference of the outputs is the tremor that got through
+	SyntheticLiberty synthetic;
+	LibertyDecimator clean60 (4), clean10 (6), shaky60 (4), shaky10 (6);
+	double averagedPosition = 0.0, averagedAngle = 0.0, skippedPosition = 0.0, skippedAngle = 0.0;
+	size_t numOutputs = 0;
+	for(size_t i = 0; i < numFrames; i++) {
+		double time = i / 240.0, clean [4][7], shaky [4][7];
+		synthetic.sample(time, clean);
+		memcpy(shaky, clean, sizeof(shaky));
+		double phase = 2.0 * M_PI * tremor * time;
+		Quaterniond shake (AngleAxisd(M_PI / 180.0 * sin(phase + 1.0), Vector3d::UnitX()));
+		for(size_t s = 0; s < 4; s++) {
+			for(size_t k = 0; k < 3; k++) shaky[s][k] += 1e-3 * sin(phase + k);
+			Quaterniond q = Quaterniond(clean[s][6], clean[s][3], clean[s][4], clean[s][5]) * shake;
+			shaky[s][3] = q.x(), shaky[s][4] = q.y(), shaky[s][5] = q.z(), shaky[s][6] = q.w();
+		}
+
+		// Every 24th frame as it is
+		double position, angle;
+		if(i % 24 == 23) {
+			difference(clean, shaky, position, angle);
+			skippedPosition += position * position, skippedAngle += angle * angle;
+		}
+
+		// The averaging chain
+		bool done = clean60.add(time, time, clean) && clean10.add(clean60.time(), clean60.until(), clean60.output());
+		bool shakyDone = shaky60.add(time, time, shaky) && shaky10.add(shaky60.time(), shaky60.until(), shaky60.output());
+		if(done != shakyDone) checksFailed()++;
+		if(!done) continue;
+		difference(clean10.output(), shaky10.output(), position, angle);
+		averagedPosition += position * position, averagedAngle += angle * angle;
+		numOutputs++;
+	}
+	averagedPosition = sqrt(averagedPosition / numOutputs), averagedAngle = sqrt(averagedAngle / numOutputs);
+	skippedPosition = sqrt(skippedPosition / numOutputs), skippedAngle = sqrt(skippedAngle / numOutputs);
+	printf("[alias] %.0f Hz tremor at 10 Hz: skipping %.3f mm %.3f deg rms, averaging %.3f mm %.3f deg rms\n",
+		tremor, 1e3 * skippedPosition, 180.0 / M_PI * skippedAngle, 1e3 * averagedPosition,
+		180.0 / M_PI * averagedAngle);
+	check("alias", numOutputs == numFrames / 24, "one 10 Hz frame per 24 input frames");
+	check("alias", averagedPosition < skippedPosition / 5.0 && averagedAngle < skippedAngle / 5.0,
+		"averaging removes at least 80% of the aliased tremor");
+
+	// The average of the same orientation with either sign is that orientation, on the side of the
+	// last sample, and the time is the middle of the window
+	LibertyDecimator decimator (4);
+	double readings [4][7];
+	synthetic.sample(1.0, readings);
+	double flipped [4][7];
+	memcpy(flipped, readings, sizeof(flipped));
+	for(size_t s = 0; s < 4; s++) for(size_t k = 3; k < 7; k++) flipped[s][k] = -readings[s][k];
+	decimator.add(0.0, 0.1, readings), decimator.add(0.1, 0.2, flipped), decimator.add(0.2, 0.3, readings);
+	bool ready = decimator.add(0.3, 0.4, flipped);
+	double position, angle, sign = 1.0;
+	difference(decimator.output(), readings, position, angle);
+	for(size_t s = 0; s < 4; s++) for(size_t k = 3; k < 7; k++) sign = min(sign, decimator.output()[s][k] * flipped[s][k]);
+	check("alias", ready && position < 1e-12 && angle < 1e-6,
+		"quaternions of either sign average to the same orientation");
+	check("alias", sign >= 0.0, "the average keeps the sign of the last quaternion");
+	check("alias", fabs(decimator.time() - 0.15) < 1e-12 && fabs(decimator.until() - 0.8) < 1e-12,
+		"the output is mid-window and valid one window longer");
+
+	// The cost of the chain per input frame
+	double frames [240][4][7];
+	for(size_t i = 0; i < 240; i++) synthetic.sample(i / 240.0, frames[i]);
+	LibertyDecimator stage60 (4), stage10 (6);
+	const size_t numRuns = 2000000;
+	double start = metricsNow();
+	for(size_t i = 0; i < numRuns; i++) {
+		double time = i / 240.0;
+		if(stage60.add(time, time, frames[i % 240])) stage10.add(stage60.time(), stage60.until(), stage60.output());
+	}
+	double elapsed = metricsNow() - start;
+	printf("[alias] %.1f ns per input frame (240 -> 60 -> 10 Hz)\n", 1e9 * elapsed / numRuns);
+
+	checkExit("alias");
+}
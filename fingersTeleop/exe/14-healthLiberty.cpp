@@ -0,0 +1,110 @@
+/**
+ * @file 14-healthLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Checks every liberty frame before the other consumers see it (see SensorHealth.h): the
+ * checked frames, with outliers replaced by the last good reading and limit violations clamped,
+ * are put on the "liberty-clean" channel and a HealthReport with the quality score of each
+ * sensor on the "liberty-health" channel, as the raw versioned struct (see SensorHealth.h, read
+ * it with readHealthReport). Create them first, i.e. "ach mk liberty-clean".
+ * Usage: 14-healthLiberty [input, default liberty] [clean output] [health output] [clamp|reject]
+ */
+
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include <math.h>
+#include <string.h>
+#include "eventLoop.h"
+#include "metrics.h"
+#include "Liberty.h"
+#include "SensorHealth.h"
+#include "Deadline.h"
+
+somatic_d_opts_t somaticOptions;
+const char *libertyName = "liberty", *cleanName = "liberty-clean", *healthName = "liberty-health";
+
+// Runtime statistics, exported if METRICS_ENDPOINT is set
+MetricCounter framesMetric ("healthLiberty_frames", "Frames checked", "channel=\"liberty\"");
+MetricCounter rejectedMetric ("healthLiberty_rejected_readings", "Sensor readings replaced by the last good one");
+MetricCounter clampedMetric ("healthLiberty_clamped_readings", "Sensor readings clamped to the limits");
+MetricHistogram checkMetric ("healthLiberty_check_seconds", "Time to check the 4 readings of a frame");
+MetricGauge scoreMetrics [4] = {
+	{"healthLiberty_palm_score", "Quality of the palm sensor from 0 to 1"},
+	{"healthLiberty_finger1_score", "Quality of the first finger sensor from 0 to 1"},
+	{"healthLiberty_finger2_score", "Quality of the second finger sensor from 0 to 1"},
+	{"healthLiberty_finger3_score", "Quality of the third finger sensor from 0 to 1"}
+};
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	// Read the channel names and the handling of limit violations
+	if(argc > 1) libertyName = argv[1];
+	if(argc > 2) cleanName = argv[2];
+	if(argc > 3) healthName = argv[3];
+	HealthParams params;
+	if(argc > 4) {
+		if(strcmp(argv[4], "reject") == 0) params.clamp = false;
+		else if(strcmp(argv[4], "clamp") != 0) {
+			fprintf(stderr, "Unknown mode '%s', use clamp or reject\n", argv[4]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// Set the somatic context options
+	somaticOptions.ident = "14-healthLiberty";
+	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE;
+	somaticOptions.skip_mlock = 1;
+	metricsServe(getenv("METRICS_ENDPOINT"));
+
+	EventLoop loop (somaticOptions);
+	ach_channel_t* cleanChannel = loop.publish(cleanName);
+	ach_channel_t* healthChannel = loop.publish(healthName);
+
+	// Check every frame and pass it on with the same stamps
+	LibertyHealth health (params);
+	LibertyPacker packer;
+	HealthReport report;
+	bool reported = false;
+	const double defaultValidity = DeadlineParams().defaultValidity;
+	loop.subscribe(libertyName, [&](const uint8_t* frame, size_t size, ach_status_t) {
+		double time, until, readings [4][7];
+		if(!unpackReadings(frame, size, &(loop.daemon()->pballoc), time, readings, &until)) return;
+		double start = metricsNow();
+		if(isnan(time)) time = start;
+		if(isnan(until)) until = time + defaultValidity;
+		health.check(time, readings, report);
+		checkMetric.observe(metricsNow() - start);
+		framesMetric.add();
+		for(size_t s = 0; s < 4; s++) {
+			if(report.verdict[s] == HEALTH_REJECTED) rejectedMetric.add();
+			else if(report.verdict[s] == HEALTH_CLAMPED) clampedMetric.add();
+			scoreMetrics[s].set(report.score[s]);
+		}
+		reported = true;
+
+		uint8_t packed [1024];
+		size_t packedSize = packer.pack(time, until, readings, packed, sizeof(packed));
+		ach_status_t r = ach_put(cleanChannel, packed, packedSize);
+		if(r != ACH_OK) fprintf(stderr, "Couldn't put the frame on %s: %s\n", cleanName, ach_result_to_string(r));
+		r = ach_put(healthChannel, &report, sizeof(report));
+		if(r != ACH_OK) fprintf(stderr, "Couldn't put the report on %s: %s\n", healthName, ach_result_to_string(r));
+	});
+
+	// Print the scores once a second
+	loop.every(1.0, [&]() {
+		if(!reported) return;
+		printf("[health] scores");
+		for(size_t s = 0; s < 4; s++) {
+			const SensorHealth& sensor = health.sensor(s);
+			printf(" %.2f (%.2f mm, %zu rejected, %zu clamped)", sensor.score(), 1e3 * sensor.noise(),
+				sensor.rejected(), sensor.clamped());
+		}
+		printf("\n");
+		fflush(stdout);
+	});
+
+	loop.run();
+	return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file 15-glitchLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Runs a minute of synthetic liberty frames at 240 Hz with injected tracker glitches through
+ * the health checks: single frame jumps, NaNs, non-unit quaternions, five seconds of field
+ * distortion noise on one finger and a sensor that really moves. Prints each check and exits with
+ * a failure if one does not hold, then reports the cost of checking a frame.
+ * Usage: 15-glitchLiberty [clamp|reject, default clamp]
+ */
+
+#include <Eigen/Dense>
+#include <math.h>
+#include <string.h>
+#include "check.h"
+#include "metrics.h"
+#include "Synthetic.h"
+#include "SensorHealth.h"
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	HealthParams params;
+	if(argc > 1) params.clamp = (strcmp(argv[1], "reject") != 0);
+
+	// The glitches: frames of jumps, NaNs and bad quaternions, distortion of finger 2 from 20 to 25
+	// s and finger 3 moved by 20 cm from 40 s on
+	const size_t numFrames = 240 * 60, distortionStart = 240 * 20, distortionEnd = 240 * 25;
+	const size_t moveStart = 240 * 40;
+	SyntheticLiberty synthetic;
+	LibertyHealth health (params);
+	srand(7);
+	size_t numGlitches = 0, passed = 0, falseAlarms = 0, reseededAt = 0;
+	double worstGlitchError = 0.0, distortedScore = 1.0, cleanScore = 1.0;
+	for(size_t i = 0; i < numFrames; i++) {
+		double time = i / 240.0, clean [4][7], readings [4][7];
+		synthetic.sample(time, clean);
+		memcpy(readings, clean, sizeof(readings));
+		for(size_t k = 0; k < 3; k++) if(i >= moveStart) readings[3][k] = clean[3][k] += 0.2;
+
+		// One glitch every half second on a random sensor, away from the distortion
+		int glitched = -1;
+		bool distorted = (i >= distortionStart && i < distortionEnd);
+		if(i % 120 == 60 && !distorted && i > 240) {
+			glitched = rand() % 4;
+			double* r = readings[glitched];
+			switch(numGlitches++ % 3) {
+				case 0: r[rand() % 3] += 0.05 * (rand() % 2 ? 1 : -1); break;
+				case 1: r[rand() % 7] = NAN; break;
+				case 2: for(size_t k = 3; k < 7; k++) r[k] *= 1.5; break;
+			}
+		}
+		if(distorted) for(size_t k = 0; k < 3; k++) readings[2][k] += 0.003 * (2.0 * rand() / RAND_MAX - 1.0);
+
+		HealthReport report;
+		health.check(time, readings, report);
+
+		// What came out of the glitches, the alarms on clean samples and the scores
+		for(size_t s = 0; s < 4; s++) {
+			double error = (Vector3d(readings[s][0], readings[s][1], readings[s][2]) -
+				Vector3d(clean[s][0], clean[s][1], clean[s][2])).norm();
+			if((int) s == glitched) {
+				worstGlitchError = max(worstGlitchError, error);
+				if(report.verdict[s] == HEALTH_OK) passed++;
+			}
+			else if(!(s == 2 && distorted) && !(s == 3 && i >= moveStart && i < moveStart + params.reseedAfter) &&
+				report.verdict[s] != HEALTH_OK) falseAlarms++;
+		}
+		if(reseededAt == 0 && i >= moveStart && report.verdict[3] == HEALTH_RESEEDED) reseededAt = i;
+		if(i == distortionEnd - 1) distortedScore = report.score[2];
+		if(i == numFrames - 1) cleanScore = min(min(report.score[0], report.score[1]), report.score[2]);
+	}
+
+	printf("[glitch] %zu glitches, worst error after the check %.2f mm, %zu false alarms, finger 2 score "
+		"%.2f distorted and %.2f at the end\n", numGlitches, 1e3 * worstGlitchError, falseAlarms, distortedScore,
+		cleanScore);
+	check("glitch", passed == 0, "no glitch passes as a good sample");
+	check("glitch", worstGlitchError < 0.005, "the glitches are held within 5 mm of the truth");
+	check("glitch", falseAlarms < numFrames * 4 / 1000, "fewer than 0.1% false alarms on clean samples");
+	check("glitch", distortedScore < 0.5, "the distorted finger's score drops below 0.5");
+	check("glitch", cleanScore > 0.8, "the scores recover after the distortion");
+	check("glitch", reseededAt > 0 && reseededAt <= moveStart + params.reseedAfter,
+		"a sensor that really moved is followed again");
+
+	// The cost of checking the 4 readings of a frame
+	double frames [240][4][7];
+	for(size_t i = 0; i < 240; i++) synthetic.sample(i / 240.0, frames[i]);
+	LibertyHealth timed (params);
+	HealthReport report;
+	const size_t numRuns = 1000000;
+	double start = metricsNow();
+	for(size_t i = 0; i < numRuns; i++) {
+		double readings [4][7];
+		memcpy(readings, frames[i % 240], sizeof(readings));
+		timed.check(100.0 + i / 240.0, readings, report);
+	}
+	double elapsed = metricsNow() - start;
+	printf("[glitch] %.1f ns per frame (4 sensors)\n", 1e9 * elapsed / numRuns);
+
+	checkExit("glitch");
+}
@@ -0,0 +1,270 @@
+/**
+ * @file 16-teleopController.cpp
+ * @date Oct 18, 2026
+ * @brief The whole teleoperation chain in one process with the core library (see FingersCore.h)
+ * instead of 14-healthLiberty, 02-graspDetector and 07-armTeleop chained over ach: every liberty
+ * frame is checked, converted, classified and retargeted in the callback that reads it, the arm
+ * command goes out on the command channel and grasp changes on the grasp channel. The stale
+ * policy is the one of 07-armTeleop. With "synthetic" it instead runs synthetic frames through
+ * the chain without ach and reports the cost of a frame for each entry point. The parameters of
+ * the chain can be changed while it runs from the file in FINGERS_CONFIG (see liveConfig.h and
+ * parseFingersParam); a change applies from the next frame on. With "playout" the arm is not
+ * retargeted in the frame callback but on a 500 Hz control clock, from the palm pose played out of
+ * a jitter buffer (see Playout.h), so that the commands are as smooth as the hand motion and not
+ * as irregular as the frame arrivals.
+ * Usage: 16-teleopController [liberty] [arm state] [arm command] [grasp] [scale] [hold|decay|event]
+ *        [direct|playout]
+ *        16-teleopController synthetic [frames, default 1000000]
+ */
+
+#include <Eigen/Dense>
+#include "somatic.h"
+#include "somatic/daemon.h"
+#include <somatic.pb-c.h>
+#include <ach.h>
+#include <string.h>
+#include <vector>
+#include "eventLoop.h"
+#include "metrics.h"
+#include "liveConfig.h"
+#include "FingersCore.h"
+#include "Playout.h"
+#include "Synthetic.h"
+
+somatic_d_opts_t somaticOptions;
+const char *libertyName = "liberty", *stateName = "llwa-state", *commandName = "llwa-cmd";
+const char *graspName = "grasp";
+
+// Runtime statistics, exported if METRICS_ENDPOINT is set
+MetricHistogram frameMetric ("teleopController_frame_seconds", "Time from a liberty frame to the arm command");
+MetricGauge errorMetric ("teleopController_ik_error", "Pose error norm left after the last solve");
+MetricCounter commandsMetric ("teleopController_commands", "Position commands sent", "channel=\"llwa-cmd\"");
+MetricCounter droppedMetric ("teleopController_dropped_frames", "Liberty frames dropped as expired or unusable",
+	"channel=\"liberty\"");
+MetricCounter stallsMetric ("teleopController_stalls", "Times the palm pose went stale", "channel=\"liberty\"");
+MetricGauge delayMetric ("teleopController_playout_delay_seconds", "Delay of the played palm pose behind the clock");
+MetricCounter underrunsMetric ("teleopController_playout_underruns", "Control ticks without a newer palm pose");
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+/// Sends the joint positions as a motor command
+void sendCommand(ach_channel_t* chan, const Vector7d& q) {
+	double values [7];
+	Eigen::Map <Vector7d> map (values);
+	map = q;
+	Somatic__Vector vector = SOMATIC__VECTOR__INIT;
+	vector.n_data = 7, vector.data = values;
+	Somatic__MotorCmd command = SOMATIC__MOTOR_CMD__INIT;
+	command.param = SOMATIC__MOTOR_PARAM__MOTOR_POSITION, command.has_param = 1;
+	command.values = &vector;
+	ach_status_t r = SOMATIC_PACK_SEND(chan, somatic__motor_cmd, &command);
+	if(r != ACH_OK) fprintf(stderr, "Couldn't send the arm command: %s\n", ach_result_to_string(r));
+	else commandsMetric.add();
+}
+
+/* ********************************************************************************************* */
+/// Runs synthetic 240 Hz frames through the chain and prints the cost of a frame packed (without
+/// the packing, which is measured first), as readings and with the arm retargeting
+void benchmark(size_t numFrames) {
+
+	// A second of readings, repeated with increasing stamps
+	const size_t numSamples = 240;
+	SyntheticLiberty synthetic;
+	vector <double> samples (numSamples * 4 * 7);
+	for(size_t i = 0; i < numSamples; i++) synthetic.sample(i / 240.0, (double (*)[7]) &samples[i * 28]);
+	LibertyPacker packer;
+	uint8_t packed [1024];
+	double start = metricsNow();
+	for(size_t i = 0; i < numFrames; i++)
+		packer.pack(i / 240.0, i / 240.0 + 0.1, (const double (*)[7]) &samples[(i % numSamples) * 28], packed, 1024);
+	double packing = (metricsNow() - start) / numFrames;
+
+	const char* names [] = {"packed", "readings", "readings + arm"};
+	Vector7d measured = Vector7d::Constant(0.3), command;
+	for(size_t mode = 0; mode < 3; mode++) {
+		FingersCore core;
+		HandFrame hand;
+		size_t numUsed = 0, numChanges = 0;
+		start = metricsNow();
+		for(size_t i = 0; i < numFrames; i++) {
+			double time = i / 240.0;
+			const double (*readings)[7] = (const double (*)[7]) &samples[(i % numSamples) * 28];
+			bool ok;
+			if(mode == 0) {
+				size_t size = packer.pack(time, time + 0.1, readings, packed, 1024);
+				ok = core.process(packed, size, &protobuf_c_system_allocator, time, hand);
+			}
+			else ok = core.process(time, time + 0.1, readings, time, hand);
+			if(ok && mode == 2) ok = core.retarget(hand, &measured, command);
+			numUsed += ok;
+			numChanges += (ok && hand.graspChanged);
+		}
+		double elapsed = (metricsNow() - start) / numFrames - ((mode == 0) ? packing : 0.0);
+		printf("[teleop] %-16s %8.1f ns per frame, %zu of %zu frames used, %zu grasp changes\n", names[mode],
+			1e9 * elapsed, numUsed, numFrames, numChanges);
+	}
+	printf("[teleop] packing a frame took %.1f ns\n", 1e9 * packing);
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	if(argc > 1 && strcmp(argv[1], "synthetic") == 0) {
+		benchmark((argc > 2) ? atol(argv[2]) : 1000000);
+		exit(EXIT_SUCCESS);
+	}
+
+	// Read the channel names, the workspace scaling and the stale policy
+	if(argc > 1) libertyName = argv[1];
+	if(argc > 2) stateName = argv[2];
+	if(argc > 3) commandName = argv[3];
+	if(argc > 4) graspName = argv[4];
+	FingersCoreParams params;
+	if(argc > 5) params.scale = atof(argv[5]);
+	if(argc > 6 && !parseStalePolicy(argv[6], params.deadline.policy)) {
+		fprintf(stderr, "Unknown stale policy '%s', use hold, decay or event\n", argv[6]);
+		exit(EXIT_FAILURE);
+	}
+	bool playout = (argc > 7 && strcmp(argv[7], "playout") == 0);
+	if(argc > 7 && !playout && strcmp(argv[7], "direct") != 0) {
+		fprintf(stderr, "Unknown mode '%s', use direct or playout\n", argv[7]);
+		exit(EXIT_FAILURE);
+	}
+
+	// Watch the config file; its values replace the arguments
+	LiveConfig <FingersCoreParams> config (params);
+	ConfigWatcher <FingersCoreParams> watcher (config, getenv("FINGERS_CONFIG"), parseFingersParam, validFingersParams);
+	LiveConfig <FingersCoreParams>::Reader reader (config);
+	FingersCore core (*reader.get());
+	uint64_t configured = reader.version();
+	DeadlineGuard& guard = core.deadline();
+
+	// Set the somatic context options
+	somaticOptions.ident = "16-teleopController";
+	somaticOptions.sched_rt = SOMATIC_D_SCHED_NONE;
+	somaticOptions.skip_mlock = 1;
+	metricsServe(getenv("METRICS_ENDPOINT"));
+	traceStart(getenv("TRACE"));
+
+	EventLoop loop (somaticOptions);
+	ach_channel_t* commandChannel = loop.publish(commandName);
+	ach_channel_t* graspChannel = loop.publish(graspName);
+
+	// Keep the latest measured arm configuration for clutching in
+	Vector7d measured;
+	bool haveState = false;
+	loop.subscribe(stateName, [&](const uint8_t* frame, size_t size, ach_status_t) {
+		Somatic__MotorState* state = somatic__motor_state__unpack(&(loop.daemon()->pballoc), size, frame);
+		if(state == NULL || state->position == NULL || state->position->n_data < 7) return;
+		for(size_t i = 0; i < 7; i++) measured(i) = state->position->data[i];
+		haveState = true;
+	}, true);
+
+	// Follows the palm, clutching in again from where the arm is after a decay
+	HandFrame hand;
+	Vector7d command, engagedAt;
+	bool decayed = false;
+	auto follow = [&](const HandFrame& hand, double start) {
+		if(decayed) core.disengage(), decayed = false;
+		bool engaging = !core.engaged();
+		bool ok;
+		{
+			TRACE_SCOPE("retarget");
+			ok = core.retarget(hand, haveState ? &measured : NULL, command);
+		}
+		if(!ok) return;
+		if(engaging) {
+			engagedAt = measured;
+			cout << "[teleop] engaged at q = " << measured.transpose() << endl;
+		}
+		frameMetric.observe(metricsNow() - start);
+		errorMetric.set(core.workspace().error());
+		sendCommand(commandChannel, command);
+	};
+
+	// The palm poses (x, y, z, qx, qy, qz, qw) of the frames for the control clock
+	PlayoutBuffer buffer (7, vector <size_t> (1, 3));
+
+	// Run every new liberty frame through the chain and act on it
+	loop.subscribe(libertyName, [&](const uint8_t* frame, size_t size, ach_status_t) {
+		double start = metricsNow();
+		const FingersCoreParams* current = reader.get();
+		if(reader.version() != configured) {
+			core.configure(*current);
+			configured = reader.version();
+		}
+		bool ok;
+		{
+			TRACE_SCOPE("chain");
+			ok = core.process(frame, size, &(loop.daemon()->pballoc), start, hand);
+		}
+		if(!ok) {
+			droppedMetric.add();
+			return;
+		}
+
+		// Publish a grasp change
+		if(hand.graspChanged) {
+			GraspEvent event;
+			event.hand = 0;
+			event.state = hand.grasp;
+			event.previous = core.grasp().previousState();
+			event.time = hand.time;
+			for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) event.flexion[i] = core.grasp().finger(i).mean();
+			ach_status_t r = ach_put(graspChannel, &event, sizeof(event));
+			if(r != ACH_OK) fprintf(stderr, "Couldn't send the grasp event: %s\n", ach_result_to_string(r));
+			printf("[teleop] grasp %s -> %s\n", graspStateName((GraspState) event.previous), graspStateName(hand.grasp));
+			fflush(stdout);
+		}
+
+		// Follow the palm now or queue its pose for the control clock
+		if(!playout) {
+			follow(hand, start);
+			return;
+		}
+		const Pose <RobotFrame>& palm = hand.poses[0];
+		double values [7] = {palm.position.x(), palm.position.y(), palm.position.z(), palm.orientation.x(),
+			palm.orientation.y(), palm.orientation.z(), palm.orientation.w()};
+		buffer.push(hand.time, values, start);
+	}, true);
+
+	// Follow the played palm on a strict clock while it is fresh; the stale policy is below
+	if(playout) loop.every(1.0 / 500, [&]() {
+		double now = metricsNow(), values [7];
+		if(guard.stale(now)) return;
+		PlayoutResult result = buffer.sample(now, values);
+		if(result == PLAYOUT_EMPTY) return;
+		if(result == PLAYOUT_UNDERRUN) underrunsMetric.add();
+		delayMetric.set(buffer.delay());
+		HandFrame played = hand;
+		played.poses[0] = Pose <RobotFrame> (Vector3d(values[0], values[1], values[2]),
+			Quaterniond(values[6], values[3], values[4], values[5]).normalized());
+		follow(played, now);
+	});
+
+	// Apply the policy while the palm is stale: holding needs nothing as the arm keeps the last
+	// position command
+	loop.every(0.01, [&]() {
+		double now = metricsNow();
+		if(!core.engaged() || !guard.stale(now)) return;
+		if(guard.stalled(now)) {
+			stallsMetric.add();
+			fprintf(stderr, "[teleop] palm pose stale, %s\n", stalePolicyName(guard.params().policy));
+		}
+		if(guard.params().policy == STALE_DECAY) {
+			double decay = guard.decay(now);
+			Vector7d decaying = (1.0 - decay) * command + decay * engagedAt;
+			core.limit(decaying);
+			sendCommand(commandChannel, decaying);
+			decayed = true;
+			if(decay >= 1.0) core.disengage();
+		}
+		else if(guard.params().policy == STALE_EVENT) core.disengage();
+	});
+
+	loop.run();
+	printf("[teleop] %zu frames used, %zu expired\n", guard.accepted(), guard.expired());
+	return 0;
+}
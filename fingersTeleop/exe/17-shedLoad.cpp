@@ -0,0 +1,101 @@
+/**
+ * @file 17-shedLoad.cpp
+ * @date Oct 18, 2026
+ * @brief Runs a 240 Hz loop with a critical command output (0.4 ms), a normal logging output (0.6
+ * ms) and a best effort display (1 ms) for six seconds, the middle two of which make every
+ * output 2.5 times slower as a busy host would, once without and once with the load shedder (see
+ * shedder.h). Prints what was shed and the rate of the command output, checks that the command
+ * holds its rate under the stress only with the shedder and that the display comes back after
+ * it, and exits with a failure if a check does not hold.
+ * Usage: 17-shedLoad [stress factor, default 2.5]
+ */
+
+#include <math.h>
+#include <time.h>
+#include "check.h"
+#include "metrics.h"
+#include "shedder.h"
+
+/* ********************************************************************************************* */
+/// Keeps the thread busy for the given time, like a slow output
+void work(double seconds) {
+	double end = metricsNow() + seconds;
+	while(metricsNow() < end) {}
+}
+
+/// What a run measured
+struct Result {
+	double rates [3];				///< Of the command output before, during and after the stress (Hz)
+	uint64_t displayed [3];		///< Display outputs in the same phases
+	uint64_t logged [3];
+	size_t levels [3];				///< The highest shedding step reached
+};
+
+/* ********************************************************************************************* */
+/// Runs the loop on an absolute 240 Hz schedule; a late cycle starts right away
+Result runLoop(bool shedding, double stress) {
+
+	const double period = 1.0 / 240, phase = 2.0;
+	LoadShedder shedder (shedding ? "shedLoad" : "shedLoadOff", period);
+	size_t command = shedder.add("command", SHED_CRITICAL, 4e-4);
+	size_t logging = shedder.add("logging", SHED_NORMAL, 6e-4);
+	size_t display = shedder.add("display", SHED_BEST_EFFORT, 1e-3);
+
+	Result result;
+	uint64_t commands [3] = {0, 0, 0};
+	for(size_t p = 0; p < 3; p++) result.displayed[p] = result.logged[p] = result.levels[p] = 0;
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	double start = metricsNow();
+	for(double now = start; now - start < 3 * phase; now = metricsNow()) {
+		size_t p = (size_t) ((now - start) / phase);
+		double factor = (p == 1) ? stress : 1.0;
+
+		// Without the shedder every output runs every cycle
+		shedder.begin();
+		shedder.run(command, [&]() { work(4e-4 * factor); });
+		commands[p]++;
+		if(!shedding || shedder.run(logging, [&]() { work(6e-4 * factor); })) {
+			if(!shedding) work(6e-4 * factor);
+			result.logged[p]++;
+		}
+		if(!shedding || shedder.run(display, [&]() { work(1e-3 * factor); })) {
+			if(!shedding) work(1e-3 * factor);
+			result.displayed[p]++;
+		}
+		shedder.end();
+		result.levels[p] = std::max(result.levels[p], shedder.level());
+
+		// Sleep until the next period unless late
+		next.tv_nsec += (long) (period * 1e9);
+		if(next.tv_nsec >= 1000000000) next.tv_sec++, next.tv_nsec -= 1000000000;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	for(size_t p = 0; p < 3; p++) result.rates[p] = commands[p] / phase;
+	printf("[shed] %-8s command %5.1f / %5.1f / %5.1f Hz, logging %4lu / %4lu / %4lu, display %4lu / %4lu / %4lu, "
+		"shed %lu logging and %lu display\n", shedding ? "shedding" : "off", result.rates[0], result.rates[1],
+		result.rates[2], (unsigned long) result.logged[0], (unsigned long) result.logged[1],
+		(unsigned long) result.logged[2], (unsigned long) result.displayed[0], (unsigned long) result.displayed[1],
+		(unsigned long) result.displayed[2], (unsigned long) shedder.shed(logging), (unsigned long) shedder.shed(display));
+	return result;
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	double stress = (argc > 1) ? atof(argv[1]) : 2.5;
+	printf("[shed] before / during / after a stress of %.1fx\n", stress);
+	Result off = runLoop(false, stress);
+	Result on = runLoop(true, stress);
+
+	check("shed", off.rates[1] < 0.9 * 240, "without shedding the command rate drops under the stress");
+	check("shed", on.rates[1] > 0.98 * 240, "with shedding the command holds 240 Hz under the stress");
+	check("shed", on.rates[0] > 0.98 * 240 && on.rates[2] > 0.98 * 240, "... and before and after it");
+	check("shed", on.displayed[0] > 0.75 * 480, "the display mostly runs before the stress");
+	check("shed", on.levels[1] >= 2 && on.displayed[1] < on.displayed[0] / 2,
+		"the display is shed to 1 in 4 under the stress");
+	check("shed", on.logged[1] > on.displayed[1], "the logging is shed less than the display");
+	check("shed", on.displayed[2] > on.displayed[0] / 2, "the display comes back after the stress");
+
+	checkExit("shed");
+}
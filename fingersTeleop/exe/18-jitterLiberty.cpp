@@ -0,0 +1,123 @@
+/**
+ * @file 18-jitterLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Simulates 20 s of synthetic 240 Hz liberty frames that reach a 500 Hz control clock with
+ * a random scheduling delay: a busy host for the first 10 s (2 ms on average and 2% of the frames
+ * 10 to 20 ms late) and a calm one after. The palm position commanded from the newest frame, as
+ * the consumers of getLiberty do, is compared with the one from the playout buffer (see
+ * Playout.h) for roughness (the RMS of the second differences per tick), underruns and delay.
+ * Prints each check and exits with a failure if one does not hold, then reports the cost of a
+ * frame and a tick.
+ * Usage: 18-jitterLiberty [seed, default 1]
+ */
+
+#include <Eigen/Dense>
+#include <math.h>
+#include <stdlib.h>
+#include "check.h"
+#include "metrics.h"
+#include "Synthetic.h"
+#include "Playout.h"
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+/// The RMS of the second differences of a position stream
+struct Roughness {
+	Vector3d previous [2];
+	size_t count;
+	double sum;
+	Roughness () : count(0), sum(0.0) {}
+	void add (const Vector3d& p) {
+		if(count >= 2) sum += (p - 2.0 * previous[1] + previous[0]).squaredNorm();
+		previous[0] = previous[1], previous[1] = p;
+		count++;
+	}
+	double rms () const { return (count > 2) ? sqrt(sum / (count - 2)) : 0.0; }
+};
+
+/* ********************************************************************************************* */
+/// An exponential random number with the given mean
+double exponential(double mean, unsigned int& state) {
+	return -mean * log(1.0 - rand_r(&state) / (RAND_MAX + 1.0));
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	unsigned int state = (argc > 1) ? atoi(argv[1]) : 1;
+	const double framePeriod = 1.0 / 240, tick = 1.0 / 500, duration = 20.0, calmFrom = 10.0;
+
+	// The frames and their arrival times, in order as on an ach channel
+	SyntheticLiberty synthetic;
+	const size_t numFrames = (size_t) (duration / framePeriod);
+	vector <double> arrivals (numFrames);
+	for(size_t k = 0; k < numFrames; k++) {
+		double stamp = k * framePeriod, delay = 5e-4;
+		if(stamp < calmFrom) {
+			delay += exponential(2e-3, state);
+			if(rand_r(&state) % 50 == 0) delay += 0.01 + 0.01 * rand_r(&state) / RAND_MAX;
+		}
+		else delay += exponential(2e-4, state);
+		arrivals[k] = max(stamp + delay, (k > 0) ? arrivals[k - 1] : 0.0);
+	}
+
+	// Run the control clock over them
+	vector <size_t> quaternions (1, 3);
+	PlayoutBuffer buffer (7, quaternions);
+	Roughness truth, direct, playout;
+	double readings [4][7], newest [7], played [7], lastPlayed = -INFINITY;
+	double busyDelay = 0.0, calmDelay = 0.0, maxDelay = 0.0;
+	size_t next = 0, busyTicks = 0, calmTicks = 0, busyUnderruns = 0, calmUnderruns = 0;
+	bool monotonic = true, haveFrame = false;
+	for(double now = 0.0; now < duration; now += tick) {
+		while(next < numFrames && arrivals[next] <= now) {
+			synthetic.sample(next * framePeriod, readings);
+			buffer.push(next * framePeriod, readings[0], arrivals[next]);
+			for(size_t i = 0; i < 7; i++) newest[i] = readings[0][i];
+			haveFrame = true;
+			next++;
+		}
+		if(!haveFrame) continue;
+		double time;
+		PlayoutResult result = buffer.sample(now, played, &time);
+		monotonic &= (time >= lastPlayed);
+		lastPlayed = time;
+		maxDelay = max(maxDelay, buffer.delay());
+
+		// Skip the first second while the delay settles
+		if(now < 1.0) continue;
+		synthetic.sample(now, readings);
+		truth.add(Vector3d(readings[0][0], readings[0][1], readings[0][2]));
+		direct.add(Vector3d(newest[0], newest[1], newest[2]));
+		playout.add(Vector3d(played[0], played[1], played[2]));
+		if(now < calmFrom) busyTicks++, busyUnderruns += (result == PLAYOUT_UNDERRUN), busyDelay += buffer.delay();
+		else if(now > calmFrom + 2.0) calmTicks++, calmUnderruns += (result == PLAYOUT_UNDERRUN), calmDelay += buffer.delay();
+	}
+	busyDelay /= busyTicks, calmDelay /= calmTicks;
+
+	printf("[jitter] roughness (um per tick^2): tracker %.3f, newest frame %.3f, playout %.3f\n", 1e6 * truth.rms(),
+		1e6 * direct.rms(), 1e6 * playout.rms());
+	printf("[jitter] delay %.1f ms busy and %.1f ms calm (max %.1f), underruns %.2f%% busy and %.2f%% calm\n",
+		1e3 * busyDelay, 1e3 * calmDelay, 1e3 * maxDelay, 100.0 * busyUnderruns / busyTicks,
+		100.0 * calmUnderruns / calmTicks);
+	check("jitter", playout.rms() < direct.rms() / 50, "the playout is 50 times smoother than the newest frame");
+	check("jitter", busyUnderruns < busyTicks / 100, "fewer than 1% underruns on the busy host");
+	check("jitter", calmUnderruns == 0, "no underruns on the calm host");
+	check("jitter", calmDelay < busyDelay / 2, "the delay shrinks by half once the host is calm");
+	check("jitter", maxDelay <= PlayoutParams().maxDelay, "the delay stays within its bound");
+	check("jitter", monotonic, "the played time never goes back");
+
+	// The cost of a frame and a tick at the same rates
+	PlayoutBuffer timed (7, quaternions);
+	const size_t numRuns = 1000000;
+	double start = metricsNow();
+	for(size_t i = 0; i < numRuns; i++) {
+		if(i % 2 == 0) timed.push(i * tick * 0.5, readings[0], i * tick * 0.5 + 1e-3);
+		timed.sample(i * tick * 0.5 + 1e-3, played);
+	}
+	printf("[jitter] %.1f ns per tick with a frame every other tick\n", 1e9 * (metricsNow() - start) / numRuns);
+
+	checkExit("jitter");
+}
@@ -0,0 +1,169 @@
+/**
+ * @file 19-lazyLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Runs synthetic liberty frames through the lazy graph of 01-printLiberty (see
+ * LibertyGraph.h) and checks that the subscribed outputs match the eager computation, that a
+ * node is computed once per frame however many outputs read it, only while something needs it
+ * and never for a branch without subscribers, that a filter sees every frame when it is read
+ * less often and that an expired frame leaves the outputs of the last one. Then reports the cost of a frame with every output, with one finger angle and with
+ * one finger angle after a new derived node was added, against computing everything eagerly.
+ * Exits with a failure if a check does not hold.
+ * Usage: 19-lazyLiberty [frames, default 200000]
+ */
+
+#include <Eigen/Dense>
+#include <math.h>
+#include <stdlib.h>
+#include "check.h"
+#include "metrics.h"
+#include "Synthetic.h"
+#include "LibertyGraph.h"
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+/// What printLiberty computed for every frame before the graph
+struct Eager {
+	Pose <RobotFrame> poses [4];
+	Matrix3d matrices [4];
+	double angles [4];
+
+	void compute (const double readings [4][7]) {
+		for(size_t i = 0; i < 4; i++) poses[i] = sensorToPose(readings[i]);
+		for(size_t i = 0; i < 4; i++) matrices[i] = poses[i].orientation.toRotationMatrix();
+		angles[0] = palmAngle(poses[0]);
+		for(size_t i = 1; i < 4; i++) angles[i] = fingerAngle(poses[0], poses[i]);
+	}
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/* ********************************************************************************************* */
+/// The health checks are off so that the eager readings are the ones the graph sees
+FingersCoreParams uncheckedParams() {
+	FingersCoreParams params;
+	params.checkHealth = false;
+	return params;
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	const size_t numFrames = (argc > 1) ? atol(argv[1]) : 200000, numChecked = 2400;
+	SyntheticLiberty synthetic;
+	double readings [4][7];
+	Eager eager;
+
+	// Every output against the eager computation
+	LibertyGraph all (uncheckedParams());
+	double sink = 0.0, error = 0.0;
+	for(size_t i = 0; i < 4; i++) {
+		all.graph().subscribe(LIBERTY_MATRIX + i, [&, i]() { sink += all.matrix(i)(0, 0); });
+		all.graph().subscribe(LIBERTY_ANGLE + i, [&, i]() { sink += all.angle(i); });
+	}
+	size_t numRuns = 0;
+	for(size_t k = 0; k < numChecked; k++) {
+		double time = k / 240.0;
+		synthetic.sample(time, readings);
+		if(!all.frame(time, time + 0.1, readings, time)) continue;
+		numRuns += all.run();
+		eager.compute(readings);
+		for(size_t i = 0; i < 4; i++) {
+			error = max(error, (all.matrix(i) - eager.matrices[i]).cwiseAbs().maxCoeff());
+			error = max(error, fabs(all.angle(i) - eager.angles[i]));
+			error = max(error, (all.pose(i).position - eager.poses[i].position).cwiseAbs().maxCoeff());
+		}
+	}
+	check("lazy", numRuns == 8 * numChecked && error < 1e-12, "every output matches the eager computation");
+	check("lazy", all.graph().evaluations(LIBERTY_POSE) == numChecked, "the palm pose is computed once for 7 outputs");
+
+	// One finger angle: its pose and the palm's, nothing else
+	LibertyGraph one (uncheckedParams());
+	size_t handle = one.graph().subscribe(LIBERTY_ANGLE + 2, [&]() { sink += one.angle(2); });
+	for(size_t k = 0; k < numChecked; k++) {
+		synthetic.sample(k / 240.0, readings);
+		if(one.frame(k / 240.0, k / 240.0 + 0.1, readings, k / 240.0)) one.run();
+	}
+	const LazyGraph& graph = one.graph();
+	size_t others = 0;
+	for(size_t i = 0; i < 4; i++) others += graph.evaluations(LIBERTY_MATRIX + i) + graph.evaluations(LIBERTY_FILTERED + i);
+	others += graph.evaluations(LIBERTY_POSE + 1) + graph.evaluations(LIBERTY_POSE + 3);
+	others += graph.evaluations(LIBERTY_ANGLE) + graph.evaluations(LIBERTY_ANGLE + 1) + graph.evaluations(LIBERTY_ANGLE + 3);
+	check("lazy", graph.evaluations(LIBERTY_ANGLE + 2) == numChecked &&
+		graph.evaluations(LIBERTY_POSE + 2) == numChecked && others == 0, "one finger angle computes only its branch");
+
+	// Nothing downstream once it unsubscribes
+	one.graph().unsubscribe(handle);
+	uint64_t before = graph.evaluations(LIBERTY_POSE);
+	for(size_t k = 0; k < 240; k++) if(one.frame(k / 240.0 + 20, k / 240.0 + 20.1, readings, k / 240.0 + 20)) one.run();
+	check("lazy", graph.evaluations(LIBERTY_POSE) == before && !graph.demanded(LIBERTY_POSE),
+		"an unsubscribed branch stops being computed");
+
+	// A filter read at 10 Hz still sees every 240 Hz frame
+	LibertyGraph filtered (uncheckedParams());
+	filtered.graph().subscribe(LIBERTY_FILTERED + 1, [&]() { sink += filtered.filtered(1); });
+	double reference = NAN, lastTime = NAN, filterError = 0.0;
+	for(size_t k = 0; k < numChecked; k++) {
+		double time = k / 240.0;
+		synthetic.sample(time, readings);
+		if(!filtered.frame(time, time + 0.1, readings, time)) continue;
+		eager.compute(readings);
+		if(isnan(reference)) reference = eager.angles[1];
+		else reference += (1.0 - exp(-(time - lastTime) / 0.05)) * (eager.angles[1] - reference);
+		lastTime = time;
+		if(k % 24 != 0) continue;
+		filtered.run();
+		filterError = max(filterError, fabs(filtered.filtered(1) - reference));
+	}
+	check("lazy", filtered.graph().evaluations(LIBERTY_FILTERED + 1) == numChecked && filterError < 1e-12,
+		"a filter read at 10 Hz is updated for every frame");
+
+	// An expired frame is dropped before the graph moves on: the last outputs are still printed
+	double kept = filtered.filtered(1);
+	uint64_t evaluated = filtered.graph().evaluations(LIBERTY_FILTERED + 1);
+	synthetic.sample(numChecked / 240.0, readings);
+	bool dropped = !filtered.frame(numChecked / 240.0, numChecked / 240.0 - 0.1, readings, numChecked / 240.0);
+	check("lazy", dropped && filtered.run() == 1 && filtered.filtered(1) == kept &&
+		filtered.graph().evaluations(LIBERTY_FILTERED + 1) == evaluated, "an expired frame keeps the last outputs");
+
+	// The cost of a frame, without the decode
+	vector <double> samples (240 * 28);
+	for(size_t k = 0; k < 240; k++) synthetic.sample(k / 240.0, (double (*)[7]) &samples[k * 28]);
+	double costs [4];
+	const char* names [] = {"eager", "graph, every output", "graph, one angle", "graph, one angle + new node"};
+	for(size_t mode = 0; mode < 4; mode++) {
+		LibertyGraph timed (uncheckedParams());
+		if(mode == 1) for(size_t i = 0; i < 4; i++) {
+			timed.graph().subscribe(LIBERTY_MATRIX + i, [&, i]() { sink += timed.matrix(i)(0, 0); });
+			timed.graph().subscribe(LIBERTY_ANGLE + i, [&, i]() { sink += timed.angle(i); });
+		}
+		if(mode >= 2) timed.graph().subscribe(LIBERTY_ANGLE + 2, [&]() { sink += timed.angle(2); });
+
+		// A derived quantity added after the consumers: the distance between two finger tips
+		double spread = 0.0;
+		if(mode == 3) timed.graph().add("spread", [&]() {
+			spread = (timed.pose(1).position - timed.pose(3).position).norm();
+			return true;
+		}, {LIBERTY_POSE + 1, LIBERTY_POSE + 3});
+
+		double start = metricsNow();
+		for(size_t k = 0; k < numFrames; k++) {
+			const double (*frame)[7] = (const double (*)[7]) &samples[(k % 240) * 28];
+			if(mode == 0) {
+				eager.compute(frame);
+				for(size_t i = 0; i < 4; i++) sink += eager.matrices[i](0, 0) + eager.angles[i];
+			}
+			else if(timed.frame(k / 240.0, k / 240.0 + 0.1, frame, k / 240.0)) timed.run();
+		}
+		costs[mode] = (metricsNow() - start) / numFrames;
+		if(mode == 3) check("lazy", timed.graph().evaluations(LIBERTY_NUM_NODES) == 0, "the new node is never computed");
+		printf("[lazy] %-28s %8.1f ns per frame\n", names[mode], 1e9 * costs[mode]);
+		sink += spread;
+	}
+	check("lazy", costs[2] < costs[1] / 2, "one angle costs less than half of every output");
+	check("lazy", costs[3] < costs[2] * 1.5, "... and a new unsubscribed node does not slow it down");
+	if(sink == 0.0) printf("\n");
+
+	checkExit("lazy");
+}
@@ -0,0 +1,112 @@
+/**
+ * @file 20-shadowLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Shadow runs (see Shadow.h) of the euler engine of the original printLiberty against
+ * the pose engine on synthetic 240 Hz frames, fed in real time. Checks that the engines agree,
+ * that a wrong candidate is caught, that a candidate 10 times slower than the frame period only
+ * loses comparisons, that the caller and the candidate run on two cores and, when they do, that
+ * the caller's median time per frame stays that of the primary alone. Prints the summaries and
+ * exits with a failure if a check does not hold.
+ * Usage: 20-shadowLiberty [seconds per run, default 2]
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include "check.h"
+#include "metrics.h"
+#include "Synthetic.h"
+#include "Shadow.h"
+
+/* ********************************************************************************************* */
+/// The pose engine with the palm angle off by a milliradian
+bool skewedEngine(const double readings [4][7], EngineOutput& output) {
+	bool ok = poseEngine(readings, output);
+	output.angles[0] += 1e-3;
+	return ok;
+}
+
+/// The pose engine after 40 ms of work
+bool slowEngine(const double readings [4][7], EngineOutput& output) {
+	double end = metricsNow() + 0.04;
+	while(metricsNow() < end) {}
+	return poseEngine(readings, output);
+}
+
+/* ********************************************************************************************* */
+/// Feeds 240 Hz frames for the given time, with every 100th one missing a sensor; returns the
+/// median time per frame of the caller, with the candidate if there is one
+double feed(ShadowRunner* shadow, double seconds) {
+	SyntheticLiberty synthetic;
+	double readings [4][7];
+	std::vector <double> times;
+	EngineOutput output;
+	size_t numFrames = (size_t) (seconds * 240);
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for(size_t k = 0; k < numFrames; k++) {
+		synthetic.sample(k / 240.0, readings);
+		if(k % 100 == 99) readings[2][5] = NAN;
+		double start = metricsNow();
+		if(shadow != NULL) shadow->run(readings, output);
+		else poseEngine(readings, output);
+		times.push_back(metricsNow() - start);
+		next.tv_nsec += 1000000000 / 240;
+		if(next.tv_nsec >= 1000000000) next.tv_sec++, next.tv_nsec -= 1000000000;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	if(shadow != NULL) shadow->drain();
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+	size_t numFrames = (size_t) (seconds * 240);
+
+	// The euler engine against the pose engine
+	double alone = feed(NULL, seconds);
+	ShadowRunner euler ("shadowEuler", poseEngine, eulerEngine, -1, 1e-9, true);
+	double shadowed = feed(&euler, seconds);
+	euler.print(stdout);
+	ShadowSummary s = euler.summary();
+	double maxAngle = 0.0;
+	for(size_t i = 0; i < 4; i++) maxAngle = std::max(maxAngle, s.maxAngle[i]);
+	check("shadow", s.compared == numFrames && s.dropped == 0, "every frame is compared");
+	check("shadow", s.usable == numFrames - numFrames / 100 && s.disagreements == 0 && s.mismatches == 0 &&
+		maxAngle < 1e-9, "the euler engine agrees with the pose engine");
+	check("shadow", s.maxPosition < 1e-12 && s.maxMatrix < 1e-9, "... on the positions and the matrices too");
+	check("shadow", sysconf(_SC_NPROCESSORS_ONLN) == 1 || (euler.primaryCore() >= 0 && euler.core() >= 0 &&
+		euler.primaryCore() != euler.core()), "the caller and the candidate are pinned to two cores");
+
+	// A wrong candidate
+	ShadowRunner skewed ("shadowSkewed", poseEngine, skewedEngine);
+	feed(&skewed, seconds / 4);
+	skewed.print(stdout);
+	s = skewed.summary();
+	check("shadow", s.mismatches == s.usable && s.usable > 0 && fabs(s.maxAngle[0] - 1e-3) < 1e-9,
+		"a palm angle off by a milliradian is caught on every frame");
+
+	// A slow candidate
+	ShadowRunner slow ("shadowSlow", poseEngine, slowEngine);
+	double slowed = feed(&slow, seconds);
+	slow.print(stdout);
+	s = slow.summary();
+	check("shadow", s.dropped > numFrames / 2 && s.compared + s.dropped == numFrames,
+		"a slow candidate drops comparisons");
+
+	printf("[shadow] caller median %.1f ns per frame alone, %.1f with the euler shadow and %.1f with the slow one\n",
+		1e9 * alone, 1e9 * shadowed, 1e9 * slowed);
+	// On a single core the candidate shares the caller's and delays it
+	if(euler.core() >= 0 && slow.core() >= 0)
+		check("shadow", shadowed < alone + 1e-6 && slowed < alone + 1e-6,
+			"the shadow adds less than a microsecond to the caller");
+	else printf("[shadow] one core: the latency of the caller is not checked\n");
+
+	checkExit("shadow");
+}
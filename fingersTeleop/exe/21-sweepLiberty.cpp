@@ -0,0 +1,423 @@
+/**
+ * @file 21-sweepLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Finds where the liberty stack falls over on one machine. For every combination of the
+ * frame rates, channel counts and consumer counts it creates the ach channels, starts a synthetic
+ * publisher on each (this program with 'publish') and the consumers, which are the real daemons:
+ * 01-printLiberty next to this program, or the command in SWEEP_CONSUMER, i.e.
+ * "../somaticTutorial/server -c {channel}". One of each extra daemon command is started per channel
+ * for load. After each point it reads the frames each consumer read and missed and its latency
+ * from the frame stamp from its metrics (see metrics.h; the percentiles are interpolated in the
+ * histogram buckets) and its cpu time from /proc, prints a report line for the worst consumer and
+ * appends a row to the CSV, which carries the host, the core count and SWEEP_LABEL (i.e. a
+ * release) so that runs of different hosts and releases can go in one file. The report ends with
+ * the first point that drops more than 1% of the frames or whose p99 latency is over 4 times the
+ * one of the lightest point.
+ * Usage: 21-sweepLiberty sweep [csv, default sweep.csv] [seconds per point, default 3]
+ *	[rates, default 240,480,960] [channels, default 1,2,4] [consumers, default 1,2,4] [daemon ...]
+ *        21-sweepLiberty publish <channel> <rate> <seconds>
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <ach.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "metrics.h"
+#include "Synthetic.h"
+
+using namespace std;
+
+/// Frames an ach channel of the sweep holds before a slow consumer misses one
+#define SWEEP_CHANNEL_FRAMES 16
+
+/* ********************************************************************************************* */
+/// Opens an existing channel or exits
+void openChannel(ach_channel_t* channel, const char* name) {
+	ach_status_t r = ach_open(channel, name, NULL);
+	if(r != ACH_OK) {
+		fprintf(stderr, "Couldn't open channel %s: %s\n", name, ach_result_to_string(r));
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* ********************************************************************************************* */
+/// Puts synthetic frames stamped with the monotonic clock at the rate for the time and prints
+/// "published <frames> <late>", where late frames were put more than a period after their slot
+void publish(const char* name, double rate, double seconds) {
+
+	ach_channel_t channel;
+	openChannel(&channel, name);
+	SyntheticLiberty synthetic;
+	uint8_t buffer [1024];
+	size_t numFrames = (size_t) (rate * seconds), numLate = 0;
+	double start = metricsNow();
+	for(size_t k = 0; k < numFrames; k++) {
+		double slot = start + k / rate, now = metricsNow();
+		if(now < slot) {
+			struct timespec t;
+			t.tv_sec = (time_t) slot, t.tv_nsec = (long) ((slot - floor(slot)) * 1e9);
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+		}
+		else if(now > slot + 1.0 / rate) numLate++;
+		size_t size = synthetic.pack(metricsNow(), 0.1, buffer, sizeof(buffer));
+		ach_status_t r = ach_put(&channel, buffer, size);
+		if(r != ACH_OK) fprintf(stderr, "Couldn't put on %s: %s\n", name, ach_result_to_string(r));
+	}
+	printf("published %zu %zu\n", numFrames, numLate);
+	ach_close(&channel);
+}
+
+/* ********************************************************************************************* */
+/// The metrics of the consumer daemons the sweep knows: the frames read, the frames missed and
+/// the latency histogram from the frame stamp
+struct ConsumerMetrics {
+	const char *received, *missed, *latency;
+};
+const ConsumerMetrics consumerMetrics [] = {
+	{"printLiberty_frames_total", "printLiberty_skipped_frames_total", "printLiberty_latency_seconds_bucket"},
+	{"server_messages_total", "server_missed_frames_total", "server_latency_seconds_bucket"}
+};
+
+/// What a consumer reported
+struct Report {
+	double received, missed;
+	vector <pair <double, double> > buckets;		///< Upper bound (s) and cumulative count
+};
+
+/* ********************************************************************************************* */
+/// Scrapes the metrics of a daemon from its unix socket; empty if it does not answer
+string scrape(const string& path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+		if(fd >= 0) close(fd);
+		return "";
+	}
+	const char* request = "GET /metrics HTTP/1.0\r\n\r\n";
+	(void) !write(fd, request, strlen(request));
+	string response;
+	char buffer [4096];
+	for(ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0; ) response.append(buffer, n);
+	close(fd);
+	return response;
+}
+
+/// Reads the metrics of a known consumer from a scrape; false if there are none
+bool parseReport(const string& text, Report& report) {
+	for(size_t k = 0; k < sizeof(consumerMetrics) / sizeof(consumerMetrics[0]); k++) {
+		const ConsumerMetrics& known = consumerMetrics[k];
+		bool found = false;
+		report.received = report.missed = 0.0;
+		report.buckets.clear();
+		for(size_t at = 0, end; at < text.size(); at = end + 1) {
+			end = text.find('\n', at);
+			if(end == string::npos) end = text.size();
+			string line = text.substr(at, end - at), name = line.substr(0, line.find_first_of("{ "));
+			size_t space = line.rfind(' ');
+			if(line.empty() || line[0] == '#' || space == string::npos) continue;
+			double value = atof(line.c_str() + space + 1);
+			if(name == known.received) report.received = value, found = true;
+			else if(name == known.missed) report.missed = value;
+			else if(name == known.latency) {
+				size_t le = line.find("le=\"");
+				if(le == string::npos) continue;
+				double bound = (line.compare(le + 4, 4, "+Inf") == 0) ? INFINITY : atof(line.c_str() + le + 4);
+				report.buckets.push_back(make_pair(bound, value));
+			}
+		}
+		if(found) return true;
+	}
+	return false;
+}
+
+/// A quantile of a cumulative histogram, interpolated in its bucket; NAN if it is empty
+double quantile(const vector <pair <double, double> >& buckets, double q) {
+	if(buckets.empty() || !(buckets.back().second > 0)) return NAN;
+	double rank = q * buckets.back().second, lower = 0.0, below = 0.0;
+	for(size_t i = 0; i < buckets.size(); i++) {
+		double upper = buckets[i].first, count = buckets[i].second;
+		if(count >= rank && count > below) {
+			if(isinf(upper)) return lower;
+			return lower + (upper - lower) * (rank - below) / (count - below);
+		}
+		lower = upper, below = count;
+	}
+	return lower;
+}
+
+/* ********************************************************************************************* */
+/// The user and system time of a process so far (s); 0 if it is gone
+double cpuTime(pid_t pid) {
+	char path [64], text [1024];
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int) pid);
+	FILE* file = fopen(path, "r");
+	if(file == NULL) return 0.0;
+	size_t n = fread(text, 1, sizeof(text) - 1, file);
+	fclose(file);
+	text[n] = '\0';
+
+	// The fields after the command name, which may have spaces; utime and stime are the 12th and 13th
+	const char* fields = strrchr(text, ')');
+	unsigned long user, system;
+	if(fields == NULL || sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &user, &system) != 2)
+		return 0.0;
+	return (double) (user + system) / sysconf(_SC_CLK_TCK);
+}
+
+/* ********************************************************************************************* */
+/// A started process and the pipe of its standard output (NULL if not read)
+struct Child {
+	pid_t pid;
+	FILE* output;
+};
+
+/// Starts the command with /bin/sh in its own process group
+Child spawn(const string& command, bool readOutput) {
+	int fds [2] = {-1, -1};
+	if(readOutput && pipe(fds) != 0) {
+		perror("pipe");
+		exit(EXIT_FAILURE);
+	}
+	fflush(stdout);
+	Child child = {fork(), NULL};
+	if(child.pid < 0) {
+		perror("fork");
+		exit(EXIT_FAILURE);
+	}
+	if(child.pid == 0) {
+		setpgid(0, 0);
+		if(readOutput) dup2(fds[1], STDOUT_FILENO), close(fds[0]), close(fds[1]);
+		else freopen("/dev/null", "w", stdout);
+		execl("/bin/sh", "sh", "-c", command.c_str(), (char*) NULL);
+		_exit(127);
+	}
+	setpgid(child.pid, child.pid);
+	if(readOutput) {
+		close(fds[1]);
+		child.output = fdopen(fds[0], "r");
+	}
+	return child;
+}
+
+/// Reads the result line of a child and waits for it; the line is empty if it had none
+string finish(Child& child) {
+	char line [256] = "";
+	if(child.output != NULL) {
+		if(fgets(line, sizeof(line), child.output) == NULL) line[0] = '\0';
+		fclose(child.output);
+	}
+	waitpid(child.pid, NULL, 0);
+	return line;
+}
+
+/// Splits "1,2,4"
+vector <double> parseList(const char* text) {
+	vector <double> values;
+	for(const char* p = text; *p != '\0'; ) {
+		char* end;
+		values.push_back(strtod(p, &end));
+		if(end == p) {
+			fprintf(stderr, "Bad list '%s'\n", text);
+			exit(EXIT_FAILURE);
+		}
+		p = (*end == ',') ? end + 1 : end;
+	}
+	return values;
+}
+
+/* ********************************************************************************************* */
+/// What a point of the sweep measured
+struct Point {
+	double rate;
+	size_t channels, consumers;
+	size_t published, late, received, missed;
+	double p50, p90, p99, max;			///< Of the worst consumer (s)
+	double cpuPerFrame;					///< Consumer cpu time per received frame (s)
+	double throughput;					///< Received frames per second over all the consumers
+	double drops;							///< Share of the published frames a consumer did not receive
+};
+
+/// Replaces every {channel} of a command
+string withChannel(string command, const string& name) {
+	for(size_t at; (at = command.find("{channel}")) != string::npos; ) command.replace(at, 9, name);
+	return command;
+}
+
+/// Runs one point of the sweep
+Point runPoint(const string& self, const string& consumer, double rate, size_t numChannels, size_t numConsumers,
+		double seconds, const vector <string>& daemons) {
+
+	Point point;
+	memset(&point, 0, sizeof(point));
+	point.rate = rate, point.channels = numChannels, point.consumers = numConsumers;
+
+	// The channels and their consumers and daemons, then the publishers once they listen
+	vector <string> names, sockets;
+	vector <Child> consumers, publishers, others;
+	char command [1024];
+	for(size_t c = 0; c < numChannels; c++) {
+		char name [64];
+		snprintf(name, sizeof(name), "sweep-%d-%zu", (int) getpid(), c);
+		names.push_back(name);
+		ach_unlink(name);
+		ach_status_t r = ach_create(name, SWEEP_CHANNEL_FRAMES, 1024, NULL);
+		if(r != ACH_OK) {
+			fprintf(stderr, "Couldn't create channel %s: %s\n", name, ach_result_to_string(r));
+			exit(EXIT_FAILURE);
+		}
+		for(size_t m = 0; m < numConsumers; m++) {
+			snprintf(command, sizeof(command), "/tmp/%s-%zu.prom", name, m);
+			sockets.push_back(command);
+			snprintf(command, sizeof(command), "exec env METRICS_ENDPOINT=unix:%s CHECKPOINT=none %s",
+				sockets.back().c_str(), withChannel(consumer, name).c_str());
+			consumers.push_back(spawn(command, false));
+		}
+		for(size_t d = 0; d < daemons.size(); d++) others.push_back(spawn(withChannel(daemons[d], name), false));
+	}
+	usleep(500000);
+	vector <double> cpuStart (consumers.size());
+	for(size_t i = 0; i < consumers.size(); i++) cpuStart[i] = cpuTime(consumers[i].pid);
+	for(size_t c = 0; c < numChannels; c++) {
+		snprintf(command, sizeof(command), "exec %s publish %s %g %g", self.c_str(), names[c].c_str(), rate, seconds);
+		publishers.push_back(spawn(command, true));
+	}
+
+	// Collect the results
+	for(size_t i = 0; i < publishers.size(); i++) {
+		size_t published = 0, late = 0;
+		if(sscanf(finish(publishers[i]).c_str(), "published %zu %zu", &published, &late) != 2)
+			fprintf(stderr, "[sweep] a publisher of %s did not report\n", names[i].c_str());
+		point.published += published, point.late += late;
+	}
+
+	// Let the consumers read what is left, then ask them and stop them
+	usleep(500000);
+	double cpu = 0.0;
+	for(size_t i = 0; i < consumers.size(); i++) {
+		Report report;
+		bool reported = parseReport(scrape(sockets[i]), report);
+		cpu += cpuTime(consumers[i].pid) - cpuStart[i];
+		kill(-consumers[i].pid, SIGTERM);
+		finish(consumers[i]);
+		unlink(sockets[i].c_str());
+		if(!reported) {
+			fprintf(stderr, "[sweep] a consumer of %s did not report\n", names[i / numConsumers].c_str());
+			continue;
+		}
+		point.received += (size_t) report.received, point.missed += (size_t) report.missed;
+		const double fractions [4] = {0.5, 0.9, 0.99, 1.0};
+		double* worst [4] = {&point.p50, &point.p90, &point.p99, &point.max};
+		for(size_t k = 0; k < 4; k++) *worst[k] = max(*worst[k], quantile(report.buckets, fractions[k]));
+	}
+	for(size_t i = 0; i < others.size(); i++) {
+		kill(-others[i].pid, SIGTERM);
+		finish(others[i]);
+	}
+	for(size_t c = 0; c < numChannels; c++) ach_unlink(names[c].c_str());
+
+	size_t expected = point.published * numConsumers;
+	point.drops = (expected > 0) ? 1.0 - (double) point.received / expected : 1.0;
+	point.throughput = point.received / seconds;
+	point.cpuPerFrame = (point.received > 0) ? cpu / point.received : NAN;
+	return point;
+}
+
+/* ********************************************************************************************* */
+void sweep(int argc, char* argv[]) {
+
+	const char* csvPath = (argc > 2) ? argv[2] : "sweep.csv";
+	double seconds = (argc > 3) ? atof(argv[3]) : 3.0;
+	vector <double> rates = parseList((argc > 4) ? argv[4] : "240,480,960");
+	vector <double> channels = parseList((argc > 5) ? argv[5] : "1,2,4");
+	vector <double> consumers = parseList((argc > 6) ? argv[6] : "1,2,4");
+	vector <string> daemons;
+	for(int i = 7; i < argc; i++) daemons.push_back(argv[i]);
+
+	// Spawn this program again for the publishers and 01-printLiberty next to it for the consumers
+	char self [1024];
+	ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+	if(length <= 0) {
+		perror("readlink");
+		exit(EXIT_FAILURE);
+	}
+	self[length] = '\0';
+	string consumer = getenv("SWEEP_CONSUMER") ? getenv("SWEEP_CONSUMER") : "";
+	if(consumer.empty()) {
+		consumer = self;
+		consumer = consumer.substr(0, consumer.rfind('/') + 1) + "01-printLiberty -c {channel}";
+	}
+
+	// Append to the csv so that hosts and releases end up in one file
+	char host [256] = "unknown";
+	gethostname(host, sizeof(host));
+	const char* label = getenv("SWEEP_LABEL");
+	if(label == NULL) label = "";
+	bool exists = (access(csvPath, F_OK) == 0);
+	FILE* csv = fopen(csvPath, "a");
+	if(csv == NULL) {
+		perror(csvPath);
+		exit(EXIT_FAILURE);
+	}
+	if(!exists) fprintf(csv, "label,host,cores,daemons,rate_hz,channels,consumers,seconds,published,publisher_late,"
+		"received,missed,drop_pct,throughput_fps,latency_p50_us,latency_p90_us,latency_p99_us,latency_max_us,"
+		"consumer_cpu_us_per_frame\n");
+
+	printf("[sweep] %s on %s with %ld cores, consumer '%s', %zu daemons per channel, %.1f s per point\n", label,
+		host, sysconf(_SC_NPROCESSORS_ONLN), consumer.c_str(), daemons.size(), seconds);
+	printf("[sweep] %6s %3s %3s %8s %8s %7s %10s %9s %9s %9s %9s %8s\n", "rate", "ch", "con", "sent", "received",
+		"drop%", "fps", "p50 us", "p90 us", "p99 us", "max us", "cpu us");
+	vector <Point> points;
+	for(size_t r = 0; r < rates.size(); r++) for(size_t c = 0; c < channels.size(); c++)
+			for(size_t m = 0; m < consumers.size(); m++) {
+		Point p = runPoint(self, consumer, rates[r], (size_t) channels[c], (size_t) consumers[m], seconds, daemons);
+		points.push_back(p);
+		printf("[sweep] %6.0f %3zu %3zu %8zu %8zu %7.2f %10.0f %9.1f %9.1f %9.1f %9.1f %8.2f\n", p.rate, p.channels,
+			p.consumers, p.published, p.received, 100.0 * p.drops, p.throughput, 1e6 * p.p50, 1e6 * p.p90,
+			1e6 * p.p99, 1e6 * p.max, 1e6 * p.cpuPerFrame);
+		fflush(stdout);
+		fprintf(csv, "%s,%s,%ld,%zu,%g,%zu,%zu,%g,%zu,%zu,%zu,%zu,%.4f,%.1f,%.1f,%.1f,%.1f,%.1f,%.3f\n", label, host,
+			sysconf(_SC_NPROCESSORS_ONLN), daemons.size(), p.rate, p.channels, p.consumers, seconds, p.published, p.late,
+			p.received, p.missed, 100.0 * p.drops, p.throughput, 1e6 * p.p50, 1e6 * p.p90, 1e6 * p.p99, 1e6 * p.max,
+			1e6 * p.cpuPerFrame);
+		fflush(csv);
+	}
+	fclose(csv);
+
+	// The first point past the limits, in the order of the sweep
+	const Point& lightest = points[0];
+	for(size_t i = 0; i < points.size(); i++) {
+		const Point& p = points[i];
+		if(p.drops <= 0.01 && !(p.p99 > 4 * lightest.p99)) continue;
+		printf("[sweep] falls over at %.0f Hz x %zu channels x %zu consumers: %.2f%% dropped, p99 %.1f us "
+			"(%.1f us at the lightest point)\n", p.rate, p.channels, p.consumers, 100.0 * p.drops, 1e6 * p.p99,
+			1e6 * lightest.p99);
+		return;
+	}
+	printf("[sweep] held up at every point: at most 1%% dropped and p99 within 4 times %.1f us\n", 1e6 * lightest.p99);
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	if(argc > 4 && strcmp(argv[1], "publish") == 0) publish(argv[2], atof(argv[3]), atof(argv[4]));
+	else if(argc > 1 && strcmp(argv[1], "sweep") == 0) sweep(argc, argv);
+	else {
+		fprintf(stderr, "Usage: %s sweep [csv] [seconds] [rates] [channels] [consumers] [daemon ...]\n"
+			"       %s publish <channel> <rate> <seconds>\n", argv[0], argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	exit(EXIT_SUCCESS);
+}
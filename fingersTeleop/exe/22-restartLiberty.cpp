@@ -0,0 +1,229 @@
+/**
+ * @file 22-restartLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief Restarts of the lazy graph of 01-printLiberty (see LibertyGraph.h) through a shared
+ * memory checkpoint (see checkpoint.h) on synthetic 240 Hz frames with a glitch every second.
+ * Checks that an instance restored from the checkpoint continues exactly as one that was never
+ * stopped (the filtered angles and the health scores), that it has the last frame's outputs before
+ * the next frame arrives, also in another process, that an expired frame is not resumed and that
+ * another layout is ignored, that a reader never sees a half written save, that a save cut short
+ * by the death of its writer is not restored but the next one is and that a second writer is
+ * refused. Reports the time of a save and from the start of a new process to its first output,
+ * against a cold start, and exits with a failure if a check does not hold.
+ * Usage: 22-restartLiberty [frames, default 2400]
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <thread>
+#include "check.h"
+#include "metrics.h"
+#include "checkpoint.h"
+#include "Synthetic.h"
+#include "LibertyGraph.h"
+
+using namespace std;
+
+/* ********************************************************************************************* */
+/// The frame k, with the second sensor jumping 5 cm every 240th one
+void sample(SyntheticLiberty& synthetic, size_t k, double readings [4][7]) {
+	synthetic.sample(k / 240.0, readings);
+	if(k % 240 == 120) readings[1][0] += 0.05;
+}
+
+/// Subscribes the angles and the filtered angles
+void subscribe(LibertyGraph& graph, double outputs [8]) {
+	for(size_t i = 0; i < 4; i++) {
+		graph.graph().subscribe(LIBERTY_ANGLE + i, [&graph, outputs, i]() { outputs[i] = graph.angle(i); });
+		graph.graph().subscribe(LIBERTY_FILTERED + i, [&graph, outputs, i]() { outputs[4 + i] = graph.filtered(i); });
+	}
+}
+
+/// The largest difference of the outputs and of the health scores
+double difference(const double a [8], const double b [8], const HealthReport& x, const HealthReport& y) {
+	double largest = 0.0;
+	for(size_t i = 0; i < 8; i++) largest = max(largest, fabs(a[i] - b[i]));
+	for(size_t s = 0; s < 4; s++) largest = max(largest, fabs(x.score[s] - y.score[s]));
+	return largest;
+}
+
+/// A state that is torn if its values differ
+struct Filled {
+	uint64_t values [512];
+};
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	const size_t numFrames = (argc > 1) ? atol(argv[1]) : 2400, stop = numFrames / 2;
+	char name [64];
+	snprintf(name, sizeof(name), "/fingers-restartLiberty-%d", (int) getpid());
+	SyntheticLiberty synthetic;
+	double readings [4][7];
+
+	// The outputs of an instance that is never stopped
+	LibertyGraph uninterrupted;
+	double outputs [8];
+	subscribe(uninterrupted, outputs);
+	vector <double> expected (8 * numFrames);
+	vector <HealthReport> reports (numFrames);
+	for(size_t k = 0; k < numFrames; k++) {
+		sample(synthetic, k, readings);
+		uninterrupted.frame(k / 240.0, k / 240.0 + 0.1, readings, k / 240.0);
+		uninterrupted.run();
+		copy(outputs, outputs + 8, &expected[8 * k]);
+		reports[k] = uninterrupted.report();
+	}
+
+	// One stopped halfway, saving after every frame
+	Checkpoint <LibertyGraphState> checkpoint (name);
+	check("restart", checkpoint.mapped(), "the segment is mapped");
+	LibertyGraphState state;
+	double saveTime = 0.0;
+	{
+		LibertyGraph first;
+		subscribe(first, outputs);
+		for(size_t k = 0; k < stop; k++) {
+			sample(synthetic, k, readings);
+			if(!first.frame(k / 240.0, k / 240.0 + 0.1, readings, k / 240.0)) continue;
+			first.run();
+			double start = metricsNow();
+			first.save(state);
+			checkpoint.save(state);
+			saveTime += metricsNow() - start;
+		}
+	}
+	saveTime /= stop;
+
+	// Its successor has the last frame at once and then continues as if there was no restart
+	double now = (stop - 1) / 240.0 + 0.001, largest = 0.0;
+	LibertyGraph resumed;
+	subscribe(resumed, outputs);
+	bool restored = checkpoint.restore(state) && resumed.restore(state, now);
+	check("restart", restored && resumed.run() == 8, "the last frame is resumed within its deadline");
+	check("restart", difference(outputs, &expected[8 * (stop - 1)], resumed.report(), reports[stop - 1]) == 0.0,
+		"... with the outputs of the instance that was not stopped");
+	for(size_t k = stop; k < numFrames; k++) {
+		sample(synthetic, k, readings);
+		resumed.frame(k / 240.0, k / 240.0 + 0.1, readings, k / 240.0);
+		resumed.run();
+		largest = max(largest, difference(outputs, &expected[8 * k], resumed.report(), reports[k]));
+	}
+	check("restart", largest == 0.0, "the filters and the health checks continue exactly");
+
+	// A cold start has nothing until the next frame and starts its filters and checks over
+	LibertyGraph cold;
+	double coldOutputs [8];
+	subscribe(cold, coldOutputs);
+	size_t converged = numFrames;
+	for(size_t k = stop; k < numFrames; k++) {
+		sample(synthetic, k, readings);
+		cold.frame(k / 240.0, k / 240.0 + 0.1, readings, k / 240.0);
+		cold.run();
+		if(difference(coldOutputs, &expected[8 * k], cold.report(), reports[k]) > 1e-3) converged = k + 1;
+	}
+	printf("[restart] a cold start differs by over 1e-3 for %zu frames after the restart\n", converged - stop);
+	check("restart", converged > stop, "... which a cold start does not");
+
+	// Past its deadline the last frame is not used, but the filters and checks still are
+	LibertyGraph late;
+	subscribe(late, coldOutputs);
+	check("restart", !late.restore(state, now + 1.0) && late.run() == 0, "an expired frame is not resumed");
+
+	// Another layout or state is ignored
+	Checkpoint <LibertyGraphState> other (name, 2);
+	check("restart", !other.restore(state), "a checkpoint of another layout is ignored");
+
+	// In a new process, from its start to its first output
+	int fds [2];
+	if(pipe(fds) != 0) {
+		perror("pipe");
+		exit(EXIT_FAILURE);
+	}
+	double forked = metricsNow();
+	pid_t child = fork();
+	if(child == 0) {
+		Checkpoint <LibertyGraphState> again (name);
+		LibertyGraphState loaded;
+		LibertyGraph graph;
+		double first [8];
+		subscribe(graph, first);
+		bool ok = again.restore(loaded) && graph.restore(loaded, now) && graph.run() == 8;
+		double result [2] = {metricsNow() - forked, ok ? first[7] : NAN};
+		ssize_t written = write(fds[1], result, sizeof(result));
+		_exit(written == sizeof(result) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	double result [2] = {NAN, NAN};
+	ssize_t got = read(fds[0], result, sizeof(result));
+	int status;
+	waitpid(child, &status, 0);
+	close(fds[0]), close(fds[1]);
+	check("restart", got == sizeof(result) && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS &&
+		result[1] == expected[8 * (stop - 1) + 7], "another process resumes the same frame");
+
+	// Reads racing a writer are retried, never torn
+	Checkpoint <Filled> racing ((string(name) + "-race").c_str());
+	Filled filled, seen;
+	std::atomic <bool> writing (true);
+	std::thread writer ([&]() {
+		for(uint64_t n = 1; writing; n++) {
+			fill(filled.values, filled.values + 512, n);
+			racing.save(filled);
+		}
+	});
+	size_t numReads = 0, numTorn = 0;
+	double raceEnd = metricsNow() + 0.5;
+	while(metricsNow() < raceEnd) {
+		if(!racing.restore(seen)) continue;
+		numReads++;
+		if(count(seen.values, seen.values + 512, seen.values[0]) != 512) numTorn++;
+	}
+	writing = false;
+	writer.join();
+	printf("[restart] %zu reads during %lu saves\n", numReads, (unsigned long) racing.saves());
+	check("restart", numReads > 0 && numTorn == 0, "no read is torn");
+
+	// One writer per segment
+	Checkpoint <Filled> second ((string(name) + "-race").c_str());
+	check("restart", racing.writing() && !second.save(filled) && !second.writing(), "a second writer is refused");
+
+	// A writer killed in the middle of a save: the state straddles a page that can not be read, so
+	// that the copy faults
+	string killedName = string(name) + "-killed";
+	Checkpoint <Filled> survivor (killedName.c_str());
+	fflush(stdout);
+	pid_t dying = fork();
+	if(dying == 0) {
+		struct rlimit none = {0, 0};
+		setrlimit(RLIMIT_CORE, &none);
+		long page = sysconf(_SC_PAGESIZE);
+		uint8_t* pages = (uint8_t*) mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		Filled* straddling = (Filled*) (pages + page - sizeof(Filled) / 2);
+		fill(straddling->values, straddling->values + 256, 2);
+		mprotect(pages + page, page, PROT_NONE);
+		Checkpoint <Filled> writer (killedName.c_str());
+		writer.save(*straddling);
+		_exit(EXIT_SUCCESS);
+	}
+	waitpid(dying, &status, 0);
+	bool torn = WIFSIGNALED(status) && !survivor.restore(seen);
+	fill(filled.values, filled.values + 512, 1);
+	bool whole = survivor.save(filled) && survivor.restore(seen) && seen.values[511] == 1 && survivor.saves() == 1;
+	check("restart", torn && whole, "a save cut short is not restored and the next writer's is");
+	survivor.unlink();
+	racing.unlink();
+	checkpoint.unlink();
+
+	printf("[restart] a save takes %.1f ns; a new process has its first output %.1f us after its start,\n"
+		"[restart] a cold one the next frame, up to %.1f us later\n", 1e9 * saveTime, 1e6 * result[0], 1e6 / 240);
+	check("restart", saveTime < 1e-5 && result[0] < 1.0 / 240,
+		"saving is cheap and a restart outputs within a frame period");
+
+	checkExit("restart");
+}
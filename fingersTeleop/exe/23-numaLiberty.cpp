@@ -0,0 +1,241 @@
+/**
+ * @file 23-numaLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief The latency of a liberty frame from a producer thread to a consumer thread when the two
+ * and the frame memory are on the same NUMA node or not (see placement.h). The frames go through
+ * a ring of shared memory bound to a node, as the frames of an ach channel, or through an ach
+ * channel placed on the node with 'ach'; with 'huge' the memory is asked for in huge pages. Every
+ * frame is read before the next one is put, so the time is that of one frame crossing between the
+ * cores without a queue: half the round trip in the ring, the stamp to the read with ach. Prints
+ * the median, p99 and mean per case, and fails if the memory is not on the node of the case; on a
+ * host with one node only the same-node case is run.
+ * Usage: 23-numaLiberty [frames, default 100000] [ring|ach] [huge]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ach.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "metrics.h"
+#include "placement.h"
+#include "Synthetic.h"
+
+using namespace std;
+
+/// The ring: frames of this many bytes, as many as fit in 2 MB
+#define NUMA_SLOT_BYTES 1024
+#define NUMA_RING_BYTES (2 << 20)
+
+/// A frame in the ring
+struct Slot {
+	std::atomic <uint64_t> sequence;
+	double sentAt, readings [4][7];
+};
+
+/// A case: the nodes of the producer, the consumer and the memory
+struct Case {
+	const char* name;
+	int producer, consumer, memory;
+};
+
+/* ********************************************************************************************* */
+/// Waits until the value reaches the target, yielding the core once in a while
+inline void await(const std::atomic <uint64_t>& value, uint64_t target) {
+	for(size_t spins = 0; value.load(std::memory_order_acquire) < target; spins++) if(spins % 64 == 63) sched_yield();
+}
+
+/* ********************************************************************************************* */
+/// The node of every page of the memory; -1 if one is unknown or the pages are on several nodes
+int pagesNode(void* memory, size_t length) {
+	int node = memoryNode(memory);
+	for(size_t at = 0; node >= 0 && at < length; at += sysconf(_SC_PAGESIZE))
+		if(memoryNode((uint8_t*) memory + at) != node) node = -1;
+	return node;
+}
+
+/// The node of the pages of a channel, read through a mapping of its segment; -1 if unknown
+int channelNode(const char* name) {
+	std::string path = std::string(PLACEMENT_ACH_PREFIX) + name;
+	int fd = shm_open(path.c_str(), O_RDONLY, 0);
+	struct stat status;
+	if(fd < 0 || fstat(fd, &status) != 0) {
+		if(fd >= 0) close(fd);
+		return -1;
+	}
+	void* memory = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(memory == MAP_FAILED) return -1;
+	int node = pagesNode(memory, status.st_size);
+	munmap(memory, status.st_size);
+	return node;
+}
+
+/* ********************************************************************************************* */
+/// Sends the frames through a ring on the memory node; returns the one way times
+vector <double> ring(const Case& c, size_t numFrames, bool huge) {
+
+	// The memory is bound before it is touched, so every page is allocated on the node
+	void* memory = mmap(NULL, NUMA_RING_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(memory == MAP_FAILED) {
+		perror("mmap");
+		exit(EXIT_FAILURE);
+	}
+	if(!bindMemory(memory, NUMA_RING_BYTES, c.memory, huge)) exit(EXIT_FAILURE);
+	memset(memory, 0, NUMA_RING_BYTES);
+	int node = pagesNode(memory, NUMA_RING_BYTES);
+	if(node != c.memory) {
+		fprintf(stderr, "[numa] The ring is on node %d, not %d\n", node, c.memory);
+		exit(EXIT_FAILURE);
+	}
+	const size_t numSlots = NUMA_RING_BYTES / NUMA_SLOT_BYTES - 1;
+	std::atomic <uint64_t>* acked = (std::atomic <uint64_t>*) memory;
+	Slot* slots = (Slot*) ((uint8_t*) memory + NUMA_SLOT_BYTES);
+
+	// The consumer reads every frame and says so
+	std::thread consumer ([&]() {
+		pinThread(pthread_self(), c.consumer);
+		double sum = 0.0;
+		for(uint64_t k = 1; k <= numFrames; k++) {
+			Slot& slot = slots[k % numSlots];
+			await(slot.sequence, k);
+			for(size_t s = 0; s < 4; s++) for(size_t i = 0; i < 7; i++) sum += slot.readings[s][i];
+			acked->store(k, std::memory_order_release);
+		}
+		if(sum == 0.0) printf("\n");
+	});
+
+	// The producer times the round trips
+	pinThread(pthread_self(), c.producer);
+	SyntheticLiberty synthetic;
+	double readings [4][7];
+	vector <double> times;
+	times.reserve(numFrames);
+	for(uint64_t k = 1; k <= numFrames; k++) {
+		synthetic.sample(k / 240.0, readings);
+		Slot& slot = slots[k % numSlots];
+		double start = metricsNow();
+		memcpy(slot.readings, readings, sizeof(readings));
+		slot.sentAt = start;
+		slot.sequence.store(k, std::memory_order_release);
+		await(*acked, k);
+		times.push_back((metricsNow() - start) / 2);
+	}
+	consumer.join();
+	munmap(memory, NUMA_RING_BYTES);
+	return times;
+}
+
+/* ********************************************************************************************* */
+/// Sends the frames through an ach channel on the memory node; returns the one way times
+vector <double> channel(const Case& c, size_t numFrames, bool huge) {
+
+	char name [64];
+	snprintf(name, sizeof(name), "numaLiberty-%d", (int) getpid());
+	ach_unlink(name);
+	ach_status_t r = ach_create(name, 64, NUMA_SLOT_BYTES, NULL);
+	if(r != ACH_OK) {
+		fprintf(stderr, "Couldn't create channel %s: %s\n", name, ach_result_to_string(r));
+		exit(EXIT_FAILURE);
+	}
+	Placement placement;
+	placement.add(true, name, c.memory, huge);
+	if(!placement.placeChannel(name)) exit(EXIT_FAILURE);
+	int node = channelNode(name);
+	if(node != c.memory) {
+		fprintf(stderr, "[numa] The channel is on node %d, not %d\n", node, c.memory);
+		exit(EXIT_FAILURE);
+	}
+	ach_channel_t input, output;
+	if(ach_open(&input, name, NULL) != ACH_OK || ach_open(&output, name, NULL) != ACH_OK) {
+		fprintf(stderr, "Couldn't open channel %s\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	// The consumer takes the time from the stamp to the read
+	std::atomic <uint64_t> acked (0);
+	vector <double> times (numFrames);
+	std::thread consumer ([&]() {
+		pinThread(pthread_self(), c.consumer);
+		uint8_t buffer [NUMA_SLOT_BYTES];
+		for(uint64_t k = 1; k <= numFrames; ) {
+			size_t size = 0;
+			ach_status_t r = ach_get(&input, buffer, sizeof(buffer), &size, NULL, ACH_O_WAIT);
+			if(!(r == ACH_OK || r == ACH_MISSED_FRAME) || size != sizeof(Slot)) continue;
+			double now = metricsNow();
+			const Slot* slot = (const Slot*) buffer;
+			times[k - 1] = now - slot->sentAt;
+			acked.store(k++, std::memory_order_release);
+		}
+	});
+
+	pinThread(pthread_self(), c.producer);
+	SyntheticLiberty synthetic;
+	Slot slot;
+	for(uint64_t k = 1; k <= numFrames; k++) {
+		synthetic.sample(k / 240.0, slot.readings);
+		slot.sequence.store(k);
+		slot.sentAt = metricsNow();
+		ach_put(&output, &slot, sizeof(slot));
+		await(acked, k);
+	}
+	consumer.join();
+	ach_close(&input), ach_close(&output);
+	ach_unlink(name);
+	return times;
+}
+
+/* ********************************************************************************************* */
+int main(int argc, char* argv[]) {
+
+	long numFrames = (argc > 1) ? atol(argv[1]) : 100000;
+	if(numFrames <= 0) {
+		fprintf(stderr, "Invalid frame count '%s', use a positive number\n", argv[1]);
+		exit(EXIT_FAILURE);
+	}
+	bool achMode = (argc > 2 && strcmp(argv[2], "ach") == 0), huge = (argc > 3 && strcmp(argv[3], "huge") == 0);
+	if(argc > 2 && !achMode && strcmp(argv[2], "ring") != 0) {
+		fprintf(stderr, "Unknown transport '%s', use ring or ach\n", argv[2]);
+		exit(EXIT_FAILURE);
+	}
+
+	// The far node is the last one
+	int numNodes = numaNodes(), far = numNodes - 1;
+	const Case cases [] = {
+		{"same node", 0, 0, 0},
+		{"consumer far, memory with producer", 0, far, 0},
+		{"consumer far, memory with consumer", 0, far, far},
+		{"threads together, memory far", 0, 0, far}
+	};
+	size_t numCases = (numNodes > 1) ? sizeof(cases) / sizeof(cases[0]) : 1;
+	printf("[numa] NUMA nodes: %d; %s%s, %zu frames per case\n", numNodes, achMode ? "ach channel" : "shared ring",
+		huge ? " in huge pages" : "", (size_t) numFrames);
+	if(numNodes == 1) printf("[numa] one node: the cross-node cases are skipped\n");
+
+	printf("[numa] %-36s %4s %4s %4s %10s %10s %10s\n", "case", "prod", "cons", "mem", "median ns", "p99 ns", "mean ns");
+	double baseline = 0.0;
+	for(size_t i = 0; i < numCases; i++) {
+		const Case& c = cases[i];
+		vector <double> times = achMode ? channel(c, numFrames, huge) : ring(c, numFrames, huge);
+		double mean = 0.0;
+		for(size_t k = 0; k < times.size(); k++) mean += times[k];
+		mean /= times.size();
+		sort(times.begin(), times.end());
+		double median = times[times.size() / 2], p99 = times[(size_t) (0.99 * (times.size() - 1))];
+		if(i == 0) baseline = median;
+		printf("[numa] %-36s %4d %4d %4d %10.1f %10.1f %10.1f", c.name, c.producer, c.consumer, c.memory, 1e9 * median,
+			1e9 * p99, 1e9 * mean);
+		if(i > 0) printf("  (%.2fx)", median / baseline);
+		printf("\n");
+	}
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,120 @@
+/**
+ * @file 24-graspCheck.cpp
+ * @date Oct 18, 2026
+ * @brief Checks the streaming grasp detector of 02-graspDetector (see GraspDetector.h): the
+ * sliding window statistics against a recomputation over the window for random signals and
+ * several window sizes, and the states reached by scripted 240 Hz hand motions (nothing before
+ * the window is full, open, closing, closed with its hysteresis, release and pinch). Exits with a
+ * failure if a check does not hold.
+ * Usage: 24-graspCheck
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "check.h"
+#include "GraspDetector.h"
+
+using namespace std;
+
+/* ********************************************************************************************* */
+/// The largest difference of the window statistics to a recomputation over the last samples
+double windowError(size_t size, size_t numSamples, unsigned int seed) {
+	srand(seed);
+	SlidingWindow window (size);
+	size_t kept = min(max(size, (size_t) 1), (size_t) GRASP_MAX_WINDOW);
+	vector <double> values, times;
+	double error = 0.0;
+	for(size_t k = 0; k < numSamples; k++) {
+		double time = k / 240.0, value = sin(3 * time) + ((double) rand()) / RAND_MAX;
+		window.push(time, value);
+		values.push_back(value), times.push_back(time);
+		size_t n = min(values.size(), kept), first = values.size() - n;
+		double mean = 0.0, variance = 0.0;
+		for(size_t i = first; i < values.size(); i++) mean += values[i] / n;
+		for(size_t i = first; i < values.size(); i++) variance += (values[i] - mean) * (values[i] - mean);
+		variance = (n > 1) ? variance / (n - 1) : 0.0;
+		double lowest = *min_element(values.begin() + first, values.end());
+		double highest = *max_element(values.begin() + first, values.end());
+		double velocity = (n > 1) ? (values.back() - values[first]) / (times.back() - times[first]) : 0.0;
+		error = max(error, fabs(window.mean() - mean) + fabs(window.variance() - variance));
+		error = max(error, fabs(window.min() - lowest) + fabs(window.max() - highest));
+		error = max(error, fabs(window.velocity() - velocity));
+	}
+	return error;
+}
+
+/* ********************************************************************************************* */
+/// Feeds the flexions of a motion at 240 Hz for the given number of frames from frame k on;
+/// returns the states entered
+vector <GraspState> feed(GraspDetector& detector, size_t& k, size_t numFrames,
+		function <void (double, double [GRASP_NUM_FINGERS])> motion) {
+	vector <GraspState> entered;
+	double flexion [GRASP_NUM_FINGERS];
+	for(size_t end = k + numFrames; k < end; k++) {
+		motion(k / 240.0, flexion);
+		if(detector.update(k / 240.0, flexion)) entered.push_back(detector.state());
+	}
+	return entered;
+}
+
+/// Every finger at the same flexion
+function <void (double, double [GRASP_NUM_FINGERS])> hold(double value) {
+	return [value](double, double flexion [GRASP_NUM_FINGERS]) {
+		for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) flexion[i] = value;
+	};
+}
+
+/* ********************************************************************************************* */
+int main() {
+
+	// The window statistics
+	double error = 0.0;
+	const size_t sizes [] = {1, 2, 7, 24, 256, 1000};
+	for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) error = max(error, windowError(sizes[i], 1500, i));
+	check("grasp", error < 1e-9, "the window statistics match a recomputation");
+
+	// Nothing until the window is full, then open
+	GraspParams params;
+	GraspDetector detector (params);
+	size_t k = 0;
+	feed(detector, k, params.window - 1, hold(0.1));
+	check("grasp", detector.state() == GRASP_UNKNOWN, "unknown before the window is full");
+	vector <GraspState> entered = feed(detector, k, 48, hold(0.1));
+	check("grasp", entered.size() == 1 && entered[0] == GRASP_OPEN, "an open hand is open");
+
+	// Closing at 3 rad/s, then closed
+	double start = k / 240.0;
+	entered = feed(detector, k, 144, [start](double t, double flexion [GRASP_NUM_FINGERS]) {
+		for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) flexion[i] = min(0.1 + 3 * (t - start), 1.3);
+	});
+	entered.erase(unique(entered.begin(), entered.end()), entered.end());
+	check("grasp", !entered.empty() && entered[0] == GRASP_CLOSING && detector.state() == GRASP_CLOSED,
+		"a closing hand is closing and then closed");
+
+	// Between the exit and the enter thresholds it stays closed, below the exit it is released
+	entered = feed(detector, k, 120, hold(0.9));
+	check("grasp", entered.empty() && detector.state() == GRASP_CLOSED, "a hand above the exit threshold stays closed");
+	entered = feed(detector, k, 120, hold(0.5));
+	check("grasp", !entered.empty() && detector.state() == GRASP_OPEN, "below it the hand is released");
+
+	// The pinch fingers closed and the other open
+	entered = feed(detector, k, 120, [&params](double, double flexion [GRASP_NUM_FINGERS]) {
+		for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) flexion[i] = params.pinchFingers[i] ? 1.3 : 0.1;
+	});
+	check("grasp", !entered.empty() && detector.state() == GRASP_PINCH, "a pinch is a pinch");
+	entered = feed(detector, k, 120, hold(0.1));
+	check("grasp", detector.state() == GRASP_OPEN, "... and an open hand after it is open");
+
+	// A hand trembling below the closed threshold is never closed
+	entered = feed(detector, k, 240, [](double t, double flexion [GRASP_NUM_FINGERS]) {
+		for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) flexion[i] = 0.3 + 0.2 * sin(20 * t);
+	});
+	check("grasp", detector.state() != GRASP_CLOSED && detector.state() != GRASP_PINCH,
+		"a trembling open hand is not closed");
+
+	checkExit("grasp");
+}
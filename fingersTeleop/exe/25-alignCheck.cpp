@@ -0,0 +1,126 @@
+/**
+ * @file 25-alignCheck.cpp
+ * @date Oct 18, 2026
+ * @brief Checks the time-aligned channel histories of 03-fuseLiberty (see TimeAlign.h): the
+ * linear and slerp interpolation against the exact values, the results outside the kept range,
+ * the rejection of samples out of order, the snapshot time of several channels, that a reader
+ * racing the writer around a small ring never gets a mix of two samples, and that a history with
+ * too many values or a quaternion past its values is refused. Exits with a failure if a check
+ * does not hold.
+ * Usage: 25-alignCheck
+ */
+
+#include <Eigen/Geometry>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "check.h"
+#include "metrics.h"
+#include "TimeAlign.h"
+
+using namespace Eigen;
+using namespace std;
+
+/* ********************************************************************************************* */
+/// A sample of a channel of a position (linear in time) and a quaternion (a constant rotation
+/// speed about a fixed axis), so that both interpolations are exact
+void sample(double time, double values [7]) {
+	for(size_t i = 0; i < 3; i++) values[i] = (i + 1) * time;
+	Quaterniond q (AngleAxisd(2.0 * time, Vector3d(1, 2, 3).normalized()));
+	values[3] = q.x(), values[4] = q.y(), values[5] = q.z(), values[6] = q.w();
+}
+
+/// True if constructing the history exits the process with a failure
+bool refused(size_t numValues, size_t quaternion) {
+	fflush(stdout);
+	pid_t child = fork();
+	if(child == 0) {
+		fclose(stderr);
+		ChannelHistory history (numValues, vector <size_t> (1, quaternion));
+		_exit(EXIT_SUCCESS);
+	}
+	int status;
+	waitpid(child, &status, 0);
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE;
+}
+
+/* ********************************************************************************************* */
+int main() {
+
+	// Interpolation between 10 Hz samples
+	ChannelHistory history (7, vector <size_t> (1, 3), 64);
+	double values [7], expected [7];
+	check("align", history.at(0.0, values) == HISTORY_EMPTY, "an empty history is empty");
+	for(size_t k = 0; k < 100; k++) {
+		sample(k / 10.0, values);
+		history.push(k / 10.0, values);
+	}
+	double error = 0.0;
+	bool ok = true;
+	for(double t = 4.0; t < 9.9; t += 0.0137) {
+		ok &= (history.at(t, values) == HISTORY_OK);
+		sample(t, expected);
+		for(size_t i = 0; i < 7; i++) error = max(error, fabs(values[i] - expected[i]));
+	}
+	check("align", ok && error < 1e-12, "positions and quaternions are interpolated exactly");
+
+	// Outside the range
+	sample(9.9, expected);
+	check("align", history.at(12.0, values) == HISTORY_HELD && values[0] == expected[0],
+		"after the newest the newest is held");
+	check("align", history.at(1.0, values) == HISTORY_TOO_OLD, "before the oldest kept it is too old");
+
+	// Out of order
+	sample(9.0, values);
+	check("align", !history.push(9.0, values) && !history.push(9.9, values) && !history.push(NAN, values),
+		"a sample not after the newest is rejected");
+	check("align", history.at(12.0, values) == HISTORY_HELD && values[0] == expected[0],
+		"... and leaves the history as it was");
+
+	// The snapshot time of several channels
+	ChannelHistory slow (1), fast (1);
+	double one = 0.0, time = 0.0;
+	const ChannelHistory* channels [] = {&history, &slow, &fast};
+	check("align", !snapshotTime(channels, 3, time), "no snapshot while a channel is empty");
+	slow.push(3.0, &one), fast.push(5.0, &one);
+	check("align", snapshotTime(channels, 3, time) && time == 3.0, "the snapshot time is the oldest newest sample");
+
+	// A reader racing the writer around a ring of 4; every value of a sample is its index
+	ChannelHistory racing (HISTORY_MAX_VALUES, vector <size_t> (), 4);
+	std::atomic <bool> writing (true);
+	std::thread writer ([&]() {
+		double sample [HISTORY_MAX_VALUES];
+		for(uint64_t k = 1; writing; k++) {
+			fill(sample, sample + HISTORY_MAX_VALUES, (double) k);
+			racing.push(k, sample);
+		}
+	});
+	size_t numReads = 0, numTorn = 0;
+	double read [HISTORY_MAX_VALUES], end = metricsNow() + 0.5;
+	while(metricsNow() < end) {
+		double newest;
+		if(!racing.newest(newest)) continue;
+		HistoryResult r = racing.at(newest - 1.5, read);
+		if(r != HISTORY_OK && r != HISTORY_TOO_OLD && r != HISTORY_HELD) continue;
+		numReads++;
+
+		// Interpolated values are all the same, whatever the alpha
+		if(count(read, read + HISTORY_MAX_VALUES, read[0]) != HISTORY_MAX_VALUES) numTorn++;
+	}
+	writing = false;
+	writer.join();
+	printf("[align] %zu reads racing the writer\n", numReads);
+	check("align", numReads > 0 && numTorn == 0, "a reader never mixes two samples");
+
+	// Sizes that would overflow a slot
+	check("align", refused(HISTORY_MAX_VALUES + 1, 0), "a history of too many values is refused");
+	check("align", refused(7, 4), "a quaternion past the values is refused");
+	check("align", !refused(7, 3), "... and a valid one is not");
+
+	checkExit("align");
+}
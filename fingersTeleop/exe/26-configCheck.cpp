@@ -0,0 +1,137 @@
+/**
+ * @file 26-configCheck.cpp
+ * @date Oct 18, 2026
+ * @brief Checks the reload path of the live parameters of 01-printLiberty and 16-teleopController
+ * (see liveConfig.h and FingersCore.h): a file is applied when it is written and again when it is
+ * replaced, a file with a value out of its range (a negative step, a zero deadline, NaN), an
+ * unknown key or parameters that contradict each other is not applied and leaves the last good
+ * ones, a reader racing the reloads always sees the values of one file, and a watcher without a
+ * file does nothing. Exits with a failure if a check does not hold.
+ * Usage: 26-configCheck
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "check.h"
+#include "liveConfig.h"
+#include "metrics.h"
+#include "FingersCore.h"
+
+using namespace std;
+
+/* ********************************************************************************************* */
+/// Replaces the file as an editor does, so that the watcher never reads half of it
+void write(const string& path, const char* text) {
+	string temporary = path + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "w");
+	if(file == NULL || fputs(text, file) < 0 || fclose(file) != 0 || rename(temporary.c_str(), path.c_str()) != 0) {
+		perror(path.c_str());
+		exit(EXIT_FAILURE);
+	}
+}
+
+/// Waits for the config to reach the version; false after a second
+bool await(LiveConfig <FingersCoreParams>& config, uint64_t version) {
+	for(double end = metricsNow() + 1.0; metricsNow() < end; usleep(1000)) if(config.version() >= version) return true;
+	return false;
+}
+
+/// True if a single line is refused by the parser
+bool refused(const char* key, const char* value) {
+	FingersCoreParams params;
+	return !parseFingersParam(key, value, params);
+}
+
+/* ********************************************************************************************* */
+int main() {
+
+	// The ranges of single values
+	check("config", refused("ik.maxStep", "-0.1") && refused("ik.maxStep", "0") && !refused("ik.maxStep", "0.1"),
+		"a step that is not positive is refused");
+	check("config", refused("deadline.defaultValidity", "0") && refused("ik.budget", "0"), "a zero deadline is refused");
+	check("config", refused("scale", "nan") && refused("scale", "inf") && refused("health.maxSpeed", "-inf"),
+		"a value that is not finite is refused");
+	check("config", refused("ik.maxIterations", "0") && refused("arm.upper.3", "100") && refused("offset.1.x", "5"),
+		"a count, a joint limit or an offset out of range is refused");
+	check("config", refused("ik.unknown", "1") && refused("scale", "1x"), "an unknown key or a bad number is refused");
+
+	// A file is applied at the start and again when it changes, with the keys it leaves out kept
+	char name [64];
+	snprintf(name, sizeof(name), "/tmp/fingers-configCheck-%d.conf", (int) getpid());
+	string path = name;
+	write(path, "scale = 0.5\nik.maxStep = 0.1   # rad\n");
+	LiveConfig <FingersCoreParams> config ((FingersCoreParams()));
+	LiveConfig <FingersCoreParams>::Reader reader (config);
+	{
+		ConfigWatcher <FingersCoreParams> watcher (config, path.c_str(), parseFingersParam, validFingersParams, 0.005);
+		const FingersCoreParams* params = reader.get();
+		check("config", config.version() == 1 && params->scale == 0.5 && params->ik.maxStep == 0.1,
+			"the file is applied");
+		usleep(20000);
+		write(path, "scale = 0.25\n");
+		bool reloaded = await(config, 2);
+		params = reader.get();
+		check("config", reloaded && params->scale == 0.25 && params->ik.maxStep == 0.1,
+			"a change is applied, the rest kept");
+
+		// Bad files leave the last good parameters
+		const char* bad [] = {
+			"scale = 0.75\nik.maxStep = -0.2\n",
+			"scale = 0.75\ndeadline.defaultValidity = 0\n",
+			"scale = 0.75\nik.damping = nan\n",
+			"scale = 0.75\nik.unknown = 1\n",
+			"scale = 0.75\ngrasp.closedEnter = 0.5\n",
+			"scale = 0.75\narm.lower.2 = 1\narm.upper.2 = 0.5\n"
+		};
+		bool kept = true;
+		for(size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+			usleep(20000);
+			write(path, bad[i]);
+			usleep(50000);
+			params = reader.get();
+			kept &= (config.version() == 2 && params->scale == 0.25);
+		}
+		check("config", kept, "a file out of range or contradicting itself is not applied");
+
+		// A reader racing the reloads sees the values of one file: the damping is a tenth of the scale
+		std::atomic <bool> reading (true);
+		size_t numReads = 0, numMixed = 0;
+		std::thread racer ([&]() {
+			LiveConfig <FingersCoreParams>::Reader racing (config);
+			while(reading) {
+				const FingersCoreParams* p = racing.get();
+				if(racing.version() > 2 && fabs(p->ik.damping - p->scale / 10) > 1e-12) numMixed++;
+				numReads++;
+			}
+			racing.release();
+		});
+		uint64_t version = config.version();
+		for(size_t k = 1; k <= 20; k++) {
+			char text [128];
+			snprintf(text, sizeof(text), "scale = %g\nik.damping = %g\n", k / 10.0, k / 100.0);
+			usleep(20000);
+			write(path, text);
+			await(config, version + k);
+		}
+		reading = false;
+		racer.join();
+		printf("[config] %zu reads during %lu reloads\n", numReads, (unsigned long) (config.version() - version));
+		check("config", config.version() == version + 20 && numReads > 0 && numMixed == 0,
+			"every reload is applied and no read mixes two files");
+	}
+	unlink(path.c_str());
+
+	// Without a file nothing is watched or applied
+	{
+		LiveConfig <FingersCoreParams> none ((FingersCoreParams()));
+		ConfigWatcher <FingersCoreParams> watcher (none, NULL, parseFingersParam, validFingersParams);
+		check("config", none.version() == 0, "a watcher without a file does nothing");
+	}
+
+	checkExit("config");
+}
@@ -0,0 +1,402 @@
+/**
+ * @file Bridge.cpp
+ * @date Oct 18, 2026
+ * @brief The sending and the receiving ends of the network bridge.
+ */
+
+#include "Bridge.h"
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+/* ********************************************************************************************* */
+BridgeParams::BridgeParams () : tcp(false), latestOnly(false), compact(false), maxFrames(16), maxBytes(1400),
+	maxQueued(65536), maxFrame(4096), flushTimeout(0.002) {}
+
+/* ********************************************************************************************* */
+bool parseEndpoint (const char* text, bool& tcp, struct sockaddr_in& address) {
+
+	if(strncmp(text, "udp://", 6) == 0) tcp = false;
+	else if(strncmp(text, "tcp://", 6) == 0) tcp = true;
+	else return false;
+	const char* colon = strrchr(text + 6, ':');
+	if(colon == NULL) return false;
+	std::string host (text + 6, colon - text - 6);
+	int port = atoi(colon + 1);
+	if(port <= 0 || port > 65535) return false;
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	if(host.empty() || host == "*") address.sin_addr.s_addr = htonl(INADDR_ANY);
+	else if(inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+		struct addrinfo hints, *result;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		if(getaddrinfo(host.c_str(), NULL, &hints, &result) != 0) return false;
+		address.sin_addr = ((struct sockaddr_in*) result->ai_addr)->sin_addr;
+		freeaddrinfo(result);
+	}
+	return true;
+}
+
+/* ********************************************************************************************* */
+static double clockSeconds (clockid_t clock) {
+	struct timespec t;
+	clock_gettime(clock, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+double bridgeMonotonic () { return clockSeconds(CLOCK_MONOTONIC); }
+double bridgeRealtime () { return clockSeconds(CLOCK_REALTIME); }
+
+/* ********************************************************************************************* */
+BridgeSender::BridgeSender (const BridgeParams& params) : params(params), sock(-1), connecting(false),
+		writable(false), lastAttempt(-INFINITY), batchSequence(0), frameSequence(0), numFrames(0), numBatches(0), numDropped(0),
+		numBytes(0), numConnections(0) {
+	memset(&address, 0, sizeof(address));
+	struct timespec t;
+	clock_gettime(CLOCK_REALTIME, &t);
+	session = (uint32_t) (t.tv_nsec ^ (t.tv_sec << 12) ^ getpid());
+	batch.resize(sizeof(BridgeBatch));
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+}
+
+/* ********************************************************************************************* */
+BridgeSender::~BridgeSender () {
+	if(sock >= 0) close(sock);
+	close(epollFd);
+}
+
+/* ********************************************************************************************* */
+void BridgeSender::open (const struct sockaddr_in& address) {
+	this->address = address;
+	if(params.tcp) return;
+	sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	::connect(sock, (const struct sockaddr*) &address, sizeof(address));
+}
+
+/* ********************************************************************************************* */
+bool BridgeSender::connect (double now) {
+
+	// Start a connection at most once a second
+	if(sock >= 0 && !connecting) return true;
+	if(sock < 0) {
+		if(now - lastAttempt < 1.0) return false;
+		lastAttempt = now;
+		sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		int one = 1;
+		setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		if(params.latestOnly) {
+			int small = 4 * params.maxBytes;
+			setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+		}
+		connecting = true;
+		if(::connect(sock, (const struct sockaddr*) &address, sizeof(address)) != 0 && errno != EINPROGRESS) {
+			close(sock), sock = -1;
+			return false;
+		}
+
+		// The socket is writable once connected
+		struct epoll_event event;
+		event.events = EPOLLOUT, event.data.fd = sock;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, sock, &event);
+		writable = true;
+	}
+
+	// Check whether it is done without waiting
+	struct epoll_event event;
+	if(epoll_wait(epollFd, &event, 1, 0) <= 0) return false;
+	int error = 0;
+	socklen_t length = sizeof(error);
+	getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length);
+	if(error != 0) {
+		disconnect();
+		return false;
+	}
+	connecting = false;
+	unsent.clear();
+	watch(false);
+	numConnections++;
+	return true;
+}
+
+/* ********************************************************************************************* */
+void BridgeSender::disconnect () {
+	close(sock), sock = -1;		// which also takes it out of the epoll set
+	connecting = writable = false;
+	unsent.clear();
+}
+
+/* ********************************************************************************************* */
+void BridgeSender::watch (bool room) {
+	if(sock < 0 || room == writable) return;
+	struct epoll_event event;
+	event.events = room ? (uint32_t) EPOLLOUT : 0u, event.data.fd = sock;
+	epoll_ctl(epollFd, EPOLL_CTL_MOD, sock, &event);
+	writable = room;
+}
+
+/* ********************************************************************************************* */
+bool BridgeSender::drain () {
+	while(!unsent.empty()) {
+		ssize_t n = ::send(sock, &unsent[0], unsent.size(), MSG_NOSIGNAL);
+		if(n > 0) {
+			unsent.erase(unsent.begin(), unsent.begin() + n);
+			continue;
+		}
+
+		// The rest is sent by resume() once there is room
+		if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			watch(true);
+			return true;
+		}
+		disconnect();
+		return false;
+	}
+	watch(false);
+	return true;
+}
+
+/* ********************************************************************************************* */
+void BridgeSender::resume (double now) {
+	struct epoll_event event;
+	if(sock < 0 || epoll_wait(epollFd, &event, 1, 0) <= 0) return;
+	if(connecting) connect(now);
+	else if(event.events & (EPOLLERR | EPOLLHUP)) disconnect();
+	else drain();
+}
+
+/* ********************************************************************************************* */
+bool BridgeSender::send (const uint8_t* data, size_t size, double now) {
+
+	// A datagram is sent whole or not at all
+	if(!params.tcp) return ::send(sock, data, size, 0) == (ssize_t) size;
+
+	// The stream has to finish the batch it started before the next one. In the latest-only mode
+	// a batch is dropped rather than queued behind it; otherwise a queue that does not drain is a
+	// stalled receiver, and the connection is made again (which restarts the compact frames).
+	if(!connect(now) || !drain()) return false;
+	if(!unsent.empty() && params.latestOnly) return false;
+	if(unsent.size() + size > params.maxQueued) {
+		disconnect();
+		return false;
+	}
+	unsent.insert(unsent.end(), data, data + size);
+	drain();
+	return true;
+}
+
+/* ********************************************************************************************* */
+void BridgeSender::push (const uint8_t* frame, size_t size, double receivedAt, float validity) {
+
+	// A frame that does not fit goes in the next batch
+	if(!offsets.empty() && batch.size() + sizeof(BridgeRecord) + size > params.maxBytes) flush();
+
+	BridgeRecord record;
+	record.sequence = 0, record.size = size, record.age = 0.0f, record.validity = validity;
+	offsets.push_back(batch.size());
+	received.push_back(receivedAt);
+	batch.insert(batch.end(), (const uint8_t*) &record, (const uint8_t*) &record + sizeof(record));
+	batch.insert(batch.end(), frame, frame + size);
+	if(params.latestOnly || offsets.size() >= params.maxFrames) flush();
+}
+
+/* ********************************************************************************************* */
+void BridgeSender::poll (double now) {
+	if(!offsets.empty() && now - received[0] >= params.flushTimeout) flush();
+	else if(params.tcp && sock >= 0 && !connecting) drain();
+}
+
+/* ********************************************************************************************* */
+void BridgeSender::flush () {
+
+	if(offsets.empty()) return;
+
+	// Fill in the header and the sequence numbers and ages of the records
+	BridgeBatch header;
+	header.sentReal = bridgeRealtime(), header.sentMono = bridgeMonotonic();
+	header.magic = BRIDGE_MAGIC, header.session = session, header.sequence = batchSequence;
+	header.bytes = batch.size() - sizeof(header), header.count = offsets.size();
+	header.flags = params.compact ? BRIDGE_COMPACT : 0, header.reserved = 0;
+	memcpy(&batch[0], &header, sizeof(header));
+	for(size_t i = 0; i < offsets.size(); i++) {
+		BridgeRecord record;
+		memcpy(&record, &batch[offsets[i]], sizeof(record));
+		record.sequence = frameSequence + i;
+		record.age = (float) (header.sentMono - received[i]);
+		memcpy(&batch[offsets[i]], &record, sizeof(record));
+	}
+
+	// Only the frames that went out use up sequence numbers, so the receiver's gaps are the losses
+	if(send(&batch[0], batch.size(), header.sentMono)) {
+		frameSequence += offsets.size();
+		batchSequence++;
+		numFrames += offsets.size();
+		numBatches++;
+		numBytes += batch.size();
+	}
+	else numDropped += offsets.size();
+	batch.resize(sizeof(BridgeBatch));
+	offsets.clear();
+	received.clear();
+}
+
+/* ********************************************************************************************* */
+BridgeReceiver::BridgeReceiver (const BridgeParams& params) : tcp(false), maxFrame(params.maxFrame),
+	maxBatch(sizeof(BridgeBatch) + std::max(params.maxBytes, sizeof(BridgeRecord) + params.maxFrame)), epollFd(-1),
+	sock(-1), connection(-1), buffer(65536),
+	buffered(0), known(false), session(0), nextSequence(0), numFrames(0), numBatches(0), numLost(0), numLate(0),
+	numMalformed(0) {}
+
+/* ********************************************************************************************* */
+BridgeReceiver::~BridgeReceiver () {
+	if(connection >= 0) close(connection);
+	if(sock >= 0) close(sock);
+	if(epollFd >= 0) close(epollFd);
+}
+
+/* ********************************************************************************************* */
+bool BridgeReceiver::open (bool tcp, const struct sockaddr_in& address) {
+	this->tcp = tcp;
+	sock = socket(AF_INET, (tcp ? SOCK_STREAM : SOCK_DGRAM) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	int one = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if(bind(sock, (const struct sockaddr*) &address, sizeof(address)) != 0) return false;
+	if(tcp && listen(sock, 1) != 0) return false;
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event event;
+	event.events = EPOLLIN, event.data.fd = sock;
+	return epoll_ctl(epollFd, EPOLL_CTL_ADD, sock, &event) == 0;
+}
+
+/* ********************************************************************************************* */
+void BridgeReceiver::accept () {
+
+	int fd = accept4(sock, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if(fd < 0) return;
+
+	// A new connection replaces the old one, i.e. after the sender restarted
+	if(connection >= 0) {
+		epoll_ctl(epollFd, EPOLL_CTL_DEL, connection, NULL);
+		close(connection);
+	}
+	connection = fd, buffered = 0;
+	struct epoll_event event;
+	event.events = EPOLLIN, event.data.fd = connection;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, connection, &event);
+}
+
+/* ********************************************************************************************* */
+void BridgeReceiver::parse (const uint8_t* data, size_t size, double nowReal, double nowMono,
+		std::vector <BridgeFrame>& out) {
+
+	BridgeBatch header;
+	if(size < sizeof(header)) { numMalformed++; return; }
+	memcpy(&header, data, sizeof(header));
+	if(header.magic != BRIDGE_MAGIC || sizeof(header) + header.bytes != size) { numMalformed++; return; }
+	numBatches++;
+
+	// A new session restarts the sequence numbers
+	if(header.session != session) session = header.session, known = false;
+	double network = nowReal - header.sentReal;
+	double offset = (nowMono - network) - header.sentMono;
+
+	const uint8_t *p = data + sizeof(header), *end = data + size;
+	for(size_t i = 0; i < header.count; i++) {
+		BridgeRecord record;
+		if((size_t) (end - p) < sizeof(record)) { numMalformed++; return; }
+		memcpy(&record, p, sizeof(record));
+		p += sizeof(record);
+		if((size_t) (end - p) < record.size || record.size > maxFrame) { numMalformed++; return; }
+
+		// Drop the frames older than the last delivered one and count the gaps
+		if(known && (int32_t) (record.sequence - nextSequence) < 0) numLate++;
+		else {
+			if(known) numLost += record.sequence - nextSequence;
+			nextSequence = record.sequence + 1, known = true;
+			BridgeFrame frame;
+			frame.data = NULL, frame.size = record.size, frame.sequence = record.sequence;
+			frame.latency = network + record.age, frame.offset = offset, frame.validity = record.validity;
+			frame.compact = header.flags & BRIDGE_COMPACT, frame.newest = false;
+			dataOffsets.push_back(storage.size());
+			storage.insert(storage.end(), p, p + record.size);
+			out.push_back(frame);
+		}
+		p += record.size;
+	}
+}
+
+/* ********************************************************************************************* */
+void BridgeReceiver::receive (const BridgeHandler& handler) {
+
+	// Collect everything that arrived; the frames are copied out of the socket buffer
+	double nowReal = bridgeRealtime(), nowMono = bridgeMonotonic();
+	pending.clear(), storage.clear(), dataOffsets.clear();
+	if(!tcp) {
+		ssize_t n;
+		while((n = recv(sock, &buffer[0], buffer.size(), MSG_TRUNC)) > 0) {
+			if((size_t) n > buffer.size()) numMalformed++;
+			else parse(&buffer[0], n, nowReal, nowMono, pending);
+		}
+	}
+	else {
+		accept();
+		bool closed = false;
+		// Up to a full buffer, the rest is read the next time
+		while(connection >= 0 && buffered < buffer.size()) {
+			ssize_t n = read(connection, &buffer[buffered], buffer.size() - buffered);
+			if(n > 0) { buffered += n; continue; }
+			closed = (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK));
+			break;
+		}
+
+		// Parse the complete batches and keep the rest for the next time
+		size_t offset = 0;
+		while(buffered - offset >= sizeof(BridgeBatch)) {
+			BridgeBatch header;
+			memcpy(&header, &buffer[offset], sizeof(header));
+			if(header.magic != BRIDGE_MAGIC) {
+				numMalformed++, closed = true;
+				break;
+			}
+			size_t total = sizeof(header) + header.bytes;
+			if(total > maxBatch) {
+				numMalformed++, closed = true;
+				break;
+			}
+			if(buffered - offset < total) {
+				if(total > buffer.size()) buffer.resize(total);
+				break;
+			}
+			parse(&buffer[offset], total, nowReal, nowMono, pending);
+			offset += total;
+		}
+		memmove(&buffer[0], &buffer[offset], buffered - offset);
+		buffered -= offset;
+		if(closed && connection >= 0) {
+			epoll_ctl(epollFd, EPOLL_CTL_DEL, connection, NULL);
+			close(connection);
+			connection = -1, buffered = 0;
+		}
+	}
+
+	// Deliver them in order
+	if(pending.empty()) return;
+	pending.back().newest = true;
+	numFrames += pending.size();
+	for(size_t i = 0; i < pending.size(); i++) {
+		pending[i].data = &storage[dataOffsets[i]];
+		handler(pending[i]);
+	}
+}
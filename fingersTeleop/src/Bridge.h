@@ -0,0 +1,184 @@
+/**
+ * @file Bridge.h
+ * @date Oct 18, 2026
+ * @brief Carries the frames of an ach channel to another machine over UDP or TCP. The sender
+ * batches frames until the batch is full or its oldest frame has waited the flush timeout, and
+ * numbers every frame so that the receiver can count the lost ones; the batch stamps let the
+ * receiver compute each frame's latency from the sender's receipt. In the latest-only mode every
+ * frame is sent right away and dropped rather than queued if the socket is not ready, and the
+ * receiver only has to republish the newest frame of what arrived together. Otherwise the TCP
+ * batches queue up behind a slow receiver, never blocking the sender: its fd() wakes the event
+ * loop when the socket has room again.
+ *
+ * A batch is a BridgeBatch header followed by 'count' records of a BridgeRecord header and the
+ * frame. Over TCP the batches follow each other on the stream; over UDP each is one datagram.
+ * Both ends have to have the same byte order. The latencies assume that the clocks of the
+ * two machines are synchronized (NTP or PTP); over 127.0.0.1 they are exact.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include <netinet/in.h>
+
+#define BRIDGE_MAGIC 0x3152424c			///< "LBR1"
+#define BRIDGE_COMPACT 0x1					///< Flag of a batch whose frames are PoseCodec frames
+
+/// The header of a batch
+struct BridgeBatch {
+	double sentReal;				///< CLOCK_REALTIME when the batch was sent, for the latency
+	double sentMono;				///< CLOCK_MONOTONIC of the sender at the same time
+	uint32_t magic;
+	uint32_t session;				///< Picked by each sender so that the receiver notices a restart
+	uint32_t sequence;			///< Of the batch
+	uint32_t bytes;				///< The size of the records after this header
+	uint16_t count;				///< The number of records
+	uint16_t flags;
+	uint32_t reserved;
+};
+
+/// The header of a frame in a batch
+struct BridgeRecord {
+	uint32_t sequence;			///< Of the frame; consecutive across batches
+	uint32_t size;					///< Of the frame that follows
+	float age;						///< The time from the sender's receipt of the frame to the batch send (s)
+	float validity;				///< The validity of a compact frame, until - time (s)
+};
+
+static_assert(sizeof(BridgeBatch) == 40 && sizeof(BridgeRecord) == 16, "the bridge headers are packed");
+
+/// The transport and the batching
+struct BridgeParams {
+	bool tcp;
+	bool latestOnly;				///< Send every frame on its own and drop it if it can not be sent now
+	bool compact;					///< Mark the batches as PoseCodec frames
+	size_t maxFrames;				///< The largest batch
+	size_t maxBytes;				///< The largest batch in bytes; a larger frame is sent alone
+	size_t maxQueued;				///< The most bytes queued over TCP; more drop the connection
+	size_t maxFrame;				///< The largest frame the receiver takes; a larger one drops the connection
+	double flushTimeout;			///< The longest a frame waits in a batch (s)
+
+	BridgeParams ();
+};
+
+/// Reads "udp://host:port" or "tcp://host:port" (host an IPv4 address or name); false otherwise
+bool parseEndpoint (const char* text, bool& tcp, struct sockaddr_in& address);
+
+/// The monotonic and the wall clock in seconds
+double bridgeMonotonic ();
+double bridgeRealtime ();
+
+/* ********************************************************************************************* */
+class BridgeSender {
+public:
+
+	BridgeSender (const BridgeParams& params = BridgeParams());
+	~BridgeSender ();
+
+	/// Sets the receiver's address; a TCP connection is made on the first frame and again after
+	/// it breaks, at most once a second
+	void open (const struct sockaddr_in& address);
+
+	/// Adds a frame that the sender got at 'receivedAt' (monotonic); sends the batch when full, or
+	/// right away in the latest-only mode
+	void push (const uint8_t* frame, size_t size, double receivedAt, float validity = 0.0f);
+
+	/// Sends the batch if its oldest frame waited for the flush timeout; call it from a timer
+	void poll (double now);
+
+	/// An epoll descriptor that is readable when a TCP connection is made or has room for the
+	/// queued batches, i.e. for EventLoop::readable; call resume() then
+	int fd () const { return epollFd; }
+
+	/// Finishes a TCP connection and sends what is queued as far as the socket takes it
+	void resume (double now);
+
+	/// Sends the batch now
+	void flush ();
+
+	size_t frames () const { return numFrames; }			///< Sent
+	size_t batches () const { return numBatches; }
+	size_t dropped () const { return numDropped; }			///< Not sent: not ready, not connected, queue full
+	size_t bytes () const { return numBytes; }
+	size_t connections () const { return numConnections; }	///< TCP connections made so far
+
+private:
+	bool connect (double now);
+	void disconnect ();
+	bool drain ();
+	void watch (bool writable);
+	bool send (const uint8_t* data, size_t size, double now);
+
+	BridgeParams params;
+	struct sockaddr_in address;
+	int sock, epollFd;
+	bool connecting;						///< A TCP connection is in progress
+	bool writable;							///< The socket is watched for room
+	double lastAttempt;					///< Of a TCP connection
+	uint32_t session, batchSequence, frameSequence;
+	std::vector <uint8_t> batch;			///< The header and the records
+	std::vector <double> received;		///< The receipt times of the records
+	std::vector <size_t> offsets;			///< The record offsets in the batch
+	std::vector <uint8_t> unsent;			///< The queued TCP batches, the first one maybe partly sent
+	size_t numFrames, numBatches, numDropped, numBytes, numConnections;
+};
+
+/* ********************************************************************************************* */
+/// A frame delivered by the receiver; the data is only valid in the handler
+struct BridgeFrame {
+	const uint8_t* data;
+	size_t size;
+	uint32_t sequence;
+	double latency;				///< From the sender's receipt to now (s)
+	double offset;					///< Added to the sender's monotonic times gives the local ones (s)
+	float validity;
+	bool compact;
+	bool newest;					///< The newest of the frames delivered together
+};
+
+typedef std::function <void (const BridgeFrame& frame)> BridgeHandler;
+
+/* ********************************************************************************************* */
+class BridgeReceiver {
+public:
+
+	BridgeReceiver (const BridgeParams& params = BridgeParams());
+	~BridgeReceiver ();
+
+	/// Binds to the address (UDP) or listens on it (TCP); false on errors
+	bool open (bool tcp, const struct sockaddr_in& address);
+
+	/// An epoll descriptor that is readable when there is data, i.e. for EventLoop::readable
+	int fd () const { return epollFd; }
+
+	/// Reads what arrived and calls the handler with the frames in order. Frames older than one
+	/// already delivered (reordered datagrams) are dropped, and a gap in the sequence is counted
+	/// as lost. A TCP batch larger than BridgeParams::maxBytes or than a record of the largest
+	/// frame is malformed and drops the connection before it is buffered.
+	void receive (const BridgeHandler& handler);
+
+	size_t frames () const { return numFrames; }			///< Delivered
+	size_t batches () const { return numBatches; }
+	size_t lost () const { return numLost; }
+	size_t late () const { return numLate; }
+	size_t malformed () const { return numMalformed; }
+
+private:
+	void accept ();
+	void parse (const uint8_t* data, size_t size, double nowReal, double nowMono, std::vector <BridgeFrame>& out);
+
+	bool tcp;
+	size_t maxFrame, maxBatch;
+	int epollFd, sock, connection;
+	std::vector <uint8_t> buffer;			///< A datagram or the unparsed part of the stream
+	size_t buffered;
+	std::vector <BridgeFrame> pending;		///< The frames of a receive() and their copied data
+	std::vector <uint8_t> storage;
+	std::vector <size_t> dataOffsets;
+	bool known;								///< A frame of the session has been delivered
+	uint32_t session, nextSequence;
+	size_t numFrames, numBatches, numLost, numLate, numMalformed;
+};
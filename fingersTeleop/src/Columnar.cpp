@@ -0,0 +1,46 @@
+/**
+ * @file Columnar.cpp
+ * @date Oct 18, 2026
+ * @brief Columnar tables written as .npy files.
+ */
+
+#include "Columnar.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* ********************************************************************************************* */
+size_t ColumnTable::add (const std::string& name) {
+	names.push_back(name);
+	columns.push_back(std::vector <double> (rows, NAN));
+	return columns.size() - 1;
+}
+
+/* ********************************************************************************************* */
+bool ColumnTable::write (const std::string& directory) const {
+	for(size_t i = 0; i < columns.size(); i++) {
+		const double* data = columns[i].empty() ? NULL : &columns[i][0];
+		if(!writeNpy(directory + "/" + names[i] + ".npy", data, rows)) return false;
+	}
+	return true;
+}
+
+/* ********************************************************************************************* */
+bool writeNpy (const std::string& path, const double* data, size_t count) {
+
+	// The header is a python dict padded with spaces so that the data starts 64-byte aligned
+	char dict [128];
+	snprintf(dict, sizeof(dict), "{'descr': '<f8', 'fortran_order': False, 'shape': (%zu,), }", count);
+	std::string header = std::string("\x93NUMPY\x01\x00", 8) + "  " + dict;
+	header.append(63 - (header.size() % 64), ' ');
+	header += '\n';
+	uint16_t headerLength = header.size() - 10;
+	header[8] = headerLength & 0xff, header[9] = headerLength >> 8;
+
+	// Write the header and the data
+	FILE* file = fopen(path.c_str(), "wb");
+	if(file == NULL) return false;
+	bool ok = (fwrite(header.data(), 1, header.size(), file) == header.size()) &&
+		(count == 0 || fwrite(data, sizeof(double), count, file) == count);
+	return (fclose(file) == 0) && ok;
+}
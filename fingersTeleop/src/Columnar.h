@@ -0,0 +1,40 @@
+/**
+ * @file Columnar.h
+ * @date Oct 18, 2026
+ * @brief A table stored as one contiguous array of doubles per field. Each column is written as
+ * a separate .npy file in a directory so that analysis tools can map it directly, i.e.
+ * numpy.load("out/time.npy", mmap_mode="r").
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/* ********************************************************************************************* */
+class ColumnTable {
+public:
+
+	/// Creates a table with the given number of rows and no columns
+	ColumnTable (size_t rows) : rows(rows) {}
+
+	/// Adds a column filled with NaN and returns its index
+	size_t add (const std::string& name);
+
+	/// Returns the contiguous data of a column
+	double* column (size_t i) { return &columns[i][0]; }
+
+	size_t numRows () const { return rows; }
+	size_t numColumns () const { return columns.size(); }
+
+	/// Writes <directory>/<name>.npy for each column; the directory has to exist
+	bool write (const std::string& directory) const;
+
+private:
+	size_t rows;
+	std::vector <std::string> names;
+	std::vector <std::vector <double> > columns;
+};
+
+/// Writes a 1D array of doubles in the numpy .npy (version 1.0) format
+bool writeNpy (const std::string& path, const double* data, size_t count);
@@ -0,0 +1,39 @@
+/**
+ * @file CompactLiberty.cpp
+ * @date Oct 18, 2026
+ * @brief PoseCodec frames in place of packed liberty messages on the bridge.
+ */
+
+#include "CompactLiberty.h"
+#include <math.h>
+
+/* ********************************************************************************************* */
+/// Delta frames need every frame in order, which only a TCP bridge that does not skip frames has
+static PoseCodecParams codecParams (const BridgeParams& params) {
+	PoseCodecParams codec;
+	if(!params.tcp || params.latestOnly) codec.keyframeInterval = 1;
+	return codec;
+}
+
+/* ********************************************************************************************* */
+CompactLibertyEncoder::CompactLibertyEncoder (const BridgeParams& params) : encoder(codecParams(params)) {}
+
+/* ********************************************************************************************* */
+bool CompactLibertyEncoder::encode (const uint8_t* message, size_t size, ProtobufCAllocator* allocator,
+		uint8_t* out, size_t& outSize, float& validity) {
+	double time, until, readings [4][7];
+	if(!unpackReadings(message, size, allocator, time, readings, &until)) return false;
+	if(isnan(time) || isnan(readings[0][0] + readings[1][0] + readings[2][0] + readings[3][0])) return false;
+	validity = isnan(until) ? 0.0f : (float) (until - time);
+	outSize = encoder.encode(time, readings, out);
+	return true;
+}
+
+/* ********************************************************************************************* */
+size_t CompactLibertyDecoder::decode (const BridgeFrame& frame, uint8_t* out, size_t capacity) {
+	double time, readings [4][7];
+	if(!decoder.decode(frame.data, frame.size, time, readings)) return 0;
+	time += frame.offset;
+	double validity = (frame.validity > 0.0f) ? frame.validity : defaultValidity;
+	return packer.pack(time, time + validity, readings, out, capacity);
+}
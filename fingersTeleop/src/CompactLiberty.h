@@ -0,0 +1,51 @@
+/**
+ * @file CompactLiberty.h
+ * @date Oct 18, 2026
+ * @brief The compact mode of the bridge for liberty channels: the sender replaces each packed
+ * message with its PoseCodec frame and the receiver packs a message again. The metadata times
+ * are moved to the receiver's monotonic clock on the way so that its deadline checks still hold,
+ * but the rest of the metadata is not carried.
+ */
+
+#pragma once
+
+#include "Bridge.h"
+#include "Liberty.h"
+#include "PoseCodec.h"
+
+/* ********************************************************************************************* */
+class CompactLibertyEncoder {
+public:
+
+	/// Only keyframes are sent if frames may be lost or skipped on the way
+	CompactLibertyEncoder (const BridgeParams& params);
+
+	/// Encodes a packed liberty message into out (of POSE_CODEC_MAX_FRAME bytes) and sets the
+	/// validity of the message; false if it has no time or not all the sensors
+	bool encode (const uint8_t* message, size_t size, ProtobufCAllocator* allocator, uint8_t* out,
+		size_t& outSize, float& validity);
+
+	/// Makes the next frame a keyframe, i.e. after a reconnection
+	void reset () { encoder.reset(); }
+
+private:
+	PoseEncoder encoder;
+};
+
+/* ********************************************************************************************* */
+class CompactLibertyDecoder {
+public:
+
+	CompactLibertyDecoder (double defaultValidity = 0.1) : defaultValidity(defaultValidity) {}
+
+	/// Decodes a received frame, shifts its time to the local clock and packs it into out; returns
+	/// the packed size or 0 if it could not be decoded (waiting for a keyframe) or did not fit
+	size_t decode (const BridgeFrame& frame, uint8_t* out, size_t capacity);
+
+	size_t skipped () const { return decoder.skipped(); }
+
+private:
+	double defaultValidity;			///< For frames that were sent without a deadline
+	PoseDecoder decoder;
+	LibertyPacker packer;
+};
@@ -0,0 +1,71 @@
+/**
+ * @file Deadline.cpp
+ * @date Oct 18, 2026
+ * @brief Validity deadlines of messages and the policies for stale data.
+ */
+
+#include "Deadline.h"
+#include <math.h>
+#include <string.h>
+
+static const char* policyNames [] = {"hold", "decay", "event"};
+
+/* ********************************************************************************************* */
+const char* stalePolicyName (StalePolicy policy) {
+	return policyNames[policy];
+}
+
+/* ********************************************************************************************* */
+bool parseStalePolicy (const char* name, StalePolicy& policy) {
+	for(size_t i = 0; i < 3; i++) {
+		if(strcmp(name, policyNames[i]) != 0) continue;
+		policy = (StalePolicy) i;
+		return true;
+	}
+	return false;
+}
+
+/* ********************************************************************************************* */
+double metadataUntil (const Somatic__Metadata* meta) {
+	if(meta == NULL || meta->until == NULL) return NAN;
+	return meta->until->sec + (meta->until->has_nsec ? meta->until->nsec * 1e-9 : 0.0);
+}
+
+/* ********************************************************************************************* */
+DeadlineParams::DeadlineParams () : policy(STALE_HOLD), decayTime(1.0), defaultValidity(0.1) {}
+
+/* ********************************************************************************************* */
+DeadlineGuard::DeadlineGuard (const DeadlineParams& params) : parameters(params), validUntil(-INFINITY),
+	reported(false), numAccepted(0), numExpired(0), numStalls(0) {}
+
+/* ********************************************************************************************* */
+bool DeadlineGuard::accept (double until, double now) {
+
+	// Frames without a deadline are valid for the default validity from their arrival
+	if(isnan(until)) until = (parameters.defaultValidity > 0.0) ? now + parameters.defaultValidity : -INFINITY;
+	if(!(now <= until)) {
+		numExpired++;
+		return false;
+	}
+
+	// A reordered older frame does not pull the deadline back
+	if(until > validUntil) validUntil = until;
+	reported = false;
+	numAccepted++;
+	return true;
+}
+
+/* ********************************************************************************************* */
+double DeadlineGuard::decay (double now) const {
+	if(now <= validUntil) return 0.0;
+	if(parameters.decayTime <= 0.0 || isinf(validUntil)) return 1.0;
+	return fmin(1.0, (now - validUntil) / parameters.decayTime);
+}
+
+/* ********************************************************************************************* */
+bool DeadlineGuard::stalled (double now) {
+	if(reported || numAccepted == 0 || now <= validUntil) return false;
+	reported = true;
+	numStalls++;
+	return true;
+}
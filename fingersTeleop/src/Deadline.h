@@ -0,0 +1,79 @@
+/**
+ * @file Deadline.h
+ * @date Oct 18, 2026
+ * @brief Enforces the validity window that publishers stamp on their messages (meta->until, e.g.
+ * somatic_metadata_set_until_duration): frames that arrive past it are dropped and counted, and
+ * once the last accepted frame expires the consumer applies a policy instead of acting on the
+ * stale value. The stamps come from aa_tm_now, i.e. CLOCK_MONOTONIC, so the publisher has to run
+ * on the same host. Checking a frame is a comparison against one clock read done by the caller.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <somatic.pb-c.h>
+
+/// What a consumer does when no fresh frame arrived before the deadline
+enum StalePolicy {
+	STALE_HOLD = 0,		///< Keep acting on the last value
+	STALE_DECAY,			///< Blend the last value to a safe one over DeadlineParams::decayTime
+	STALE_EVENT				///< Raise an event once per stall (e.g. stop or disengage)
+};
+
+/// Returns the name of a policy ("hold", "decay" or "event")
+const char* stalePolicyName (StalePolicy policy);
+
+/// Reads a policy name; false if it is not one
+bool parseStalePolicy (const char* name, StalePolicy& policy);
+
+/// Returns the validity deadline of a message in seconds, or NAN if it has none
+double metadataUntil (const Somatic__Metadata* meta);
+
+/// The parameters of a guard
+struct DeadlineParams {
+	StalePolicy policy;
+	double decayTime;					///< The time to reach the safe value after the deadline (s)
+	double defaultValidity;			///< The validity of unstamped frames from their arrival (s); 0 drops them
+
+	DeadlineParams ();
+};
+
+/* ********************************************************************************************* */
+class DeadlineGuard {
+public:
+
+	DeadlineGuard (const DeadlineParams& params = DeadlineParams());
+
+	/// Checks the deadline of a frame (NAN if it has none) against the monotonic time now; returns
+	/// false for an expired frame, which is counted and should not be used
+	bool accept (double until, double now);
+
+	/// True if no frame has been accepted yet or the last one has expired
+	bool stale (double now) const { return !(now <= validUntil); }
+
+	/// The amount of decay towards the safe value: 0 while fresh, rising linearly to 1 over the
+	/// decay time after the deadline (and 1 before the first frame)
+	double decay (double now) const;
+
+	/// True once per stall: the first time it is called after an accepted frame has expired. Only
+	/// counts stalls after at least one frame so that a late publisher is not reported.
+	bool stalled (double now);
+
+	/// Changes the parameters; the deadline of the last frame is kept
+	void configure (const DeadlineParams& params) { parameters = params; }
+
+	/// Takes the deadline of the last frame of a previous instance, e.g. from a checkpoint
+	void resume (double deadline) { validUntil = deadline; }
+
+	const DeadlineParams& params () const { return parameters; }
+	double deadline () const { return validUntil; }
+	size_t accepted () const { return numAccepted; }
+	size_t expired () const { return numExpired; }
+	size_t stalls () const { return numStalls; }
+
+private:
+	DeadlineParams parameters;
+	double validUntil;				///< The deadline of the newest accepted frame
+	bool reported;						///< The current stall has been reported by stalled()
+	size_t numAccepted, numExpired, numStalls;
+};
@@ -0,0 +1,62 @@
+/**
+ * @file Decimator.cpp
+ * @date Oct 18, 2026
+ * @brief Window averages of the liberty frames for the lower rate channels.
+ */
+
+#include "Decimator.h"
+#include <Eigen/Eigenvalues>
+
+using namespace Eigen;
+
+/* ********************************************************************************************* */
+LibertyDecimator::LibertyDecimator (size_t factor) : windowSize(factor < 1 ? 1 : factor), count(0),
+		firstTime(0.0), lastTime(0.0), lastUntil(0.0), timeSum(0.0), outputTime(0.0), outputUntil(0.0) {
+	for(size_t s = 0; s < 4; s++) {
+		lastOrientations[s] = Vector4d(0.0, 0.0, 0.0, 1.0);
+		for(size_t k = 0; k < 7; k++) averaged[s][k] = 0.0;
+	}
+}
+
+/* ********************************************************************************************* */
+bool LibertyDecimator::add (double time, double until, const double readings [4][7]) {
+
+	// Start a window with the first frame, or over if the publisher went back in time
+	if(count > 0 && time < lastTime) count = 0;
+	if(count == 0) {
+		firstTime = time, timeSum = 0.0;
+		for(size_t s = 0; s < 4; s++) positions[s].setZero(), orientations[s].setZero();
+	}
+
+	// Accumulate the positions and the outer products of the quaternions (x, y, z, w)
+	for(size_t s = 0; s < 4; s++) {
+		positions[s] += Vector3d(readings[s][0], readings[s][1], readings[s][2]);
+		Vector4d q (readings[s][3], readings[s][4], readings[s][5], readings[s][6]);
+		orientations[s].noalias() += q * q.transpose();
+		lastOrientations[s] = q;
+	}
+	lastTime = time, lastUntil = until, timeSum += time;
+	if(++count < windowSize) return false;
+
+	// Average: the mean position and the principal eigenvector of the orientations, on the side
+	// of the last quaternion so that the output does not flip sign from window to window
+	for(size_t s = 0; s < 4; s++) {
+		Vector3d p = positions[s] / count;
+		Vector4d q;
+		if(count == 1) q = lastOrientations[s];
+		else {
+			SelfAdjointEigenSolver <Matrix4d> solver (orientations[s]);
+			q = solver.eigenvectors().col(3);
+			if(q.dot(lastOrientations[s]) < 0.0) q = -q;
+		}
+		for(size_t k = 0; k < 3; k++) averaged[s][k] = p[k];
+		for(size_t k = 0; k < 4; k++) averaged[s][k + 3] = q[k];
+	}
+
+	// The window covers 'count' frame periods
+	double length = (count > 1) ? (lastTime - firstTime) * count / (count - 1) : 0.0;
+	outputTime = timeSum / count;
+	outputUntil = lastUntil + length;
+	count = 0;
+	return true;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file Decimator.h
+ * @date Oct 18, 2026
+ * @brief Rate reduction of the liberty stream for slow consumers. Every 'factor' frames become
+ * one frame that is their average rather than the last of them, so that motion faster than the
+ * output rate (tremor, tracker noise) is filtered out instead of aliased into slow drift. The
+ * positions are averaged directly and the orientations with the quaternion average of Markley
+ * et al., the principal eigenvector of the sum of q q^T, which does not depend on the signs of
+ * the quaternions. Decimators chain: a 60 Hz stage can feed a 10 Hz one.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <Eigen/Dense>
+
+/* ********************************************************************************************* */
+class LibertyDecimator {
+public:
+
+	/// Averages every 'factor' frames; a factor of 1 passes the frames through
+	LibertyDecimator (size_t factor = 4);
+
+	/// Adds a frame of the 4 sensor readings (x, y, z, qx, qy, qz, qw) with its metadata time and
+	/// validity deadline; returns true when it completes a window and the output is ready. A
+	/// frame older than the last one (a publisher restart) starts a new window.
+	bool add (double time, double until, const double readings [4][7]);
+
+	/// The averaged readings of the last complete window
+	const double (&output () const)[4][7] { return averaged; }
+
+	/// The time of the output is the middle of its window, which is where a centered average
+	/// belongs; it is valid until the last frame's deadline plus the window length, i.e. until
+	/// the next output should have arrived
+	double time () const { return outputTime; }
+	double until () const { return outputUntil; }
+
+	size_t factor () const { return windowSize; }
+
+	/// Drops the partial window
+	void reset () { count = 0; }
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+	size_t windowSize, count;
+	double firstTime, lastTime, lastUntil, timeSum;
+	Eigen::Vector3d positions [4];				///< Sums over the window
+	Eigen::Matrix4d orientations [4];			///< Sums of q q^T over the window
+	Eigen::Vector4d lastOrientations [4];		///< To pick the sign of the average
+	double averaged [4][7];
+	double outputTime, outputUntil;
+};
@@ -0,0 +1,176 @@
+/**
+ * @file FingersCore.cpp
+ * @date Oct 18, 2026
+ * @brief The fingers teleoperation chain in one process.
+ */
+
+#include "FingersCore.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace Eigen;
+
+/* ********************************************************************************************* */
+FingersCoreParams::FingersCoreParams () : checkHealth(true), scale(1.0) {
+	memset(offsets, 0, sizeof(offsets));
+}
+
+/* ********************************************************************************************* */
+/// Reads a number that is the whole value
+static bool parseNumber (const char* value, double& number) {
+	char* end;
+	number = strtod(value, &end);
+	return end != value && *end == '\0' && !isnan(number);
+}
+
+/* ********************************************************************************************* */
+/// Reads "true"/"false" or 1/0
+static bool parseFlag (const char* value, bool& flag) {
+	if(strcmp(value, "true") == 0 || strcmp(value, "1") == 0) flag = true;
+	else if(strcmp(value, "false") == 0 || strcmp(value, "0") == 0) flag = false;
+	else return false;
+	return true;
+}
+
+/* ********************************************************************************************* */
+bool parseFingersParam (const char* key, const char* value, FingersCoreParams& params) {
+
+	// The flags and the enumerations
+	if(strcmp(key, "checkHealth") == 0) return parseFlag(value, params.checkHealth);
+	if(strcmp(key, "health.clamp") == 0) return parseFlag(value, params.health.clamp);
+	if(strcmp(key, "deadline.policy") == 0) return parseStalePolicy(value, params.deadline.policy);
+	for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) {
+		char name [32];
+		sprintf(name, "grasp.pinch.%zu", i);
+		if(strcmp(key, name) == 0) return parseFlag(value, params.grasp.pinchFingers[i]);
+	}
+
+	// The numbers, within their ranges: no zero periods or steps, and the steps bound how far the
+	// arm moves at once
+	double number;
+	if(!parseNumber(value, number)) return false;
+	struct { const char* key; double* value; double lowest, highest; } numbers [] = {
+		{"scale", &params.scale, 1e-3, 100.0},
+		{"deadline.decayTime", &params.deadline.decayTime, 0.0, 60.0},
+		{"deadline.defaultValidity", &params.deadline.defaultValidity, 1e-3, 10.0},
+		{"health.normTolerance", &params.health.normTolerance, 0.0, 1.0},
+		{"health.maxSpeed", &params.health.maxSpeed, 1e-3, 1e3},
+		{"health.maxAcceleration", &params.health.maxAcceleration, 1e-3, 1e6},
+		{"health.maxAngularSpeed", &params.health.maxAngularSpeed, 1e-3, 1e3},
+		{"health.maxAngularAcceleration", &params.health.maxAngularAcceleration, 1e-3, 1e6},
+		{"health.outlierSigmas", &params.health.outlierSigmas, 1.0, 100.0},
+		{"health.outlierFloor", &params.health.outlierFloor, 0.0, 1.0},
+		{"health.noiseScale", &params.health.noiseScale, 1e-6, 1.0},
+		{"grasp.openEnter", &params.grasp.openEnter, 0.0, M_PI},
+		{"grasp.closedEnter", &params.grasp.closedEnter, 0.0, M_PI},
+		{"grasp.closedExit", &params.grasp.closedExit, 0.0, M_PI},
+		{"grasp.closingVelocity", &params.grasp.closingVelocity, 1e-3, 100.0},
+		{"ik.damping", &params.ik.damping, 0.0, 10.0},
+		{"ik.maxStep", &params.ik.maxStep, 1e-6, 0.5},
+		{"ik.maxCommandStep", &params.ik.maxCommandStep, 1e-6, 0.5},
+		{"ik.budget", &params.ik.budget, 1e-6, 0.1},
+		{"ik.tolerance", &params.ik.tolerance, 1e-12, 1.0}
+	};
+	for(size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+		if(strcmp(key, numbers[i].key) != 0) continue;
+		if(!(number >= numbers[i].lowest && number <= numbers[i].highest)) return false;
+		*numbers[i].value = number;
+		return true;
+	}
+	if(strcmp(key, "ik.maxIterations") == 0) {
+		if(!(number >= 1 && number <= 1000)) return false;
+		params.ik.maxIterations = (size_t) number;
+		return true;
+	}
+
+	// The indexed ones: the joint limits (rad) and the calibration offsets (m)
+	unsigned int index;
+	char axis, end;
+	bool joint = fabs(number) <= 2 * M_PI, offset = fabs(number) <= 1.0;
+	if(sscanf(key, "arm.lower.%u%c", &index, &end) == 1 && index < 7 && joint) params.arm.lowerLimit(index) = number;
+	else if(sscanf(key, "arm.upper.%u%c", &index, &end) == 1 && index < 7 && joint)
+		params.arm.upperLimit(index) = number;
+	else if(sscanf(key, "offset.%u.%c%c", &index, &axis, &end) == 2 && index < 4 && axis >= 'x' && axis <= 'z' &&
+			offset)
+		params.offsets[index][axis - 'x'] = number;
+	else return false;
+	return true;
+}
+
+/* ********************************************************************************************* */
+bool validFingersParams (const FingersCoreParams& params) {
+	const GraspParams& grasp = params.grasp;
+	if(!(grasp.openEnter <= grasp.closedExit && grasp.closedExit <= grasp.closedEnter)) return false;
+	for(size_t i = 0; i < 7; i++) if(!(params.arm.lowerLimit(i) < params.arm.upperLimit(i))) return false;
+	return true;
+}
+
+/* ********************************************************************************************* */
+FingersCore::FingersCore (const FingersCoreParams& params) : params(params), guard(params.deadline),
+		checks(params.health), detector(params.grasp), control(params.arm, params.ik) {
+	control.scale = params.scale;
+}
+
+/* ********************************************************************************************* */
+void FingersCore::configure (const FingersCoreParams& next) {
+	params = next;
+	guard.configure(next.deadline);
+	checks.configure(next.health);
+	detector.configure(next.grasp);
+	control.configure(next.arm, next.ik);
+	control.scale = next.scale;
+}
+
+/* ********************************************************************************************* */
+bool FingersCore::process (const uint8_t* message, size_t size, ProtobufCAllocator* allocator, double now,
+		HandFrame& hand) {
+	double time, until, readings [4][7];
+	if(!unpackReadings(message, size, allocator, time, readings, &until)) return false;
+	return process(time, until, readings, now, hand);
+}
+
+/* ********************************************************************************************* */
+bool FingersCore::process (double time, double until, const double readings [4][7], double now, HandFrame& hand) {
+
+	// Drop the frame if it arrived after its deadline; unstamped frames count from their arrival
+	if(!guard.accept(until, now)) return false;
+	hand.time = isnan(time) ? now : time;
+	hand.until = until;
+
+	// Calibrate and check the readings on a copy; without the checks a frame with a missing
+	// sensor is unusable
+	double checked [4][7];
+	memcpy(checked, readings, sizeof(checked));
+	for(size_t s = 0; s < 4; s++) for(size_t k = 0; k < 3; k++) checked[s][k] += params.offsets[s][k];
+	if(params.checkHealth) checks.check(hand.time, checked, hand.health);
+	else {
+		hand.health.magic = HEALTH_REPORT_MAGIC, hand.health.version = HEALTH_REPORT_VERSION;
+		hand.health.time = hand.time;
+		for(size_t s = 0; s < 4; s++) {
+			hand.health.score[s] = 1.0;
+			hand.health.verdict[s] = HEALTH_OK, hand.health.reasons[s] = 0;
+		}
+	}
+	for(size_t s = 0; s < 4; s++) for(size_t k = 0; k < 7; k++) if(isnan(checked[s][k])) return false;
+
+	// The poses, the palm angle and the finger flexions (0 when straight with the palm)
+	for(size_t s = 0; s < 4; s++) hand.poses[s] = sensorToPose(checked[s]);
+	hand.palmAngle = palmAngle(hand.poses[0]);
+	for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) hand.flexion[i] = M_PI - fingerAngle(hand.poses[0], hand.poses[i + 1]);
+
+	// Classify the hand
+	hand.graspChanged = detector.update(hand.time, hand.flexion);
+	hand.grasp = detector.state();
+	return true;
+}
+
+/* ********************************************************************************************* */
+bool FingersCore::retarget (const HandFrame& hand, const Vector7d* measured, Vector7d& command) {
+	Isometry3d palm = hand.poses[0].isometry();
+	if(!control.engaged()) {
+		if(measured == NULL) return false;
+		control.engage(palm, *measured);
+	}
+	return control.update(palm, command);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file FingersCore.h
+ * @date Oct 18, 2026
+ * @brief The whole fingers teleoperation chain behind one class, for programs that link the
+ * core library instead of chaining the daemons over ach: a liberty frame is decoded (or taken
+ * as readings from an in-process source), checked against its deadline and by the sensor health
+ * checks, converted to poses, reduced to the palm angle and the finger flexions, classified by
+ * the grasp detector and, on request, retargeted to an arm command. Nothing is serialized
+ * between the stages and nothing allocates after construction.
+ *
+ *   FingersCore core;
+ *   HandFrame hand;
+ *   if(core.process(message, size, allocator, now, hand) && core.retarget(hand, &measured, command))
+ *     send(command);
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <somatic.pb-c.h>
+#include "Frames.h"
+#include "Liberty.h"
+#include "Deadline.h"
+#include "SensorHealth.h"
+#include "GraspDetector.h"
+#include "WorkspaceControl.h"
+
+/// The parameters of every stage
+struct FingersCoreParams {
+	DeadlineParams deadline;
+	HealthParams health;
+	bool checkHealth;					///< Run the sensor health checks
+	GraspParams grasp;
+	ArmModel arm;
+	IKParams ik;
+	double scale;						///< Workspace scaling from the palm to the end-effector motion
+	double offsets [4][3];			///< Calibration offsets added to the sensor positions (m)
+
+	FingersCoreParams ();
+};
+
+/// Sets a parameter from a config line (see liveConfig.h), e.g. "scale = 0.5", "ik.damping = 0.1",
+/// "arm.upper.3 = 2.0", "health.maxSpeed = 4", "grasp.closedEnter = 1.1", "deadline.policy = decay"
+/// or "offset.2.z = 0.01" (sensors 0 to 3); false if the key is unknown or the value is not one or
+/// out of the range of the parameter (see FingersCore.cpp), i.e. a zero deadline or a negative step
+bool parseFingersParam (const char* key, const char* value, FingersCoreParams& params);
+
+/// False if parameters contradict each other: the grasp thresholds out of order (open, closed
+/// exit, closed enter) or a joint lower limit not below its upper one
+bool validFingersParams (const FingersCoreParams& params);
+
+/// What the chain computes from a frame
+struct HandFrame {
+	double time, until;							///< The frame's stamps (until is NAN if it has none)
+	Pose <RobotFrame> poses [4];				///< The palm and the 3 fingers
+	double palmAngle;								///< Of the palm normal from the vertical (rad)
+	double flexion [GRASP_NUM_FINGERS];		///< 0 when a finger is straight with the palm (rad)
+	HealthReport health;
+	GraspState grasp;
+	bool graspChanged;
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/* ********************************************************************************************* */
+class FingersCore {
+public:
+
+	FingersCore (const FingersCoreParams& params = FingersCoreParams());
+
+	/// Runs a packed liberty message received at the monotonic time 'now' through the chain;
+	/// returns false if it could not be decoded or arrived past its deadline
+	bool process (const uint8_t* message, size_t size, ProtobufCAllocator* allocator, double now,
+		HandFrame& hand);
+
+	/// The same for readings (x, y, z, qx, qy, qz, qw per sensor) that are already in memory
+	bool process (double time, double until, const double readings [4][7], double now, HandFrame& hand);
+
+	/// Computes the arm command for the palm pose. The first call clutches in at the measured
+	/// configuration, so it returns false until one is given; later calls may pass NULL.
+	bool retarget (const HandFrame& hand, const Vector7d* measured, Vector7d& command);
+
+	/// Changes the parameters between two frames without resetting any state: the windows of the
+	/// grasp detector keep their size and an engaged arm stays engaged. Does not allocate.
+	void configure (const FingersCoreParams& next);
+
+	/// Rate limits a command that is not from retarget(), i.e. of a stale policy (see
+	/// WorkspaceControl::limit)
+	void limit (Vector7d& command) { control.limit(command); }
+
+	/// Clutches out; the next retarget() clutches in again
+	void disengage () { control.disengage(); }
+	bool engaged () const { return control.engaged(); }
+
+	DeadlineGuard& deadline () { return guard; }
+	const LibertyHealth& health () const { return checks; }
+	const GraspDetector& grasp () const { return detector; }
+	const WorkspaceControl& workspace () const { return control; }
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+	FingersCoreParams params;
+	DeadlineGuard guard;
+	LibertyHealth checks;
+	GraspDetector detector;
+	WorkspaceControl control;
+};
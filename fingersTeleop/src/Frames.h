@@ -0,0 +1,98 @@
+/**
+ * @file Frames.h
+ * @date Oct 18, 2026
+ * @brief Poses tagged with the coordinate frame they are expressed in. The conversions between
+ * frames are axis-aligned, so they are composed at compile time into one signed permutation of
+ * the position and one of the quaternion coefficients; converting a pose is then a few sign
+ * flips. There is no conversion between frames without a FrameChange, and a pose of one frame
+ * can not be passed where another is expected.
+ */
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+/// The frame of the raw Polhemus Liberty readings: (x, y, z, qx, qy, qz, qw) from the cube
+struct PolhemusFrame {};
+
+/// The robot convention, i.e. the Polhemus frame with the y and z axes flipped
+struct RobotFrame {};
+
+/* ********************************************************************************************* */
+/// A 3x3 matrix with a single +1 or -1 in each row and column, i.e. an axis-aligned rotation or
+/// one combined with the inversion (-I). Row i picks the input component axis[i] times sign[i].
+struct AxisMap {
+	int axis [3];
+	int sign [3];
+
+	/// The map that applies b first and then this one
+	constexpr AxisMap operator* (const AxisMap& b) const {
+		return AxisMap {{b.axis[axis[0]], b.axis[axis[1]], b.axis[axis[2]]},
+			{sign[0] * b.sign[axis[0]], sign[1] * b.sign[axis[1]], sign[2] * b.sign[axis[2]]}};
+	}
+
+	Eigen::Vector3d operator* (const Eigen::Vector3d& v) const {
+		return Eigen::Vector3d(sign[0] * v(axis[0]), sign[1] * v(axis[1]), sign[2] * v(axis[2]));
+	}
+
+	/// Maps the vector part of a quaternion: for a rotation C this is C q C^-1, for the
+	/// inversion it is the conjugate q^-1
+	Eigen::Quaterniond operator* (const Eigen::Quaterniond& q) const {
+		return Eigen::Quaterniond(q.w(), sign[0] * q.vec()(axis[0]), sign[1] * q.vec()(axis[1]),
+			sign[2] * q.vec()(axis[2]));
+	}
+};
+
+/// The axis-aligned constants the conversions are made of
+constexpr AxisMap identityMap () { return AxisMap {{0, 1, 2}, {1, 1, 1}}; }
+constexpr AxisMap inversionMap () { return AxisMap {{0, 1, 2}, {-1, -1, -1}}; }
+constexpr AxisMap halfTurnX () { return AxisMap {{0, 1, 2}, {1, -1, -1}}; }
+constexpr AxisMap quarterTurnY () { return AxisMap {{2, 1, 0}, {1, 1, -1}}; }
+
+/* ********************************************************************************************* */
+/// A position and an orientation in Frame
+template <class Frame>
+struct Pose {
+	Eigen::Vector3d position;
+	Eigen::Quaterniond orientation;
+
+	Pose () : position(Eigen::Vector3d::Zero()), orientation(Eigen::Quaterniond::Identity()) {}
+	Pose (const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation) : position(position),
+		orientation(orientation) {}
+
+	Eigen::Isometry3d isometry () const {
+		Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+		pose.linear() = orientation.toRotationMatrix();
+		pose.translation() = position;
+		return pose;
+	}
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/// The conversion of poses from one frame to another: position() maps the positions and
+/// orientation() the vector part of the orientations. Only the specializations exist, so a
+/// missing conversion does not compile.
+template <class From, class To>
+struct FrameChange;
+
+/// The robot convention flips the y and z axes of the positions. The orientations are the
+/// inverse of the reading turned a quarter about y; this is what rebuilding the matrix from
+/// the (-z, -y, x) euler angles of the reading (see sensorToConfig) amounts to.
+template <>
+struct FrameChange <PolhemusFrame, RobotFrame> {
+	static constexpr AxisMap position () { return halfTurnX(); }
+	static constexpr AxisMap orientation () { return quarterTurnY() * inversionMap(); }
+};
+
+static_assert(FrameChange <PolhemusFrame, RobotFrame>::orientation().axis[0] == 2 &&
+	FrameChange <PolhemusFrame, RobotFrame>::orientation().sign[0] == -1, "the robot orientation has the vector part (-qz, -qy, qx) of the reading");
+
+/* ********************************************************************************************* */
+/// Converts a pose to another frame
+template <class To, class From>
+inline Pose <To> frameCast (const Pose <From>& pose) {
+	typedef FrameChange <From, To> Change;
+	return Pose <To> (Change::position() * pose.position, Change::orientation() * pose.orientation);
+}
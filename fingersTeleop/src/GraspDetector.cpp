@@ -0,0 +1,78 @@
+/**
+ * @file GraspDetector.cpp
+ * @date Oct 18, 2026
+ * @brief Streaming classification of the hand state from the finger flexions.
+ */
+
+#include "GraspDetector.h"
+
+/* ********************************************************************************************* */
+const char* graspStateName (GraspState state) {
+	switch(state) {
+		case GRASP_OPEN: return "open";
+		case GRASP_CLOSING: return "closing";
+		case GRASP_CLOSED: return "closed";
+		case GRASP_PINCH: return "pinch";
+		default: return "unknown";
+	}
+}
+
+/* ********************************************************************************************* */
+GraspParams::GraspParams () : window(24), openEnter(0.35), closedEnter(1.0), closedExit(0.8),
+		closingVelocity(1.5) {
+	for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) pinchFingers[i] = (i < 2);
+}
+
+/* ********************************************************************************************* */
+GraspDetector::GraspDetector (const GraspParams& params) : params(params), current(GRASP_UNKNOWN),
+		previous(GRASP_UNKNOWN) {
+	for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) fingers[i] = SlidingWindow(params.window);
+}
+
+/* ********************************************************************************************* */
+void GraspDetector::configure (const GraspParams& next) {
+	size_t window = params.window;
+	params = next;
+	params.window = window;
+}
+
+/* ********************************************************************************************* */
+bool GraspDetector::update (double time, const double flexion [GRASP_NUM_FINGERS]) {
+
+	// Update the windows and wait until they are full
+	for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) fingers[i].push(time, flexion[i]);
+	if(!fingers[0].full()) return false;
+
+	// Summarize the fingers
+	bool allClosed = true, allOpen = true, stillClosed = true;
+	bool pinchClosed = true, stillPinched = true, othersOpen = true, othersNotClosed = true;
+	double velocity = 0.0;
+	for(size_t i = 0; i < GRASP_NUM_FINGERS; i++) {
+		const SlidingWindow& w = fingers[i];
+		bool closedNow = w.min() > params.closedEnter;
+		bool openNow = w.max() < params.openEnter;
+		bool held = w.mean() > params.closedExit;
+		allClosed &= closedNow, allOpen &= openNow, stillClosed &= held;
+		if(params.pinchFingers[i]) pinchClosed &= closedNow, stillPinched &= held;
+		else othersOpen &= openNow, othersNotClosed &= !closedNow;
+		velocity += w.velocity() / GRASP_NUM_FINGERS;
+	}
+
+	// Pick the next state; closed and pinch are held with the lower exit threshold and a hand
+	// leaving them without matching anything else is released (open)
+	GraspState next;
+	if(current == GRASP_CLOSED && stillClosed) next = GRASP_CLOSED;
+	else if(current == GRASP_PINCH && stillPinched && othersNotClosed) next = GRASP_PINCH;
+	else if(current == GRASP_CLOSED && stillPinched) next = GRASP_PINCH;
+	else if(allClosed) next = GRASP_CLOSED;
+	else if(pinchClosed && othersOpen) next = GRASP_PINCH;
+	else if(velocity > params.closingVelocity) next = GRASP_CLOSING;
+	else if(allOpen) next = GRASP_OPEN;
+	else if(current == GRASP_CLOSED || current == GRASP_PINCH) next = GRASP_OPEN;
+	else next = current;
+
+	if(next == current) return false;
+	previous = current;
+	current = next;
+	return true;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file GraspDetector.h
+ * @date Oct 18, 2026
+ * @brief Streaming classification of the hand state (open, closing, closed, pinch) from the
+ * finger flexions. Each finger keeps the statistics of a SlidingWindow, so that a detector never
+ * allocates after construction.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SlidingWindow.h"
+
+/// The maximum number of samples in the window of a finger
+#define GRASP_MAX_WINDOW SLIDING_MAX_WINDOW
+
+/// The number of finger sensors on a hand
+#define GRASP_NUM_FINGERS 3
+
+/* ********************************************************************************************* */
+/// The hand states, in the order they are reported on the event channel
+enum GraspState {
+	GRASP_UNKNOWN = 0,	///< Not enough samples yet
+	GRASP_OPEN,
+	GRASP_CLOSING,
+	GRASP_CLOSED,
+	GRASP_PINCH
+};
+
+/// Returns the name of a state for printing
+const char* graspStateName (GraspState state);
+
+/// The thresholds of the classifier on the finger flexions (radians, 0 is a straight finger).
+/// Entering a state looks at the whole window (min or max) and leaving it looks at the mean with
+/// a lower threshold which gives the hysteresis.
+struct GraspParams {
+	size_t window;							///< Number of samples in the sliding windows
+	double openEnter;						///< All samples below this: the finger is open
+	double closedEnter;					///< All samples above this: the finger is closed
+	double closedExit;					///< A closed finger stays closed until its mean drops below
+	double closingVelocity;				///< Mean flexion velocity (rad/s) that counts as closing
+	bool pinchFingers [GRASP_NUM_FINGERS];	///< The fingers that are closed in a pinch
+
+	GraspParams ();
+};
+
+/// The message put on the event channel when the state of a hand changes
+struct GraspEvent {
+	uint32_t hand;
+	uint32_t state, previous;
+	double time;								///< CLOCK_MONOTONIC seconds of the triggering sample
+	double flexion [GRASP_NUM_FINGERS];	///< Window means at the change
+};
+
+/* ********************************************************************************************* */
+/// The detector of one hand
+class GraspDetector {
+public:
+
+	GraspDetector (const GraspParams& params = GraspParams());
+
+	/// Adds the flexion of each finger at the given time; returns true if the state changed
+	bool update (double time, const double flexion [GRASP_NUM_FINGERS]);
+
+	/// Changes the thresholds; the window size stays the one of the constructor so that the
+	/// windows and the state are kept
+	void configure (const GraspParams& params);
+
+	GraspState state () const { return current; }
+	GraspState previousState () const { return previous; }
+	const SlidingWindow& finger (size_t i) const { return fingers[i]; }
+
+private:
+	GraspParams params;
+	SlidingWindow fingers [GRASP_NUM_FINGERS];
+	GraspState current, previous;
+};
@@ -0,0 +1,168 @@
+/**
+ * @file Liberty.cpp
+ * @date Oct 18, 2026
+ * @brief Conversions of the Polhemus Liberty sensor readings to the robot convention.
+ */
+
+#include "Liberty.h"
+#include "Deadline.h"
+#include <math.h>
+#include <string.h>
+
+using namespace Eigen;
+
+/* ********************************************************************************************* */
+Eigen::Vector3d matrixToEuler(Matrix3d& m) {
+
+	double x, y, z;
+	if(m(2, 0) > (1.0-M_EPSILON)) {
+		x = atan2(m(0, 1), m(0, 2));
+		y = -M_PI / 2.0;
+		z = 0.0;
+	}
+	if(m(2, 0) < -(1.0-M_EPSILON)) {
+		x = atan2(m(0, 1), m(0, 2));
+		y = M_PI / 2.0;
+		z = 0.0;
+	}
+	x = atan2(m(2, 1), m(2, 2));
+	y = -asin(m(2, 0));
+	z = atan2(m(1, 0), m(0, 0));
+	return Vector3d(x,y,z);
+}
+
+/* ********************************************************************************************* */
+void sensorToConfig(const double* data, Eigen::VectorXd& config) {
+
+	// Set the values for the position
+	config << data[0], -data[1], -data[2], 0.0, 0.0, 0.0;
+
+	// Convert from a quaternion to rpy representation
+	Eigen::Quaternion <double> oriQ (data[6], data[3], data[4], data[5]);
+	Eigen::Matrix3d oriM = oriQ.matrix();
+	Eigen::Vector3d oriE = matrixToEuler(oriM);
+	config.bottomLeftCorner<3,1>() << -oriE[2], -oriE[1], oriE[0];
+}
+
+/* ********************************************************************************************* */
+Eigen::Matrix3d configToMatrix(const Eigen::VectorXd& config) {
+	return (Eigen::AngleAxis <double> (config(5), Eigen::Vector3d(0.0, 0.0, 1.0)) *
+		Eigen::AngleAxis <double> (config(4), Eigen::Vector3d(0.0, 1.0, 0.0)) *
+		Eigen::AngleAxis <double> (config(3), Eigen::Vector3d(1.0, 0.0, 0.0))).matrix();
+}
+
+/* ********************************************************************************************* */
+double palmAngle(const Eigen::Matrix3d& palm) {
+	Eigen::Vector3d localZ (palm(0,2), palm(1,2), palm(2,2));
+	return acos(localZ.dot(Eigen::Vector3d(0.0, 0.0, 1.0)));
+}
+
+/* ********************************************************************************************* */
+double fingerAngle(const Eigen::Matrix3d& palm, const Eigen::Matrix3d& finger) {
+	Eigen::Vector3d fingerZ (finger(0,2), finger(1,2), finger(2,2));
+	return acos(fingerZ.dot(Eigen::Vector3d(-palm(0,2), -palm(1,2), -palm(2,2))));
+}
+
+/* ********************************************************************************************* */
+bool decodeLiberty(const uint8_t* buffer, size_t size, ProtobufCAllocator* allocator, Eigen::VectorXd& config,
+		Eigen::VectorXd& config2, Eigen::VectorXd& config3, Eigen::VectorXd& config4) {
+
+	Somatic__Liberty* l_msg = somatic__liberty__unpack(allocator, size, buffer);
+	if(l_msg == NULL) return false;
+	Somatic__Vector* sensors [] = {l_msg->sensor1, l_msg->sensor2, l_msg->sensor3, l_msg->sensor4};
+	Eigen::VectorXd* configs [] = {&config, &config2, &config3, &config4};
+	bool valid = true;
+	for(size_t i = 0; i < 4; i++) {
+		if(sensors[i] == NULL || sensors[i]->n_data < 7) { valid = false; break; }
+		sensorToConfig(sensors[i]->data, *configs[i]);
+	}
+	somatic__liberty__free_unpacked(l_msg, allocator);
+	return valid;
+}
+
+/* ********************************************************************************************* */
+bool unpackReadings(const uint8_t* buffer, size_t size, ProtobufCAllocator* allocator, double& time,
+		double readings [4][7], double* until) {
+
+	Somatic__Liberty* l_msg = somatic__liberty__unpack(allocator, size, buffer);
+	if(l_msg == NULL) return false;
+	if(until != NULL) *until = metadataUntil(l_msg->meta);
+	time = (l_msg->meta != NULL && l_msg->meta->time != NULL) ?
+		l_msg->meta->time->sec + l_msg->meta->time->nsec * 1e-9 : NAN;
+	Somatic__Vector* sensors [] = {l_msg->sensor1, l_msg->sensor2, l_msg->sensor3, l_msg->sensor4};
+	for(size_t s = 0; s < 4; s++) {
+		bool present = (sensors[s] != NULL && sensors[s]->n_data >= 7);
+		for(size_t i = 0; i < 7; i++) readings[s][i] = present ? sensors[s]->data[i] : NAN;
+	}
+	somatic__liberty__free_unpacked(l_msg, allocator);
+	return true;
+}
+
+/* ********************************************************************************************* */
+Pose <RobotFrame> sensorToPose(const double* data) {
+	Pose <PolhemusFrame> reading (Vector3d(data[0], data[1], data[2]),
+		Quaterniond(data[6], data[3], data[4], data[5]));
+	return frameCast <RobotFrame> (reading);
+}
+
+/* ********************************************************************************************* */
+double palmAngle(const Pose <RobotFrame>& palm) {
+	return acos((palm.orientation * Vector3d::UnitZ()).dot(Vector3d::UnitZ()));
+}
+
+/* ********************************************************************************************* */
+double fingerAngle(const Pose <RobotFrame>& palm, const Pose <RobotFrame>& finger) {
+	return acos(-(finger.orientation * Vector3d::UnitZ()).dot(palm.orientation * Vector3d::UnitZ()));
+}
+
+/* ********************************************************************************************* */
+bool decodeLiberty(const uint8_t* buffer, size_t size, ProtobufCAllocator* allocator, Pose <RobotFrame> poses [4],
+		double* until) {
+
+	Somatic__Liberty* l_msg = somatic__liberty__unpack(allocator, size, buffer);
+	if(l_msg == NULL) return false;
+	if(until != NULL) *until = metadataUntil(l_msg->meta);
+	Somatic__Vector* sensors [] = {l_msg->sensor1, l_msg->sensor2, l_msg->sensor3, l_msg->sensor4};
+	bool valid = true;
+	for(size_t i = 0; i < 4; i++) {
+		if(sensors[i] == NULL || sensors[i]->n_data < 7) { valid = false; break; }
+		poses[i] = sensorToPose(sensors[i]->data);
+	}
+	somatic__liberty__free_unpacked(l_msg, allocator);
+	return valid;
+}
+
+/* ********************************************************************************************* */
+LibertyPacker::LibertyPacker () {
+
+	// Point the message to the member storage
+	Somatic__Vector vectorInit = SOMATIC__VECTOR__INIT;
+	Somatic__Timespec timeInit = SOMATIC__TIMESPEC__INIT;
+	Somatic__Metadata metaInit = SOMATIC__METADATA__INIT;
+	Somatic__Liberty messageInit = SOMATIC__LIBERTY__INIT;
+	stamp = deadline = timeInit;
+	stamp.has_nsec = deadline.has_nsec = 1;
+	meta = metaInit;
+	meta.time = &stamp, meta.until = &deadline;
+	meta.type = SOMATIC__MSG_TYPE__LIBERTY, meta.has_type = 1;
+	message = messageInit;
+	message.meta = &meta;
+	Somatic__Vector** sensors [] = {&message.sensor1, &message.sensor2, &message.sensor3, &message.sensor4};
+	for(size_t s = 0; s < 4; s++) {
+		vectors[s] = vectorInit;
+		vectors[s].n_data = 7;
+		vectors[s].data = values[s];
+		*sensors[s] = &vectors[s];
+	}
+}
+
+/* ********************************************************************************************* */
+size_t LibertyPacker::pack (double time, double until, const double readings [4][7], uint8_t* buffer,
+		size_t capacity) {
+	memcpy(values, readings, sizeof(values));
+	stamp.sec = (int64_t) floor(time), stamp.nsec = (int32_t) ((time - floor(time)) * 1e9);
+	deadline.sec = (int64_t) floor(until), deadline.nsec = (int32_t) ((until - floor(until)) * 1e9);
+	size_t size = somatic__liberty__get_packed_size(&message);
+	if(size > capacity) return 0;
+	return somatic__liberty__pack(&message, buffer);
+}
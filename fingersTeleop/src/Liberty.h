@@ -0,0 +1,75 @@
+/**
+ * @file Liberty.h
+ * @date Oct 18, 2026
+ * @brief Conversions of the Polhemus Liberty sensor readings to the robot convention and the
+ * finger angles computed from them. A sensor reading is (x, y, z, qx, qy, qz, qw).
+ */
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <somatic.pb-c.h>
+#include "Frames.h"
+
+#define M_EPSILON 1e-10
+
+/// Converts a rotation matrix to (x, y, z) euler angles
+Eigen::Vector3d matrixToEuler(Eigen::Matrix3d& m);
+
+/// Fills the 6-vector config with the position and the rpy angles of a sensor reading with the
+/// y and z axes flipped to the robot convention
+void sensorToConfig(const double* data, Eigen::VectorXd& config);
+
+/// Rebuilds the rotation matrix from the rpy angles of a config
+Eigen::Matrix3d configToMatrix(const Eigen::VectorXd& config);
+
+/// Returns the angle between the z-axis of the palm (sensor 1) and the polhemus cube
+double palmAngle(const Eigen::Matrix3d& palm);
+
+/// Returns the angle between the z-axis of a finger sensor and the reversed z-axis of the palm;
+/// a finger that is straight with the palm reads pi.
+double fingerAngle(const Eigen::Matrix3d& palm, const Eigen::Matrix3d& finger);
+
+/// Unpacks a packed liberty message and converts the 4 sensors with sensorToConfig; false if the
+/// message is malformed or has fewer sensors or values
+bool decodeLiberty(const uint8_t* buffer, size_t size, ProtobufCAllocator* allocator, Eigen::VectorXd& config,
+	Eigen::VectorXd& config2, Eigen::VectorXd& config3, Eigen::VectorXd& config4);
+
+/// Unpacks a packed liberty message into the raw readings of the 4 sensors and the metadata time
+/// (NAN if it has none); the readings of missing or short sensors are NAN. False if the message
+/// can not be unpacked. If until is given it is set to the validity deadline (see metadataUntil).
+bool unpackReadings(const uint8_t* buffer, size_t size, ProtobufCAllocator* allocator, double& time,
+	double readings [4][7], double* until = NULL);
+
+/// Returns the pose of a sensor reading in the robot convention; the same as sensorToConfig but
+/// without the round trip through the euler angles
+Pose <RobotFrame> sensorToPose(const double* data);
+
+/// Pose versions of palmAngle and fingerAngle
+double palmAngle(const Pose <RobotFrame>& palm);
+double fingerAngle(const Pose <RobotFrame>& palm, const Pose <RobotFrame>& finger);
+
+/// Unpacks a packed liberty message into the poses of the 4 sensors; false as decodeLiberty above.
+/// If until is given it is set to the validity deadline of the message (see metadataUntil).
+bool decodeLiberty(const uint8_t* buffer, size_t size, ProtobufCAllocator* allocator, Pose <RobotFrame> poses [4],
+	double* until = NULL);
+
+/* ********************************************************************************************* */
+/// Packs liberty messages from raw readings without allocating: the message points to member
+/// storage that is refilled for every frame
+class LibertyPacker {
+public:
+
+	LibertyPacker ();
+
+	/// Packs the readings with the metadata time and validity deadline (aa_tm_now seconds) into the
+	/// buffer; returns the packed size or 0 if it did not fit
+	size_t pack (double time, double until, const double readings [4][7], uint8_t* buffer, size_t capacity);
+
+private:
+	double values [4][7];
+	Somatic__Vector vectors [4];
+	Somatic__Timespec stamp, deadline;
+	Somatic__Metadata meta;
+	Somatic__Liberty message;
+};
@@ -0,0 +1,118 @@
+/**
+ * @file LibertyGraph.cpp
+ * @date Oct 18, 2026
+ * @brief The work of a liberty frame as a lazy graph.
+ */
+
+#include "LibertyGraph.h"
+#include <math.h>
+#include <string.h>
+
+using namespace Eigen;
+
+/* ********************************************************************************************* */
+LibertyGraph::LibertyGraph (const FingersCoreParams& params, double filterTime) : guard(params.deadline),
+		checks(params.health), checkHealth(params.checkHealth), filterTime(filterTime), frameTime(NAN) {
+
+	memcpy(offsets, params.offsets, sizeof(offsets));
+	for(size_t i = 0; i < 4; i++) angles[i] = filteredAngles[i] = filteredAt[i] = NAN;
+
+	// Added in the order of LibertyNode, so the handles are its values; the frame was decoded and
+	// accepted before the graph moved on to it, so there is nothing before the first one
+	lazy.add("decode", [this]() { return !isnan(frameTime); });
+	lazy.add("correct", [this]() {
+		for(size_t s = 0; s < 4; s++) for(size_t k = 0; k < 3; k++) readings[s][k] += offsets[s][k];
+		if(checkHealth) checks.check(frameTime, readings, health);
+		else {
+			health.magic = HEALTH_REPORT_MAGIC, health.version = HEALTH_REPORT_VERSION;
+			health.time = frameTime;
+			for(size_t s = 0; s < 4; s++) health.score[s] = 1.0, health.verdict[s] = HEALTH_OK, health.reasons[s] = 0;
+		}
+		return true;
+	}, {LIBERTY_DECODE});
+	for(size_t i = 0; i < 4; i++) lazy.add("pose", [this, i]() {
+		for(size_t k = 0; k < 7; k++) if(isnan(readings[i][k])) return false;
+		poses[i] = sensorToPose(readings[i]);
+		return true;
+	}, {LIBERTY_CORRECT});
+	for(size_t i = 0; i < 4; i++) lazy.add("matrix", [this, i]() {
+		matrices[i] = poses[i].orientation.toRotationMatrix();
+		return true;
+	}, {LIBERTY_POSE + i});
+	lazy.add("angle", [this]() { angles[0] = palmAngle(poses[0]); return true; }, {LIBERTY_POSE});
+	for(size_t i = 1; i < 4; i++) lazy.add("angle", [this, i]() {
+		angles[i] = fingerAngle(poses[0], poses[i]);
+		return true;
+	}, {LIBERTY_POSE, LIBERTY_POSE + i});
+	for(size_t i = 0; i < 4; i++) lazy.add("filter", [this, i]() { return filter(i); }, {LIBERTY_ANGLE + i}, true);
+}
+
+/* ********************************************************************************************* */
+bool LibertyGraph::frame (const uint8_t* message, size_t size, ProtobufCAllocator* allocator, double now) {
+	double time, until = NAN, decoded [4][7];
+	if(!unpackReadings(message, size, allocator, time, decoded, &until)) return false;
+	return accept(time, until, decoded, now);
+}
+
+/* ********************************************************************************************* */
+bool LibertyGraph::frame (double time, double until, const double readings [4][7], double now) {
+	return accept(time, until, readings, now);
+}
+
+/* ********************************************************************************************* */
+bool LibertyGraph::accept (double time, double until, const double input [4][7], double now) {
+	if(!guard.accept(until, now)) return false;
+
+	// Unstamped frames count from their arrival; only now are the values of the last frame replaced
+	memcpy(readings, input, sizeof(readings));
+	frameTime = isnan(time) ? now : time;
+	lazy.next();
+	return lazy.get(LIBERTY_CORRECT);
+}
+
+/* ********************************************************************************************* */
+bool LibertyGraph::filter (size_t i) {
+	if(isnan(filteredAngles[i]) || !(frameTime > filteredAt[i])) filteredAngles[i] = angles[i];
+	else filteredAngles[i] += (1.0 - exp(-(frameTime - filteredAt[i]) / filterTime)) * (angles[i] - filteredAngles[i]);
+	filteredAt[i] = frameTime;
+	return true;
+}
+
+/* ********************************************************************************************* */
+void LibertyGraph::save (LibertyGraphState& state) const {
+	checks.save(state.checks);
+	memcpy(state.offsets, offsets, sizeof(offsets));
+	state.deadline = guard.deadline();
+	state.time = frameTime;
+	memcpy(state.readings, readings, sizeof(readings));
+	state.health = health;
+	memcpy(state.filtered, filteredAngles, sizeof(filteredAngles));
+	memcpy(state.filteredAt, filteredAt, sizeof(filteredAt));
+}
+
+/* ********************************************************************************************* */
+bool LibertyGraph::restore (const LibertyGraphState& state, double now) {
+	checks.restore(state.checks);
+	memcpy(offsets, state.offsets, sizeof(offsets));
+	guard.resume(state.deadline);
+	memcpy(filteredAngles, state.filtered, sizeof(filteredAngles));
+	memcpy(filteredAt, state.filteredAt, sizeof(filteredAt));
+	if(isnan(state.time) || guard.stale(now)) return false;
+
+	// The last frame is the current one; the filters that were updated by it are not again
+	frameTime = state.time;
+	memcpy(readings, state.readings, sizeof(readings));
+	health = state.health;
+	std::vector <size_t> provided = {LIBERTY_DECODE, LIBERTY_CORRECT};
+	for(size_t i = 0; i < 4; i++) if(filteredAt[i] == frameTime) provided.push_back(LIBERTY_FILTERED + i);
+	lazy.provide(provided);
+	return true;
+}
+
+/* ********************************************************************************************* */
+void LibertyGraph::configure (const FingersCoreParams& params) {
+	guard.configure(params.deadline);
+	checks.configure(params.health);
+	checkHealth = params.checkHealth;
+	memcpy(offsets, params.offsets, sizeof(offsets));
+}
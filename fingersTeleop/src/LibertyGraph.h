@@ -0,0 +1,119 @@
+/**
+ * @file LibertyGraph.h
+ * @date Oct 18, 2026
+ * @brief The work of a liberty frame as a lazy graph (see lazyGraph.h), so that a consumer pays
+ * only for the outputs it subscribes to: the decode and the corrections (calibration offsets,
+ * deadline and health checks) run for every frame since they keep state and the message is not
+ * kept, and then the poses, rotation matrices, angles and filtered angles of each sensor are
+ * computed when a subscriber needs them, once per frame. The node handles are LibertyNode values,
+ * e.g. LIBERTY_ANGLE + 2 for the angle of the second finger; more derived nodes can be added to
+ * graph() with these as inputs. What the graph carries from frame to frame can be saved after a
+ * frame and restored in a new instance (see checkpoint.h), which then resumes from the last frame
+ * if it is still within its deadline. A frame that can not be decoded or arrives past its deadline
+ * is dropped before the graph moves on, so the values of the last accepted frame stay current.
+ *
+ *   LibertyGraph liberty;
+ *   liberty.graph().subscribe(LIBERTY_ANGLE + 1, [&]() { printf("%f\n", liberty.angle(1)); });
+ *   ...for every frame:
+ *   if(liberty.frame(message, size, allocator, now)) liberty.run();
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Eigen/Dense>
+#include <somatic.pb-c.h>
+#include "lazyGraph.h"
+#include "Frames.h"
+#include "Liberty.h"
+#include "Deadline.h"
+#include "SensorHealth.h"
+#include "FingersCore.h"
+
+/// The nodes of a LibertyGraph; the per sensor ones take 4 handles from the given one
+enum LibertyNode {
+	LIBERTY_DECODE = 0,								///< The readings and the stamps of the accepted frame
+	LIBERTY_CORRECT,									///< Offsets added and the health checked
+	LIBERTY_POSE,										///< Of each sensor; fails if its reading has a NaN
+	LIBERTY_MATRIX = LIBERTY_POSE + 4,			///< Rotation matrix of each pose
+	LIBERTY_ANGLE = LIBERTY_MATRIX + 4,			///< The palm angle and then the finger angles (rad)
+	LIBERTY_FILTERED = LIBERTY_ANGLE + 4,		///< The angles low-pass filtered over every frame
+	LIBERTY_NUM_NODES = LIBERTY_FILTERED + 4
+};
+
+/// The state of a LibertyGraph as plain values, for a checkpoint: the health statistics, the
+/// calibration, the deadline and the last corrected frame with its report and the filters
+struct LibertyGraphState {
+	SensorHealthState checks [4];
+	double offsets [4][3];
+	double deadline;
+	double time, readings [4][7];				///< time is NAN before the first frame
+	HealthReport health;
+	double filtered [4], filteredAt [4];
+};
+
+/* ********************************************************************************************* */
+class LibertyGraph {
+public:
+
+	/// The filtered angles follow the angles with the given time constant (s)
+	LibertyGraph (const FingersCoreParams& params = FingersCoreParams(), double filterTime = 0.05);
+
+	/// Starts a frame with a packed liberty message received at the monotonic time 'now'; returns
+	/// false, leaving the last frame current, if it could not be decoded or arrived past its deadline
+	bool frame (const uint8_t* message, size_t size, ProtobufCAllocator* allocator, double now);
+
+	/// The same for readings (x, y, z, qx, qy, qz, qw per sensor) that are already in memory
+	bool frame (double time, double until, const double readings [4][7], double now);
+
+	/// Calls the subscribers of the frame's outputs (see LazyGraph::run)
+	size_t run () { return lazy.run(); }
+
+	/// Takes the offsets and the health and deadline parameters; the state of the checks is kept
+	void configure (const FingersCoreParams& params);
+
+	/// Copies the state after the last frame; only meaningful after a frame that was accepted
+	void save (LibertyGraphState& state) const;
+
+	/// Takes a saved state and, if its frame is still valid at the monotonic time 'now', starts a
+	/// frame from it as if it had just been received: the outputs are computed from the restored
+	/// readings by run() and the filters keep their values. Returns true if so.
+	bool restore (const LibertyGraphState& state, double now);
+
+	LazyGraph& graph () { return lazy; }
+	DeadlineGuard& deadline () { return guard; }
+
+	/// The values of the last frame; only those of the nodes computed in it are current
+	double time () const { return frameTime; }						///< Metadata time, or 'now' without one
+	const double (*corrected () const) [7] { return readings; }		///< The readings after LIBERTY_CORRECT
+	const HealthReport& report () const { return health; }
+	const Pose <RobotFrame>& pose (size_t i) const { return poses[i]; }
+	const Eigen::Matrix3d& matrix (size_t i) const { return matrices[i]; }
+	double angle (size_t i) const { return angles[i]; }
+	double filtered (size_t i) const { return filteredAngles[i]; }
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+
+	/// Checks the deadline of decoded readings and, if they are accepted, starts a frame with them
+	bool accept (double time, double until, const double input [4][7], double now);
+
+	/// Updates the low-pass filter of an angle over the time since its last update
+	bool filter (size_t i);
+
+	LazyGraph lazy;
+	DeadlineGuard guard;
+	LibertyHealth checks;
+	double offsets [4][3];
+	bool checkHealth;
+	double filterTime;
+
+	// The values of the nodes
+	double frameTime, readings [4][7];
+	HealthReport health;
+	Pose <RobotFrame> poses [4];
+	Eigen::Matrix3d matrices [4];
+	double angles [4], filteredAngles [4], filteredAt [4];
+};
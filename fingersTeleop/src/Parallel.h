@@ -0,0 +1,35 @@
+/**
+ * @file Parallel.h
+ * @date Oct 18, 2026
+ * @brief A minimal parallel-for over chunks of an index range for the offline tools.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+/* ********************************************************************************************* */
+/// Calls body(begin, end) on consecutive chunks of [0, count) from all the cores. The chunks are
+/// handed out dynamically so that uneven chunks do not leave threads idle.
+template <typename Body>
+void parallelFor (size_t count, size_t chunk, const Body& body, size_t numThreads = 0) {
+
+	if(numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+	if(chunk == 0) chunk = 1;
+	numThreads = std::min(numThreads, (count + chunk - 1) / chunk);
+	if(numThreads <= 1) { if(count > 0) body((size_t) 0, count); return; }
+
+	std::atomic <size_t> next (0);
+	std::vector <std::thread> threads;
+	for(size_t t = 0; t < numThreads; t++) {
+		threads.push_back(std::thread([&]() {
+			for(size_t begin; (begin = next.fetch_add(chunk)) < count; )
+				body(begin, std::min(begin + chunk, count));
+		}));
+	}
+	for(size_t t = 0; t < numThreads; t++) threads[t].join();
+}
@@ -0,0 +1,65 @@
+/**
+ * @file Playout.cpp
+ * @date Oct 18, 2026
+ * @brief The adaptive playout buffer.
+ */
+
+#include "Playout.h"
+#include <algorithm>
+#include <math.h>
+
+/* ********************************************************************************************* */
+PlayoutParams::PlayoutParams () : minDelay(0.002), maxDelay(0.1), margin(0.001), slew(0.02), window(240) {}
+
+/* ********************************************************************************************* */
+PlayoutBuffer::PlayoutBuffer (size_t numValues, const std::vector <size_t>& quaternions,
+		const PlayoutParams& params) : params(params), history(numValues, quaternions),
+		ages(std::min(params.window, (size_t) SLIDING_MAX_WINDOW)), newestTime(-INFINITY), lastPlayed(-INFINITY),
+		lastTick(NAN), currentDelay(params.minDelay), numUnderruns(0), numLate(0), numReordered(0), numTicks(0) {}
+
+/* ********************************************************************************************* */
+double PlayoutBuffer::target () const {
+	return std::min(std::max(ages.max() + params.margin, params.minDelay), params.maxDelay);
+}
+
+/* ********************************************************************************************* */
+void PlayoutBuffer::push (double time, const double* values, double now) {
+	if(!(time > newestTime)) {
+		numReordered++;
+		return;
+	}
+	if(time < lastPlayed) numLate++;
+	if(!isinf(newestTime)) ages.push(now, now - newestTime);
+	history.push(time, values);
+	newestTime = time;
+}
+
+/* ********************************************************************************************* */
+PlayoutResult PlayoutBuffer::sample (double now, double* values, double* played) {
+
+	if(isinf(newestTime)) return PLAYOUT_EMPTY;
+	numTicks++;
+
+	// Move the delay towards the target by at most the slew of the time since the last tick
+	double goal = target();
+	if(!isnan(lastTick)) {
+		double step = params.slew * (now - lastTick);
+		currentDelay += std::max(-step, std::min(step, goal - currentDelay));
+	}
+	else currentDelay = goal;
+	lastTick = now;
+
+	// Play at the delayed time, never going back; past the newest sample hold it and catch up
+	double time = std::max(now - currentDelay, lastPlayed);
+	PlayoutResult result = PLAYOUT_OK;
+	if(time > newestTime) {
+		time = newestTime;
+		currentDelay = std::min(now - newestTime, params.maxDelay);
+		numUnderruns++;
+		result = PLAYOUT_UNDERRUN;
+	}
+	history.at(time, values);
+	lastPlayed = time;
+	if(played != NULL) *played = time;
+	return result;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file Playout.h
+ * @date Oct 18, 2026
+ * @brief A playout (jitter) buffer between the liberty frames, which arrive with a variable
+ * scheduling delay, and a control loop that runs on a strict clock. Timestamped samples go into a
+ * ChannelHistory and every control tick takes the sample interpolated (slerp for quaternions) at
+ * the tick time minus a delay, so that the commands are as smooth as the tracker motion and not as
+ * irregular as the arrivals.
+ *
+ * The delay adapts: just before a frame arrives the newest sample is as old as it ever gets, so
+ * every arrival measures that age (its time minus the stamp of the previous frame) and the target
+ * delay is the largest age of the last 'window' frames plus a margin. The delay moves towards the
+ * target by stretching or squeezing the playout clock by at most 'slew', so the played time never
+ * jumps or goes back; it shrinks by itself once the ages of a whole window are smaller. A tick
+ * that finds no newer sample (an underrun) holds the newest one and raises the delay to where it
+ * is at once.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "TimeAlign.h"
+#include "SlidingWindow.h"
+
+/// What a tick got
+enum PlayoutResult {
+	PLAYOUT_EMPTY = 0,		///< Nothing received yet
+	PLAYOUT_OK,					///< Interpolated at the playout time
+	PLAYOUT_UNDERRUN			///< No sample that new yet; the newest is held
+};
+
+/// The parameters of a buffer
+struct PlayoutParams {
+	double minDelay, maxDelay;		///< Bounds of the delay (s)
+	double margin;						///< Added to the largest age in the window (s)
+	double slew;						///< The most the playout clock runs slower or faster than real time
+	size_t window;						///< Frames whose ages set the target (at most SLIDING_MAX_WINDOW)
+
+	PlayoutParams ();
+};
+
+/* ********************************************************************************************* */
+class PlayoutBuffer {
+public:
+
+	/// Samples of 'numValues' values with quaternions at the given indices (see ChannelHistory)
+	PlayoutBuffer (size_t numValues, const std::vector <size_t>& quaternions = std::vector <size_t> (),
+		const PlayoutParams& params = PlayoutParams());
+
+	/// Adds a sample stamped 'time' that arrived at 'now' (the same monotonic clock); samples older
+	/// than the newest one are dropped and counted as reordered, and those older than what was
+	/// already played are counted as late
+	void push (double time, const double* values, double now);
+
+	/// Fills 'values' for the control tick at 'now'; 'played' is set to the playout time
+	PlayoutResult sample (double now, double* values, double* played = NULL);
+
+	double delay () const { return currentDelay; }						///< Current delay (s)
+	double target () const;														///< Where the delay is heading (s)
+	uint64_t underruns () const { return numUnderruns; }
+	uint64_t late () const { return numLate; }
+	uint64_t reordered () const { return numReordered; }
+	uint64_t ticks () const { return numTicks; }
+
+private:
+	PlayoutParams params;
+	ChannelHistory history;
+	SlidingWindow ages;					///< Of the newest sample at each arrival
+	double newestTime;					///< Stamp of the newest sample
+	double lastPlayed, lastTick;
+	double currentDelay;
+	uint64_t numUnderruns, numLate, numReordered, numTicks;
+};
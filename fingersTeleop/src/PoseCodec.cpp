@@ -0,0 +1,166 @@
+/**
+ * @file PoseCodec.cpp
+ * @date Oct 18, 2026
+ * @brief Quantized delta encoding of liberty frames.
+ */
+
+#include "PoseCodec.h"
+#include <math.h>
+
+/* ********************************************************************************************* */
+/// Appends a signed value as a zigzag varint: small magnitudes of either sign take one byte
+static inline void putSigned (uint8_t*& p, int64_t value) {
+	uint64_t v = ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+	while(v >= 0x80) {
+		*p++ = (uint8_t) (v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (uint8_t) v;
+}
+
+/* ********************************************************************************************* */
+/// Reads a zigzag varint; false if the buffer ends first
+static inline bool getSigned (const uint8_t*& p, const uint8_t* end, int64_t& value) {
+	uint64_t v = 0;
+	for(unsigned int shift = 0; p < end && shift < 64; shift += 7) {
+		uint8_t b = *p++;
+		v |= (uint64_t) (b & 0x7f) << shift;
+		if(b & 0x80) continue;
+		value = (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+		return true;
+	}
+	return false;
+}
+
+/* ********************************************************************************************* */
+/// Rounds to the nearest integer; inline unlike llround
+static inline int64_t roundToInt (double x) {
+	return (int64_t) ((x < 0.0) ? x - 0.5 : x + 0.5);
+}
+
+/* ********************************************************************************************* */
+/// Quantizes the time, the positions and the smallest three components of the normalized
+/// quaternions, flipped so that the largest one is positive (q and -q are the same rotation)
+static void quantize (const PoseCodecParams& params, double time, const double readings [4][7],
+		PoseCodecState& state) {
+
+	const double positionScale = 1.0 / params.positionStep;
+	state.time = roundToInt(time * 1e6);
+	for(size_t s = 0; s < 4; s++) {
+		for(size_t i = 0; i < 3; i++) state.position[s][i] = roundToInt(readings[s][i] * positionScale);
+
+		const double* q = readings[s] + 3;
+		double norm = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		uint8_t largest = 3;
+		for(uint8_t c = 0; c < 4; c++) if(fabs(q[c]) > fabs(q[largest])) largest = c;
+		if(norm == 0.0) {
+			state.largest[s] = 3;
+			state.rotation[s][0] = state.rotation[s][1] = state.rotation[s][2] = 0;
+			continue;
+		}
+		double scale = ((q[largest] < 0.0) ? -1.0 : 1.0) / (norm * params.rotationStep);
+		state.largest[s] = largest;
+		for(uint8_t c = 0, k = 0; c < 4; c++) if(c != largest) state.rotation[s][k++] = roundToInt(q[c] * scale);
+	}
+}
+
+/* ********************************************************************************************* */
+/// Rebuilds the frame from the quantized state
+static void dequantize (const PoseCodecParams& params, const PoseCodecState& state, double& time,
+		double readings [4][7]) {
+
+	time = state.time * 1e-6;
+	for(size_t s = 0; s < 4; s++) {
+		for(size_t i = 0; i < 3; i++) readings[s][i] = state.position[s][i] * params.positionStep;
+		double* q = readings[s] + 3;
+		double sum = 0.0;
+		for(uint8_t c = 0, k = 0; c < 4; c++) {
+			if(c == state.largest[s]) continue;
+			q[c] = state.rotation[s][k++] * params.rotationStep;
+			sum += q[c] * q[c];
+		}
+		q[state.largest[s]] = sqrt(fmax(0.0, 1.0 - sum));
+	}
+}
+
+/* ********************************************************************************************* */
+PoseCodecParams::PoseCodecParams () : positionStep(1e-5), rotationStep(1e-5), keyframeInterval(240) {}
+
+/* ********************************************************************************************* */
+PoseEncoder::PoseEncoder (const PoseCodecParams& params) : params(params), count(0), sequence(0) {}
+
+/* ********************************************************************************************* */
+size_t PoseEncoder::encode (double time, const double readings [4][7], uint8_t* buffer) {
+
+	bool key = (count == 0);
+	if(++count >= params.keyframeInterval) count = 0;
+	PoseCodecState current;
+	quantize(params, time, readings, current);
+
+	// The header and the time
+	uint8_t* p = buffer;
+	*p++ = key ? 1 : 0;
+	*p++ = sequence++;
+	putSigned(p, key ? current.time : current.time - previous.time);
+
+	// The sensors; the quaternion values are absolute if the largest component changed
+	for(size_t s = 0; s < 4; s++) {
+		bool whole = key || (current.largest[s] != previous.largest[s]);
+		*p++ = current.largest[s] | (whole ? 4 : 0);
+		for(size_t i = 0; i < 3; i++)
+			putSigned(p, key ? current.position[s][i] : current.position[s][i] - previous.position[s][i]);
+		for(size_t i = 0; i < 3; i++)
+			putSigned(p, whole ? current.rotation[s][i] : current.rotation[s][i] - previous.rotation[s][i]);
+	}
+	previous = current;
+	return p - buffer;
+}
+
+/* ********************************************************************************************* */
+PoseDecoder::PoseDecoder (const PoseCodecParams& params) : params(params), synced(false), sequence(0),
+	numSkipped(0) {}
+
+/* ********************************************************************************************* */
+bool PoseDecoder::decode (const uint8_t* buffer, size_t size, double& time, double readings [4][7]) {
+
+	// A delta frame can only be applied to the frame before it
+	if(size < 2) return false;
+	const uint8_t *p = buffer + 2, *end = buffer + size;
+	bool key = buffer[0] & 1;
+	uint8_t seq = buffer[1];
+	if(!key && (!synced || seq != (uint8_t) (sequence + 1))) {
+		synced = false;
+		numSkipped++;
+		return false;
+	}
+
+	// Read the values into a copy: a malformed frame leaves the state as it was until a keyframe
+	PoseCodecState current;
+	int64_t v;
+	bool valid = getSigned(p, end, v);
+	current.time = key ? v : previous.time + v;
+	for(size_t s = 0; valid && s < 4; s++) {
+		if(p >= end) { valid = false; break; }
+		uint8_t flags = *p++;
+		bool whole = key || (flags & 4);
+		current.largest[s] = flags & 3;
+		for(size_t i = 0; valid && i < 3; i++) {
+			valid = getSigned(p, end, v);
+			current.position[s][i] = key ? v : previous.position[s][i] + v;
+		}
+		for(size_t i = 0; valid && i < 3; i++) {
+			valid = getSigned(p, end, v);
+			current.rotation[s][i] = whole ? v : previous.rotation[s][i] + v;
+		}
+	}
+	if(!valid) {
+		synced = false;
+		return false;
+	}
+
+	previous = current;
+	sequence = seq;
+	synced = true;
+	dequantize(params, current, time, readings);
+	return true;
+}
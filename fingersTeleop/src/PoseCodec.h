@@ -0,0 +1,82 @@
+/**
+ * @file PoseCodec.h
+ * @date Oct 18, 2026
+ * @brief A compact encoding of liberty frames (time and 4 sensors of x, y, z, qx, qy, qz, qw) for
+ * recordings and links between machines. The positions and the quaternions are quantized to
+ * about the sensor's precision, the quaternions with the smallest-three encoding, and each frame
+ * stores the zigzag varint differences to the previous one. Every keyframeInterval frames (and
+ * after a reset) the values are stored whole so that a decoder can join or recover from a lost
+ * frame. A frame is:
+ *
+ *   flags (1 byte, bit 0 keyframe) | sequence (1 byte) | time in us (varint, delta unless keyframe)
+ *   4 x [largest quaternion component (1 byte, bit 2 set if the quaternion values are absolute) |
+ *        3 position values (varints, deltas unless keyframe) | 3 quaternion values (varints,
+ *        deltas unless keyframe or the largest component changed)]
+ *
+ * The decoded quaternions are normalized and may have the opposite sign of the readings.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// The largest encoded frame in bytes
+#define POSE_CODEC_MAX_FRAME (2 + 10 + 4 * (1 + 6 * 10))
+
+/// The quantization and the keyframe interval
+struct PoseCodecParams {
+	double positionStep;				///< Position resolution (m), 10 um by default
+	double rotationStep;				///< Resolution of the quaternion components, ~2e-5 rad by default
+	size_t keyframeInterval;		///< Frames between keyframes, i.e. 1s at 240 Hz by default
+
+	PoseCodecParams ();
+};
+
+/// The quantized state that the encoder and the decoder keep in step
+struct PoseCodecState {
+	int64_t time;							///< us
+	int64_t position [4][3];
+	int64_t rotation [4][3];			///< The three smallest quaternion components
+	uint8_t largest [4];					///< The index of the largest quaternion component (x, y, z, w)
+};
+
+/* ********************************************************************************************* */
+class PoseEncoder {
+public:
+
+	PoseEncoder (const PoseCodecParams& params = PoseCodecParams());
+
+	/// Encodes a frame into the buffer (of at least POSE_CODEC_MAX_FRAME bytes); returns the size
+	size_t encode (double time, const double readings [4][7], uint8_t* buffer);
+
+	/// Makes the next frame a keyframe
+	void reset () { count = 0; }
+
+private:
+	PoseCodecParams params;
+	PoseCodecState previous;
+	size_t count;						///< Frames since the last keyframe
+	uint8_t sequence;
+};
+
+/* ********************************************************************************************* */
+class PoseDecoder {
+public:
+
+	PoseDecoder (const PoseCodecParams& params = PoseCodecParams());
+
+	/// Decodes a frame; false if it is malformed or it is a delta frame that does not follow the
+	/// last decoded one, in which case the frames are skipped until the next keyframe
+	bool decode (const uint8_t* buffer, size_t size, double& time, double readings [4][7]);
+
+	/// The number of frames skipped while waiting for a keyframe
+	size_t skipped () const { return numSkipped; }
+
+private:
+	PoseCodecParams params;
+	PoseCodecState previous;
+	bool synced;
+	uint8_t sequence;					///< The sequence number of the last decoded frame
+	size_t numSkipped;
+};
@@ -0,0 +1,74 @@
+/**
+ * @file Recording.cpp
+ * @date Oct 18, 2026
+ * @brief Writing and memory-mapped reading of the captured channel data.
+ */
+
+#include "Recording.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ********************************************************************************************* */
+bool RecordingWriter::open (const char* path, const char* magic) {
+	close();
+	file = fopen(path, "wb");
+	if(file == NULL) return false;
+	return fwrite(magic, 1, strlen(magic), file) == strlen(magic);
+}
+
+/* ********************************************************************************************* */
+bool RecordingWriter::write (double receiveTime, const uint8_t* message, uint32_t size) {
+	if(file == NULL) return false;
+	return (fwrite(&size, sizeof(size), 1, file) == 1) &&
+		(fwrite(&receiveTime, sizeof(receiveTime), 1, file) == 1) &&
+		(fwrite(message, 1, size, file) == size);
+}
+
+/* ********************************************************************************************* */
+void RecordingWriter::close () {
+	if(file != NULL) fclose(file);
+	file = NULL;
+}
+
+/* ********************************************************************************************* */
+bool RecordingReader::open (const char* path) {
+
+	// Map the file
+	close();
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0) return false;
+	struct stat info;
+	if(fstat(fd, &info) != 0 || (size_t) info.st_size < strlen(RECORDING_MAGIC)) { ::close(fd); return false; }
+	length = info.st_size;
+	void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(mapped == MAP_FAILED) { length = 0; return false; }
+	data = (uint8_t*) mapped;
+	madvise(data, length, MADV_SEQUENTIAL);
+	poses = (memcmp(data, RECORDING_MAGIC_POSES, strlen(RECORDING_MAGIC_POSES)) == 0);
+	if(!poses && memcmp(data, RECORDING_MAGIC, strlen(RECORDING_MAGIC)) != 0) { close(); return false; }
+
+	// Index the records
+	const size_t headerSize = sizeof(uint32_t) + sizeof(double);
+	size_t offset = strlen(RECORDING_MAGIC);
+	while(offset + headerSize <= length) {
+		Record record;
+		memcpy(&record.size, data + offset, sizeof(uint32_t));
+		memcpy(&record.receiveTime, data + offset + sizeof(uint32_t), sizeof(double));
+		if(offset + headerSize + record.size > length) break;
+		record.message = data + offset + headerSize;
+		records.push_back(record);
+		offset += headerSize + record.size;
+	}
+	return true;
+}
+
+/* ********************************************************************************************* */
+void RecordingReader::close () {
+	if(data != NULL) munmap(data, length);
+	data = NULL, length = 0, poses = false;
+	records.clear();
+}
@@ -0,0 +1,69 @@
+/**
+ * @file Recording.h
+ * @date Oct 18, 2026
+ * @brief The on-disk format of the captured channel data: a magic line followed by records of
+ * the packed message size (uint32), the time it was received (double, CLOCK_MONOTONIC seconds)
+ * and the packed protobuf message itself. The reader maps the file and indexes the records so
+ * that they can be decoded in any order, i.e. by several threads. Recordings of liberty frames
+ * can instead hold PoseCodec frames, marked by their own magic; those decode in order.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#define RECORDING_MAGIC "SOMREC1\n"
+#define RECORDING_MAGIC_POSES "SOMREC1P"		///< The records are PoseCodec frames
+
+/* ********************************************************************************************* */
+class RecordingWriter {
+public:
+
+	RecordingWriter () : file(NULL) {}
+	~RecordingWriter () { close(); }
+
+	/// Creates the file and writes the magic; false on errors
+	bool open (const char* path, const char* magic = RECORDING_MAGIC);
+
+	/// Appends a record; false on errors
+	bool write (double receiveTime, const uint8_t* message, uint32_t size);
+
+	void close ();
+
+private:
+	FILE* file;
+};
+
+/* ********************************************************************************************* */
+class RecordingReader {
+public:
+
+	/// A record inside the mapped file
+	struct Record {
+		double receiveTime;
+		const uint8_t* message;
+		uint32_t size;
+	};
+
+	RecordingReader () : data(NULL), length(0), poses(false) {}
+	~RecordingReader () { close(); }
+
+	/// Maps the file and indexes the records; a truncated last record is ignored
+	bool open (const char* path);
+
+	size_t size () const { return records.size(); }
+
+	/// True if the records are PoseCodec frames rather than packed messages
+	bool encoded () const { return poses; }
+	const Record& operator[] (size_t i) const { return records[i]; }
+
+	void close ();
+
+private:
+	uint8_t* data;
+	size_t length;
+	bool poses;
+	std::vector <Record> records;
+};
@@ -0,0 +1,212 @@
+/**
+ * @file SensorHealth.cpp
+ * @date Oct 18, 2026
+ * @brief The per-sample outlier, limit and noise checks of the liberty sensors.
+ */
+
+#include "SensorHealth.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace Eigen;
+
+/* ********************************************************************************************* */
+const char* healthVerdictName (HealthVerdict verdict) {
+	switch(verdict) {
+		case HEALTH_OK: return "ok";
+		case HEALTH_CLAMPED: return "clamped";
+		case HEALTH_REJECTED: return "rejected";
+		case HEALTH_RESEEDED: return "reseeded";
+	}
+	return "?";
+}
+
+/* ********************************************************************************************* */
+HealthParams::HealthParams () : normTolerance(0.05), maxSpeed(3.0), maxAcceleration(100.0),
+		maxAngularSpeed(30.0), maxAngularAcceleration(3000.0), outlierSigmas(8.0), outlierFloor(0.002),
+		noiseScale(0.002), window(240), warmup(24), reseedAfter(24), clamp(true) {}
+
+/* ********************************************************************************************* */
+SensorHealth::SensorHealth (const HealthParams& params) : params(params), seeded(false), lastTime(0.0),
+		lastPosition(Vector3d::Zero()), lastVelocity(Vector3d::Zero()), lastOrientation(Quaterniond::Identity()),
+		lastAngularSpeed(NAN), count(0), rejections(0), errorMean(0.0), errorVariance(0.0), good(1.0),
+		lastReasons(0), numSamples(0), numRejected(0), numClamped(0), numReseeded(0) {}
+
+/* ********************************************************************************************* */
+void SensorHealth::save (SensorHealthState& state) const {
+	state.seeded = seeded, state.lastTime = lastTime;
+	for(size_t i = 0; i < 3; i++) state.lastPosition[i] = lastPosition(i), state.lastVelocity[i] = lastVelocity(i);
+	for(size_t i = 0; i < 4; i++) state.lastOrientation[i] = lastOrientation.coeffs()(i);
+	state.lastAngularSpeed = lastAngularSpeed;
+	state.count = count, state.rejections = rejections;
+	state.errorMean = errorMean, state.errorVariance = errorVariance, state.good = good;
+	state.lastReasons = lastReasons;
+	state.numSamples = numSamples, state.numRejected = numRejected;
+	state.numClamped = numClamped, state.numReseeded = numReseeded;
+}
+
+/* ********************************************************************************************* */
+void SensorHealth::restore (const SensorHealthState& state) {
+	seeded = state.seeded, lastTime = state.lastTime;
+	lastPosition = Vector3d(state.lastPosition), lastVelocity = Vector3d(state.lastVelocity);
+	lastOrientation.coeffs() = Vector4d(state.lastOrientation);
+	lastAngularSpeed = state.lastAngularSpeed;
+	count = state.count, rejections = state.rejections;
+	errorMean = state.errorMean, errorVariance = state.errorVariance, good = state.good;
+	lastReasons = state.lastReasons;
+	numSamples = state.numSamples, numRejected = state.numRejected;
+	numClamped = state.numClamped, numReseeded = state.numReseeded;
+}
+
+/* ********************************************************************************************* */
+double SensorHealth::noise () const {
+	return (count >= params.warmup) ? sqrt(errorVariance) : 0.0;
+}
+
+/* ********************************************************************************************* */
+double SensorHealth::score () const {
+	double relative = noise() / params.noiseScale;
+	return good / (1.0 + relative * relative);
+}
+
+/* ********************************************************************************************* */
+void SensorHealth::accept (double time, const Vector3d& p, const Quaterniond& q, double angularSpeed) {
+	lastVelocity = seeded ? Vector3d((p - lastPosition) / (time - lastTime)) : Vector3d(NAN, NAN, NAN);
+	lastAngularSpeed = seeded ? angularSpeed : NAN;
+	lastTime = time, lastPosition = p, lastOrientation = q;
+	seeded = true;
+	rejections = 0;
+}
+
+/* ********************************************************************************************* */
+HealthVerdict SensorHealth::check (double time, double reading [7]) {
+
+	// The good share moves toward 1 for good samples, 0.5 for clamped ones and 0 otherwise
+	const double weight = 1.0 / std::min(++numSamples, params.window);
+	HealthVerdict verdict = HEALTH_OK;
+	lastReasons = 0;
+
+	// Samples that can not be used at all
+	Vector3d p (reading[0], reading[1], reading[2]);
+	Quaterniond q (reading[6], reading[3], reading[4], reading[5]);
+	double norm = q.norm();
+	if(!(p.allFinite() && std::isfinite(norm) && std::isfinite(time))) lastReasons |= HEALTH_NAN;
+	else if(fabs(norm - 1.0) > params.normTolerance) lastReasons |= HEALTH_NORM;
+	else q.coeffs() /= norm;
+	bool usable = (lastReasons == 0);
+
+	// The first one is the reference, as is one after a restart of the publisher
+	double dt = time - lastTime;
+	if(usable && (!seeded || dt <= 0.0)) {
+		verdict = seeded ? HEALTH_RESEEDED : HEALTH_OK;
+		if(seeded) numReseeded++;
+		seeded = false;
+		accept(time, p, q, 0.0);
+	}
+
+	// Compare with the last good sample: speeds, accelerations once the velocity is known, and the
+	// constant velocity prediction error once the statistics have warmed up
+	else if(usable) {
+		Vector3d velocity = (p - lastPosition) / dt;
+		double angle = lastOrientation.angularDistance(q), angularSpeed = angle / dt;
+		bool moving = lastVelocity.allFinite();
+		Vector3d change = moving ? Vector3d(velocity - lastVelocity) : Vector3d::Zero();
+		double error = moving ? change.norm() * dt : 0.0;
+
+		if(velocity.norm() > params.maxSpeed) lastReasons |= HEALTH_SPEED;
+		if(change.norm() > params.maxAcceleration * dt) lastReasons |= HEALTH_ACCELERATION;
+		if(angularSpeed > params.maxAngularSpeed) lastReasons |= HEALTH_ANGULAR_SPEED;
+		if(!std::isnan(lastAngularSpeed) && angularSpeed - lastAngularSpeed > params.maxAngularAcceleration * dt)
+			lastReasons |= HEALTH_ANGULAR_ACCELERATION;
+		double threshold = std::max(errorMean + params.outlierSigmas * sqrt(errorVariance), params.outlierFloor);
+		if(count >= params.warmup && error > threshold) lastReasons |= HEALTH_OUTLIER;
+
+		// Update the prediction error statistics with the weight capped at the window. The error is
+		// clipped at the threshold so that a glitch moves them little but a lasting distortion
+		// raises the deviation step by step until its samples are accepted again.
+		if(moving) {
+			count++;
+			double w = 1.0 / std::min(count, params.window), delta = std::min(error, threshold) - errorMean;
+			errorMean += w * delta;
+			errorVariance = (1.0 - w) * (errorVariance + w * delta * delta);
+		}
+
+		// Good
+		if(lastReasons == 0) accept(time, p, q, angularSpeed);
+
+		// Within the limits: keep the velocity change and the speed under the limits, and turn at
+		// most as fast as the angular limits allow
+		else if(params.clamp && !(lastReasons & HEALTH_OUTLIER)) {
+			double maxChange = params.maxAcceleration * dt;
+			if(change.norm() > maxChange) change *= maxChange / change.norm();
+			Vector3d clamped = moving ? Vector3d(lastVelocity + change) : velocity;
+			if(clamped.norm() > params.maxSpeed) clamped *= params.maxSpeed / clamped.norm();
+			double allowed = params.maxAngularSpeed;
+			if(!std::isnan(lastAngularSpeed))
+				allowed = std::min(allowed, lastAngularSpeed + params.maxAngularAcceleration * dt);
+			if(angularSpeed > allowed) q = lastOrientation.slerp(allowed / angularSpeed, q);
+			p = lastPosition + clamped * dt;
+			accept(time, p, q, std::min(angularSpeed, allowed));
+			verdict = HEALTH_CLAMPED;
+			numClamped++;
+		}
+		else usable = false;
+	}
+
+	// Hold the last good sample, unless the rejections went on so long that the sensor probably
+	// moved for real (i.e. it was covered) and this sample is a fine reference
+	if(!usable && seeded) {
+		if(lastReasons & (HEALTH_NAN | HEALTH_NORM) || ++rejections < params.reseedAfter) {
+			verdict = HEALTH_REJECTED;
+			numRejected++;
+			p = lastPosition, q = lastOrientation;
+		}
+		else {
+			verdict = HEALTH_RESEEDED;
+			numReseeded++;
+			seeded = false;
+			accept(time, p, q, 0.0);
+		}
+	}
+	else if(!usable) {
+		verdict = HEALTH_REJECTED;
+		numRejected++;
+	}
+
+	// Write back the value to use
+	if(seeded) {
+		reading[0] = p.x(), reading[1] = p.y(), reading[2] = p.z();
+		reading[3] = q.x(), reading[4] = q.y(), reading[5] = q.z(), reading[6] = q.w();
+	}
+	double target = (verdict == HEALTH_OK) ? 1.0 : (verdict == HEALTH_CLAMPED) ? 0.5 : 0.0;
+	good += weight * (target - good);
+	return verdict;
+}
+
+/* ********************************************************************************************* */
+bool readHealthReport (const uint8_t* frame, size_t size, HealthReport& report) {
+	if(size != sizeof(report)) return false;
+	memcpy(&report, frame, sizeof(report));
+	return report.magic == HEALTH_REPORT_MAGIC && report.version == HEALTH_REPORT_VERSION;
+}
+
+/* ********************************************************************************************* */
+LibertyHealth::LibertyHealth (const HealthParams& params) {
+	for(size_t s = 0; s < 4; s++) sensors[s] = SensorHealth(params);
+}
+
+/* ********************************************************************************************* */
+bool LibertyHealth::check (double time, double readings [4][7], HealthReport& report) {
+	bool whole = true;
+	report.magic = HEALTH_REPORT_MAGIC, report.version = HEALTH_REPORT_VERSION;
+	report.time = time;
+	for(size_t s = 0; s < 4; s++) {
+		HealthVerdict verdict = sensors[s].check(time, readings[s]);
+		report.score[s] = sensors[s].score();
+		report.verdict[s] = verdict;
+		report.reasons[s] = sensors[s].reasons();
+		if(verdict == HEALTH_REJECTED) whole = false;
+	}
+	return whole;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file SensorHealth.h
+ * @date Oct 18, 2026
+ * @brief Streaming checks of the liberty readings before they reach the angle math. The tracker
+ * glitches near metal: a sample jumps, its quaternion is not unit or the field distortion makes
+ * the readings noisy. Every sample of a sensor is checked against the last good one for NaNs,
+ * the quaternion norm, the linear and angular speed and acceleration limits and, once enough
+ * samples were seen, against the spread of the constant velocity prediction errors (Welford
+ * statistics whose weight is capped at the window, i.e. exponential forgetting after it).
+ * Outliers are replaced by the last good sample and limit violations are either clamped to the
+ * limits or replaced too. Each sensor has a quality score between 0 and 1 from the share of good
+ * samples and the prediction noise. Everything is O(1) in time and memory per sample.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Eigen/Dense>
+
+/// What happened to a sample
+enum HealthVerdict {
+	HEALTH_OK = 0,
+	HEALTH_CLAMPED,			///< Moved back within the kinematic limits
+	HEALTH_REJECTED,			///< Replaced by the last good sample
+	HEALTH_RESEEDED			///< Taken as the new reference after too many rejections in a row
+};
+
+/// Why a sample was not used as it is (bits)
+enum HealthReason {
+	HEALTH_NAN = 0x1,
+	HEALTH_NORM = 0x2,							///< The quaternion is not unit within the tolerance
+	HEALTH_SPEED = 0x4,
+	HEALTH_ACCELERATION = 0x8,
+	HEALTH_ANGULAR_SPEED = 0x10,
+	HEALTH_ANGULAR_ACCELERATION = 0x20,
+	HEALTH_OUTLIER = 0x40						///< Far outside the usual prediction error
+};
+
+/// Returns the name of a verdict for printing
+const char* healthVerdictName (HealthVerdict verdict);
+
+/// The limits; the defaults are well beyond what a hand does
+struct HealthParams {
+	double normTolerance;					///< Largest | |q| - 1 |; smaller errors are normalized
+	double maxSpeed;							///< m/s
+	double maxAcceleration;					///< m/s^2
+	double maxAngularSpeed;					///< rad/s
+	double maxAngularAcceleration;		///< rad/s^2
+	double outlierSigmas;					///< A prediction error above this many deviations is an outlier
+	double outlierFloor;						///< ... and above this (m), so that a still sensor is not too strict
+	double noiseScale;						///< The prediction noise (m) at which the noise part of the score is 0.5
+	size_t window;								///< Samples in the statistics and the good share
+	size_t warmup;								///< Samples before the outlier test starts
+	size_t reseedAfter;						///< Rejections in a row after which a sample is taken anyway
+	bool clamp;									///< Clamp limit violations instead of rejecting them
+
+	HealthParams ();
+};
+
+/// The state of the checks of a sensor as plain values, for a checkpoint (see checkpoint.h)
+struct SensorHealthState {
+	bool seeded;
+	double lastTime, lastPosition [3], lastVelocity [3], lastOrientation [4], lastAngularSpeed;	///< (x, y, z, w)
+	uint64_t count, rejections;
+	double errorMean, errorVariance, good;
+	uint32_t lastReasons;
+	uint64_t numSamples, numRejected, numClamped, numReseeded;
+};
+
+/* ********************************************************************************************* */
+/// The checks of one sensor
+class SensorHealth {
+public:
+
+	SensorHealth (const HealthParams& params = HealthParams());
+
+	/// Checks a reading (x, y, z, qx, qy, qz, qw) taken at the given time and replaces it with the
+	/// value to use: normalized, clamped or the last good one. Before the first good sample a
+	/// rejected reading is left as it is.
+	HealthVerdict check (double time, double reading [7]);
+
+	/// Changes the limits and thresholds; the statistics and the last good sample are kept
+	void configure (const HealthParams& next) { params = next; }
+
+	/// Copies the statistics and the last good sample out and back in; the parameters are not part of it
+	void save (SensorHealthState& state) const;
+	void restore (const SensorHealthState& state);
+
+	double score () const;							///< 0 (unusable) to 1
+	double goodShare () const { return good; }
+	double noise () const;							///< The deviation of the prediction errors (m)
+	unsigned int reasons () const { return lastReasons; }	///< Of the last sample
+	size_t rejected () const { return numRejected; }
+	size_t clamped () const { return numClamped; }
+	size_t reseeded () const { return numReseeded; }
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+	/// Makes the sample the last good one
+	void accept (double time, const Eigen::Vector3d& p, const Eigen::Quaterniond& q, double angularSpeed);
+
+	HealthParams params;
+	bool seeded;
+	double lastTime;
+	Eigen::Vector3d lastPosition, lastVelocity;
+	Eigen::Quaterniond lastOrientation;
+	double lastAngularSpeed;
+	size_t count, rejections;					///< Samples in the statistics; rejections in a row
+	double errorMean, errorVariance;		///< Of the prediction error norms
+	double good;									///< The moving share of good samples
+	unsigned int lastReasons;
+	size_t numSamples, numRejected, numClamped, numReseeded;
+};
+
+/* ********************************************************************************************* */
+#define HEALTH_REPORT_MAGIC 0x31484c4c		///< "LLH1"
+#define HEALTH_REPORT_VERSION 1				///< Incremented with every change of the layout
+
+/// The message put on the health channel for every frame: the state of each sensor. It goes on
+/// the channel as it is, so this is its wire format: 80 bytes in the byte order of the host, with
+/// no padding, the verdicts and reasons as the values of HealthVerdict and HealthReason. A reader
+/// checks the size, the magic and the version (see readHealthReport); a new field goes at the end
+/// with a new version.
+struct HealthReport {
+	uint32_t magic, version;				///< Set by LibertyHealth::check
+	double time;								///< The metadata time of the frame
+	double score [4];
+	uint32_t verdict [4];
+	uint32_t reasons [4];
+};
+
+static_assert(sizeof(HealthReport) == 80, "the health report is packed");
+
+/// Copies a frame of the health channel into the report; false if it is not one of this version
+bool readHealthReport (const uint8_t* frame, size_t size, HealthReport& report);
+
+/// The checks of the 4 sensors of a frame
+class LibertyHealth {
+public:
+
+	LibertyHealth (const HealthParams& params = HealthParams());
+
+	/// Checks the readings of a frame in place and fills the report; returns false if a sensor
+	/// was rejected, i.e. the frame holds a repeated reading
+	bool check (double time, double readings [4][7], HealthReport& report);
+
+	/// Changes the parameters of all the sensors, keeping their state
+	void configure (const HealthParams& params) { for(size_t i = 0; i < 4; i++) sensors[i].configure(params); }
+
+	void save (SensorHealthState states [4]) const { for(size_t i = 0; i < 4; i++) sensors[i].save(states[i]); }
+	void restore (const SensorHealthState states [4]) { for(size_t i = 0; i < 4; i++) sensors[i].restore(states[i]); }
+
+	const SensorHealth& sensor (size_t i) const { return sensors[i]; }
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+	SensorHealth sensors [4];
+};
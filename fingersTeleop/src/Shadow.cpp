@@ -0,0 +1,208 @@
+/**
+ * @file Shadow.cpp
+ * @date Oct 18, 2026
+ * @brief Shadow runs of two pose and angle engines.
+ */
+
+#include "Shadow.h"
+#include "Liberty.h"
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+using namespace Eigen;
+
+/* ********************************************************************************************* */
+bool poseEngine (const double readings [4][7], EngineOutput& output) {
+	for(size_t s = 0; s < 4; s++) for(size_t k = 0; k < 7; k++) if(isnan(readings[s][k])) return false;
+	Pose <RobotFrame> poses [4];
+	for(size_t i = 0; i < 4; i++) {
+		poses[i] = sensorToPose(readings[i]);
+		output.positions[i] = poses[i].position;
+		output.matrices[i] = poses[i].orientation.toRotationMatrix();
+	}
+	output.angles[0] = palmAngle(poses[0]);
+	for(size_t i = 1; i < 4; i++) output.angles[i] = fingerAngle(poses[0], poses[i]);
+	return true;
+}
+
+/* ********************************************************************************************* */
+bool eulerEngine (const double readings [4][7], EngineOutput& output) {
+	for(size_t s = 0; s < 4; s++) for(size_t k = 0; k < 7; k++) if(isnan(readings[s][k])) return false;
+	VectorXd config (6);
+	for(size_t i = 0; i < 4; i++) {
+		sensorToConfig(readings[i], config);
+		output.positions[i] = config.head<3>();
+		output.matrices[i] = configToMatrix(config);
+	}
+	output.angles[0] = palmAngle(output.matrices[0]);
+	for(size_t i = 1; i < 4; i++) output.angles[i] = fingerAngle(output.matrices[0], output.matrices[i]);
+	return true;
+}
+
+/* ********************************************************************************************* */
+AngleEngine findEngine (const char* name) {
+	if(strcmp(name, "pose") == 0) return poseEngine;
+	if(strcmp(name, "euler") == 0) return eulerEngine;
+	return NULL;
+}
+
+/* ********************************************************************************************* */
+/// Pins a thread to a core; false if it could not be
+static bool pinCore (pthread_t thread, int cpu, const char* what) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	int r = pthread_setaffinity_np(thread, sizeof(set), &set);
+	if(r != 0) fprintf(stderr, "[shadow] Couldn't pin the %s to core %d: %s\n", what, cpu, strerror(r));
+	return r == 0;
+}
+
+/* ********************************************************************************************* */
+ShadowRunner::ShadowRunner (const char* prefix, AngleEngine primary, AngleEngine candidate, int cpu,
+		double tolerance, bool pinCaller) : prefix(prefix), primary(primary), candidate(candidate), tolerance(tolerance),
+		callerCore(-1), candidateCore(-1), callerThread(pthread_self()), head(0), tail(0), numDropped(0), stopping(false), primarySum(0.0), candidateSum(0.0),
+		primaryMetric((this->prefix + "_shadow_primary_seconds").c_str(), "Mean time of the primary engine per frame"),
+		candidateMetric((this->prefix + "_shadow_candidate_seconds").c_str(), "Mean time of the candidate engine per frame"),
+		droppedMetric((this->prefix + "_shadow_dropped").c_str(), "Frames not compared as the candidate fell behind"),
+		mismatchMetric((this->prefix + "_shadow_mismatches").c_str(), "Frames whose angles differ over the tolerance"),
+		errorMetric((this->prefix + "_shadow_max_angle_error").c_str(), "Largest angle difference so far (rad)") {
+
+	memset(&stats, 0, sizeof(stats));
+	for(size_t i = 0; i < 4; i++) sumSquares[i] = 0.0;
+
+	// The candidate inherits a mask without the signals that stop the caller's loop, so that they
+	// are never delivered to it
+	sigset_t block, previous;
+	sigemptyset(&block);
+	sigaddset(&block, SIGINT);
+	sigaddset(&block, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &block, &previous);
+	thread = std::thread(&ShadowRunner::compare, this);
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+	// Pin the candidate, and the caller if asked, to two of the cores the caller may run on, the
+	// candidate to 'cpu' if given, so that the scheduler never moves them onto the same one. A
+	// caller that is already on a single core keeps it and the candidate goes to the next core.
+	CPU_ZERO(&callerCores);
+	if(sched_getaffinity(0, sizeof(callerCores), &callerCores) != 0) return;
+	cpu_set_t allowed = callerCores;
+	int first = -1;
+	for(int c = 0; c < CPU_SETSIZE && first < 0; c++) if(CPU_ISSET(c, &allowed) && c != cpu) first = c;
+	if(CPU_COUNT(&allowed) == 1) {
+		long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+		for(long c = 0; c < numCores && c < CPU_SETSIZE; c++) CPU_SET(c, &allowed);
+	}
+	for(int k = 1; k < CPU_SETSIZE && cpu < 0; k++) if(CPU_ISSET((first + k) % CPU_SETSIZE, &allowed)) cpu = (first + k) % CPU_SETSIZE;
+	if(first < 0 || cpu < 0) return;
+	if(pinCaller && pinCore(pthread_self(), first, "caller")) callerCore = first;
+	if(pinCore(thread.native_handle(), cpu, "candidate")) candidateCore = cpu;
+}
+
+/* ********************************************************************************************* */
+ShadowRunner::~ShadowRunner () {
+	stopping = true;
+	thread.join();
+	if(callerCore >= 0) pthread_setaffinity_np(callerThread, sizeof(callerCores), &callerCores);
+}
+
+/* ********************************************************************************************* */
+bool ShadowRunner::run (const double readings [4][7], EngineOutput& output) {
+	double start = metricsNow();
+	bool ok = primary(readings, output);
+	submit(readings, output, ok, metricsNow() - start);
+	return ok;
+}
+
+/* ********************************************************************************************* */
+void ShadowRunner::submit (const double readings [4][7], const EngineOutput& output, bool ok, double seconds) {
+	uint64_t h = head.load(std::memory_order_relaxed);
+	if(h - tail.load(std::memory_order_acquire) == SHADOW_QUEUE_FRAMES) {
+		numDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	Slot& slot = slots[h % SHADOW_QUEUE_FRAMES];
+	memcpy(slot.readings, readings, sizeof(slot.readings));
+	slot.primary = output;
+	slot.ok = ok, slot.seconds = seconds;
+	head.store(h + 1, std::memory_order_release);
+}
+
+/* ********************************************************************************************* */
+void ShadowRunner::compare () {
+	EngineOutput output;
+	while(true) {
+		uint64_t t = tail.load(std::memory_order_relaxed);
+		if(t == head.load(std::memory_order_acquire)) {
+			if(stopping) return;
+			usleep(200);
+			continue;
+		}
+		const Slot& slot = slots[t % SHADOW_QUEUE_FRAMES];
+		double start = metricsNow();
+		bool ok = candidate(slot.readings, output);
+		double seconds = metricsNow() - start;
+
+		// The differences of the outputs
+		std::lock_guard <std::mutex> lock (mutex);
+		stats.compared++;
+		primarySum += slot.seconds, candidateSum += seconds;
+		stats.primaryMax = std::max(stats.primaryMax, slot.seconds);
+		stats.candidateMax = std::max(stats.candidateMax, seconds);
+		if(ok != slot.ok) stats.disagreements++;
+		else if(ok) {
+			stats.usable++;
+			bool mismatch = false;
+			for(size_t i = 0; i < 4; i++) {
+				double angle = fabs(output.angles[i] - slot.primary.angles[i]);
+				stats.maxAngle[i] = std::max(stats.maxAngle[i], angle);
+				sumSquares[i] += angle * angle;
+				mismatch |= !(angle <= tolerance);
+				stats.maxPosition = std::max(stats.maxPosition,
+					(output.positions[i] - slot.primary.positions[i]).cwiseAbs().maxCoeff());
+				stats.maxMatrix = std::max(stats.maxMatrix,
+					(output.matrices[i] - slot.primary.matrices[i]).cwiseAbs().maxCoeff());
+			}
+			if(mismatch) stats.mismatches++;
+			errorMetric.set(*std::max_element(stats.maxAngle, stats.maxAngle + 4));
+		}
+		primaryMetric.set(primarySum / stats.compared), candidateMetric.set(candidateSum / stats.compared);
+		droppedMetric.set(numDropped.load(std::memory_order_relaxed)), mismatchMetric.set(stats.mismatches);
+		tail.store(t + 1, std::memory_order_release);
+	}
+}
+
+/* ********************************************************************************************* */
+void ShadowRunner::drain () const {
+	while(tail.load(std::memory_order_acquire) != head.load(std::memory_order_acquire)) usleep(100);
+}
+
+/* ********************************************************************************************* */
+ShadowSummary ShadowRunner::summary () const {
+	std::lock_guard <std::mutex> lock (mutex);
+	ShadowSummary summary = stats;
+	summary.dropped = numDropped.load(std::memory_order_relaxed);
+	summary.submitted = head.load(std::memory_order_relaxed) + summary.dropped;
+	uint64_t compared = std::max(stats.compared, (uint64_t) 1), usable = std::max(stats.usable, (uint64_t) 1);
+	for(size_t i = 0; i < 4; i++) summary.rmsAngle[i] = sqrt(sumSquares[i] / usable);
+	summary.primaryMean = primarySum / compared, summary.candidateMean = candidateSum / compared;
+	return summary;
+}
+
+/* ********************************************************************************************* */
+void ShadowRunner::print (FILE* file) const {
+	ShadowSummary s = summary();
+	fprintf(file, "[shadow] %lu frames, %lu compared, %lu dropped, %lu usable, %lu disagreements, %lu over %g rad\n",
+		(unsigned long) s.submitted, (unsigned long) s.compared, (unsigned long) s.dropped, (unsigned long) s.usable,
+		(unsigned long) s.disagreements, (unsigned long) s.mismatches, tolerance);
+	fprintf(file, "[shadow] angle differences (rad): max %.3g %.3g %.3g %.3g, rms %.3g %.3g %.3g %.3g\n",
+		s.maxAngle[0], s.maxAngle[1], s.maxAngle[2], s.maxAngle[3], s.rmsAngle[0], s.rmsAngle[1], s.rmsAngle[2],
+		s.rmsAngle[3]);
+	fprintf(file, "[shadow] largest position difference %.3g m, matrix entry %.3g\n", s.maxPosition, s.maxMatrix);
+	fprintf(file, "[shadow] primary %.1f ns per frame (max %.1f), candidate %.1f ns (max %.1f) on core %d\n",
+		1e9 * s.primaryMean, 1e9 * s.primaryMax, 1e9 * s.candidateMean, 1e9 * s.candidateMax, candidateCore);
+}
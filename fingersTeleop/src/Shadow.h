@@ -0,0 +1,135 @@
+/**
+ * @file Shadow.h
+ * @date Oct 18, 2026
+ * @brief Shadow (A/B) runs of two pose and angle engines on the same frames. The primary engine
+ * runs on the calling thread and its output is the one that is used; the frame and that output
+ * are copied into a queue that a thread on another core drains, running the candidate engine on
+ * each frame and recording the difference of the outputs and the time of each engine in a
+ * summary. Submitting a frame is a copy and an atomic store, so with a core of its own the
+ * candidate adds little more than that copy to the caller; on a single core the two share it and
+ * the candidate does delay the caller. When the candidate falls behind, frames are dropped from the comparison (and
+ * counted) rather than queued without bound. The summary is also exported with the metrics.
+ *
+ *   ShadowRunner shadow ("printLiberty", poseEngine, eulerEngine);
+ *   ...every frame:
+ *   if(shadow.run(readings, output)) use(output);
+ *   ...at exit:
+ *   shadow.print(stdout);
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <Eigen/Dense>
+#include "metrics.h"
+
+/// Frames the candidate may fall behind before they are dropped; a power of two
+#define SHADOW_QUEUE_FRAMES 64
+
+/// What an engine computes from the readings of a frame, in the robot convention
+struct EngineOutput {
+	Eigen::Vector3d positions [4];
+	Eigen::Matrix3d matrices [4];
+	double angles [4];					///< The palm angle and then the finger angles (rad)
+};
+
+/// Computes the output of the readings (x, y, z, qx, qy, qz, qw per sensor); false if they can
+/// not be used
+typedef bool (*AngleEngine) (const double readings [4][7], EngineOutput& output);
+
+/// The engine of sensorToPose and the pose angles
+bool poseEngine (const double readings [4][7], EngineOutput& output);
+
+/// The euler engine of the original printLiberty: sensorToConfig, configToMatrix and the matrix angles
+bool eulerEngine (const double readings [4][7], EngineOutput& output);
+
+/// Returns the engine of a name ("pose" or "euler"), NULL if there is none
+AngleEngine findEngine (const char* name);
+
+/// What the shadow runs found so far
+struct ShadowSummary {
+	uint64_t submitted, compared, dropped;
+	uint64_t usable;								///< Frames both engines could use
+	uint64_t disagreements;						///< Frames only one of the engines could use
+	uint64_t mismatches;							///< Frames with an angle difference over the tolerance
+	double maxAngle [4], rmsAngle [4];		///< Of the angle differences (rad)
+	double maxPosition, maxMatrix;			///< Largest difference of a coordinate (m) and of a matrix entry
+	double primaryMean, primaryMax;			///< Time per frame of each engine (s)
+	double candidateMean, candidateMax;
+};
+
+/* ********************************************************************************************* */
+class ShadowRunner {
+public:
+
+	/// Pins the candidate thread to 'cpu', or if it is negative to the core after the first one the
+	/// caller may run on. With 'pinCaller' the calling thread, which runs the primary, is pinned to
+	/// that first core, or keeps the one it is already pinned to, until the runner is destroyed;
+	/// the threads it starts meanwhile inherit the pinning. On a host with a single core neither is
+	/// pinned. The candidate never takes SIGINT or SIGTERM. The primary may be NULL if the frames
+	/// are only submitted. Frames whose angles differ by more than 'tolerance' (rad) count as
+	/// mismatches.
+	ShadowRunner (const char* prefix, AngleEngine primary, AngleEngine candidate, int cpu = -1,
+		double tolerance = 1e-6, bool pinCaller = false);
+
+	/// Stops the candidate thread, and gives the caller back the cores it had if it was pinned; the
+	/// frames still queued are not compared
+	~ShadowRunner ();
+
+	/// Runs the primary on the readings and submits the frame; returns what the primary returned
+	bool run (const double readings [4][7], EngineOutput& output);
+
+	/// Queues a frame whose primary output was computed by the caller in 'seconds'
+	void submit (const double readings [4][7], const EngineOutput& primary, bool ok, double seconds);
+
+	/// Waits until the candidate has compared every queued frame
+	void drain () const;
+
+	ShadowSummary summary () const;
+
+	/// Prints the summary on a few lines
+	void print (FILE* file) const;
+
+	/// The core of the candidate thread, -1 if it could not be pinned
+	int core () const { return candidateCore; }
+
+	/// The core the calling thread was pinned to, -1 if it was not
+	int primaryCore () const { return callerCore; }
+
+private:
+
+	/// Runs the candidate on the queued frames until stopped
+	void compare ();
+
+	struct Slot {
+		double readings [4][7];
+		EngineOutput primary;
+		bool ok;
+		double seconds;
+	};
+
+	std::string prefix;
+	AngleEngine primary, candidate;
+	double tolerance;
+	int callerCore, candidateCore;
+	pthread_t callerThread;
+	cpu_set_t callerCores;							///< What the caller had before it was pinned
+	Slot slots [SHADOW_QUEUE_FRAMES];
+	std::atomic <uint64_t> head, tail;			///< Frames submitted and compared (or skipped)
+	std::atomic <uint64_t> numDropped;
+	std::atomic <bool> stopping;
+	mutable std::mutex mutex;						///< Of the summary
+	ShadowSummary stats;
+	double sumSquares [4], primarySum, candidateSum;
+	MetricGauge primaryMetric, candidateMetric;		///< Gauges, so that the runner can be made with new in C++11
+	MetricGauge droppedMetric, mismatchMetric, errorMetric;
+	std::thread thread;
+};
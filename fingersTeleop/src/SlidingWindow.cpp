@@ -0,0 +1,57 @@
+/**
+ * @file SlidingWindow.cpp
+ * @date Oct 18, 2026
+ * @brief Statistics of the last samples of a signal.
+ */
+
+#include "SlidingWindow.h"
+
+/* ********************************************************************************************* */
+SlidingWindow::SlidingWindow (size_t size) : size(size), count(0), next(0), meanValue(0.0), m2(0.0),
+		minHead(0), minTail(0), maxHead(0), maxTail(0) {
+	if(this->size < 1) this->size = 1;
+	if(this->size > SLIDING_MAX_WINDOW) this->size = SLIDING_MAX_WINDOW;
+}
+
+/* ********************************************************************************************* */
+void SlidingWindow::push (double time, double value) {
+
+	uint64_t index = next++;
+	size_t slot = index % size;
+
+	// Update the running mean and variance; a full window replaces its oldest sample
+	if(count == size) {
+		double old = values[slot], oldMean = meanValue;
+		meanValue += (value - old) / size;
+		m2 += (value - old) * (value - meanValue + old - oldMean);
+		if(m2 < 0.0) m2 = 0.0;
+	}
+	else {
+		count++;
+		double delta = value - meanValue;
+		meanValue += delta / count;
+		m2 += delta * (value - meanValue);
+	}
+
+	// Expire the front of the deques if it is leaving the window (at most one per sample)
+	if(minTail > minHead && minQueue[minHead % SLIDING_MAX_WINDOW] + size <= index) minHead++;
+	if(maxTail > maxHead && maxQueue[maxHead % SLIDING_MAX_WINDOW] + size <= index) maxHead++;
+
+	// Drop the samples from the back that can never be the min/max again
+	while(minTail > minHead && values[minQueue[(minTail - 1) % SLIDING_MAX_WINDOW] % size] >= value) minTail--;
+	while(maxTail > maxHead && values[maxQueue[(maxTail - 1) % SLIDING_MAX_WINDOW] % size] <= value) maxTail--;
+
+	// Store the sample
+	values[slot] = value;
+	times[slot] = time;
+	minQueue[minTail++ % SLIDING_MAX_WINDOW] = index;
+	maxQueue[maxTail++ % SLIDING_MAX_WINDOW] = index;
+}
+
+/* ********************************************************************************************* */
+double SlidingWindow::velocity () const {
+	if(count < 2) return 0.0;
+	size_t newest = (next - 1) % size, oldest = (next - count) % size;
+	double dt = times[newest] - times[oldest];
+	return (dt > 0.0) ? ((values[newest] - values[oldest]) / dt) : 0.0;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file SlidingWindow.h
+ * @date Oct 18, 2026
+ * @brief Statistics of the last samples of a signal updated in O(1) per sample (amortized for the
+ * min/max deques) with fixed storage, so that a window never allocates after construction. Used
+ * by the finger windows of GraspDetector.h and the arrival ages of Playout.h.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// The maximum number of samples in a sliding window
+#define SLIDING_MAX_WINDOW 256
+
+/* ********************************************************************************************* */
+/// Mean, variance, velocity, min and max of the last 'size' samples of a signal. The min and max
+/// are kept in monotonic deques of sample indices.
+class SlidingWindow {
+public:
+
+	SlidingWindow (size_t size = 32);
+
+	/// Adds a sample taken at the given time (seconds), dropping the oldest one if full
+	void push (double time, double value);
+
+	bool full () const { return count == size; }
+	double mean () const { return meanValue; }
+	double variance () const { return (count > 1) ? (m2 / (count - 1)) : 0.0; }
+	double min () const { return (count > 0) ? values[minQueue[minHead % SLIDING_MAX_WINDOW] % size] : 0.0; }
+	double max () const { return (count > 0) ? values[maxQueue[maxHead % SLIDING_MAX_WINDOW] % size] : 0.0; }
+
+	/// The average rate of change over the window (units per second)
+	double velocity () const;
+
+private:
+	size_t size, count;								///< Window size and number of samples in it
+	uint64_t next;										///< The index of the next sample
+	double values [SLIDING_MAX_WINDOW], times [SLIDING_MAX_WINDOW];
+	double meanValue, m2;							///< Running mean and sum of squared deviations
+	uint64_t minQueue [SLIDING_MAX_WINDOW], maxQueue [SLIDING_MAX_WINDOW];
+	uint64_t minHead, minTail, maxHead, maxTail;	///< Deque bounds (mod the capacity), tail is one past the back
+};
@@ -0,0 +1,41 @@
+/**
+ * @file Synthetic.cpp
+ * @date Oct 18, 2026
+ * @brief A deterministic generator of liberty frames.
+ */
+
+#include "Synthetic.h"
+#include <Eigen/Geometry>
+#include <math.h>
+#include <stdlib.h>
+
+/* ********************************************************************************************* */
+SyntheticLiberty::SyntheticLiberty (unsigned int seed) {
+
+	// Pick the phases with a private generator so that the stream only depends on the seed
+	unsigned int state = seed;
+	for(size_t s = 0; s < 4; s++)
+		for(size_t i = 0; i < 7; i++) phases[s][i] = 2.0 * M_PI * rand_r(&state) / RAND_MAX;
+}
+
+/* ********************************************************************************************* */
+void SyntheticLiberty::sample (double time, double out [4][7]) {
+
+	// The palm moves slowly; the fingers curl about the palm's y axis by up to ~90 degrees
+	Eigen::Quaterniond palm = Eigen::AngleAxisd(0.3 * sin(0.5 * time + phases[0][3]), Eigen::Vector3d::UnitZ()) *
+		Eigen::AngleAxisd(0.2 * sin(0.7 * time + phases[0][4]), Eigen::Vector3d::UnitY()) *
+		Eigen::AngleAxisd(0.2 * sin(0.3 * time + phases[0][5]), Eigen::Vector3d::UnitX());
+	for(size_t s = 0; s < 4; s++) {
+		for(size_t i = 0; i < 3; i++) out[s][i] = 0.1 * sin(0.4 * time + phases[s][i]) + 0.05 * s;
+		Eigen::Quaterniond q = palm;
+		if(s > 0) q = palm * Eigen::AngleAxisd(0.8 * (1.0 - cos(1.5 * time + 0.2 * phases[s][6])),
+			Eigen::Vector3d::UnitY());
+		out[s][3] = q.x(), out[s][4] = q.y(), out[s][5] = q.z(), out[s][6] = q.w();
+	}
+}
+
+/* ********************************************************************************************* */
+size_t SyntheticLiberty::pack (double time, double validity, uint8_t* buffer, size_t capacity) {
+	sample(time, readings);
+	return packer.pack(time, time + validity, readings, buffer, capacity);
+}
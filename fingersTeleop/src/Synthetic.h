@@ -0,0 +1,32 @@
+/**
+ * @file Synthetic.h
+ * @date Oct 18, 2026
+ * @brief A deterministic generator of liberty frames for running the pipeline without the
+ * tracker: the palm drifts on slow sinusoids and the fingers repeatedly close and open. The
+ * same seed always gives the same stream.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Liberty.h"
+
+/* ********************************************************************************************* */
+class SyntheticLiberty {
+public:
+
+	SyntheticLiberty (unsigned int seed = 0);
+
+	/// Fills the 4 sensor readings (x, y, z, qx, qy, qz, qw) at the given time (seconds)
+	void sample (double time, double readings [4][7]);
+
+	/// Packs the liberty message of the given time into the buffer with the metadata time set to
+	/// 'time' and valid until 'time + validity'; returns the packed size or 0 if it did not fit
+	size_t pack (double time, double validity, uint8_t* buffer, size_t capacity);
+
+private:
+	double phases [4][7];				///< Random phases per sensor and value
+	double readings [4][7];
+	LibertyPacker packer;
+};
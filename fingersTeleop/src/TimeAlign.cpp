@@ -0,0 +1,144 @@
+/**
+ * @file TimeAlign.cpp
+ * @date Oct 18, 2026
+ * @brief Bounded, time-indexed channel histories with lock-free interpolated lookups.
+ */
+
+#include "TimeAlign.h"
+#include <Eigen/Geometry>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ********************************************************************************************* */
+ChannelHistory::ChannelHistory (size_t numValues, const std::vector <size_t>& quaternions, size_t capacity) :
+		numValues(numValues), capacity(capacity < 4 ? 4 : capacity), quaternions(quaternions),
+		slots(this->capacity), written(0) {
+	if(numValues > HISTORY_MAX_VALUES) {
+		fprintf(stderr, "A channel history holds at most %d values, not %zu\n", HISTORY_MAX_VALUES, numValues);
+		exit(EXIT_FAILURE);
+	}
+	for(size_t i = 0; i < quaternions.size(); i++) {
+		if(quaternions[i] + 4 > numValues) {
+			fprintf(stderr, "The quaternion at %zu is past the %zu values of the history\n", quaternions[i], numValues);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/* ********************************************************************************************* */
+bool ChannelHistory::push (double time, const double* values) {
+
+	// The lookups search the times, which have to be increasing
+	uint64_t k = written.load(std::memory_order_relaxed);
+	if(isnan(time) || (k > 0 && !(time > slots[(k - 1) % capacity].time))) return false;
+	Slot& slot = slots[k % capacity];
+
+	// Mark the slot as being written, fill it and publish it
+	slot.seq.store(2 * k + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.time = time;
+	memcpy(slot.values, values, numValues * sizeof(double));
+	slot.seq.store(2 * k + 2, std::memory_order_release);
+	written.store(k + 1, std::memory_order_release);
+	return true;
+}
+
+/* ********************************************************************************************* */
+bool ChannelHistory::readTime (uint64_t k, double& time) const {
+	const Slot& slot = slots[k % capacity];
+	if(slot.seq.load(std::memory_order_acquire) != 2 * k + 2) return false;
+	time = slot.time;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.seq.load(std::memory_order_relaxed) == 2 * k + 2;
+}
+
+/* ********************************************************************************************* */
+bool ChannelHistory::read (uint64_t k, double& time, double* values) const {
+	const Slot& slot = slots[k % capacity];
+	if(slot.seq.load(std::memory_order_acquire) != 2 * k + 2) return false;
+	time = slot.time;
+	memcpy(values, slot.values, numValues * sizeof(double));
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.seq.load(std::memory_order_relaxed) == 2 * k + 2;
+}
+
+/* ********************************************************************************************* */
+bool ChannelHistory::newest (double& time) const {
+	for(size_t attempt = 0; attempt < 8; attempt++) {
+		uint64_t n = written.load(std::memory_order_acquire);
+		if(n == 0) return false;
+		if(readTime(n - 1, time)) return true;
+	}
+	return false;
+}
+
+/* ********************************************************************************************* */
+void ChannelHistory::interpolate (const double* a, const double* b, double alpha, double* out) const {
+
+	// Linear for everything, then overwrite the quaternions with slerp
+	for(size_t i = 0; i < numValues; i++) out[i] = a[i] + alpha * (b[i] - a[i]);
+	for(size_t i = 0; i < quaternions.size(); i++) {
+		const size_t q = quaternions[i];
+		Eigen::Quaterniond qa (a[q+3], a[q], a[q+1], a[q+2]), qb (b[q+3], b[q], b[q+1], b[q+2]);
+		Eigen::Quaterniond qi = qa.slerp(alpha, qb);
+		out[q] = qi.x(), out[q+1] = qi.y(), out[q+2] = qi.z(), out[q+3] = qi.w();
+	}
+}
+
+/* ********************************************************************************************* */
+HistoryResult ChannelHistory::at (double time, double* values) const {
+
+	double t0, t1, b [HISTORY_MAX_VALUES];
+	for(size_t attempt = 0; attempt < 8; attempt++) {
+
+		// Get the range of samples; skip the oldest slot since the writer may be refilling it
+		uint64_t n = written.load(std::memory_order_acquire);
+		if(n == 0) return HISTORY_EMPTY;
+		uint64_t first = (n > capacity) ? (n - capacity + 1) : 0, last = n - 1;
+
+		// Handle the times outside the range
+		if(!readTime(last, t1)) continue;
+		if(time >= t1) {
+			if(!read(last, t1, values)) continue;
+			return (time == t1) ? HISTORY_OK : HISTORY_HELD;
+		}
+		if(!readTime(first, t0)) continue;
+		if(time < t0) {
+			if(!read(first, t0, values)) continue;
+			return HISTORY_TOO_OLD;
+		}
+
+		// Find the last sample at or before the time
+		uint64_t lo = first, hi = last;
+		bool lapped = false;
+		while(hi - lo > 1) {
+			uint64_t mid = lo + (hi - lo) / 2;
+			double tm;
+			if(!readTime(mid, tm)) { lapped = true; break; }
+			if(tm <= time) lo = mid;
+			else hi = mid;
+		}
+		if(lapped) continue;
+
+		// Interpolate between the two
+		if(!read(lo, t0, values) || !read(hi, t1, b)) continue;
+		double alpha = (t1 > t0) ? ((time - t0) / (t1 - t0)) : 0.0;
+		double a [HISTORY_MAX_VALUES];
+		memcpy(a, values, numValues * sizeof(double));
+		interpolate(a, b, alpha, values);
+		return HISTORY_OK;
+	}
+	return HISTORY_BUSY;
+}
+
+/* ********************************************************************************************* */
+bool snapshotTime (const ChannelHistory* const* channels, size_t numChannels, double& time) {
+	for(size_t i = 0; i < numChannels; i++) {
+		double t;
+		if(!channels[i]->newest(t)) return false;
+		if(i == 0 || t < time) time = t;
+	}
+	return numChannels > 0;
+}
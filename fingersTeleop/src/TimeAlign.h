@@ -0,0 +1,82 @@
+/**
+ * @file TimeAlign.h
+ * @date Oct 18, 2026
+ * @brief Bounded, time-indexed histories of the somatic channels (liberty, arm state, force
+ * sensors, ...) that answer "the state of channel X at time t" so that a controller can build a
+ * consistent snapshot of sensors that arrive at different rates. Positions and joints are
+ * interpolated linearly and quaternions with slerp.
+ *
+ * Each history has a single writer (the thread reading the channel) and any number of readers.
+ * Samples live in a fixed ring where every slot is guarded by a sequence number tagged with the
+ * sample index, so readers never lock and retry if the writer laps them. Lookups are a binary
+ * search, O(log n).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The maximum number of values in one sample, i.e. 4 liberty sensors x 7
+#define HISTORY_MAX_VALUES 32
+
+/// Results of a lookup
+enum HistoryResult {
+	HISTORY_EMPTY = 0,	///< Nothing received yet
+	HISTORY_OK,				///< Interpolated between two samples (or exactly on one)
+	HISTORY_TOO_OLD,		///< The time is before the oldest sample kept; the oldest is returned
+	HISTORY_HELD,			///< The time is after the newest sample; the newest is returned
+	HISTORY_BUSY			///< The writer kept lapping the reader
+};
+
+/* ********************************************************************************************* */
+class ChannelHistory {
+public:
+
+	/// A sample has 'numValues' values, at most HISTORY_MAX_VALUES; each entry of 'quaternions' is
+	/// the index of a quaternion stored as (x, y, z, w), the liberty order. The rest are
+	/// interpolated linearly. Exits if a size or an index is out of range.
+	ChannelHistory (size_t numValues, const std::vector <size_t>& quaternions = std::vector <size_t> (),
+		size_t capacity = 512);
+
+	/// Adds a sample; false (and nothing is added) unless its time is after the newest one. Only
+	/// one thread may push.
+	bool push (double time, const double* values);
+
+	/// Fills 'values' with the state of the channel at the given time
+	HistoryResult at (double time, double* values) const;
+
+	/// Returns the time of the newest sample or false if the history is empty
+	bool newest (double& time) const;
+
+	size_t size () const { return numValues; }
+
+private:
+
+	struct Slot {
+		std::atomic <uint64_t> seq;			///< 2k+1 while sample k is written, 2k+2 when done
+		double time;
+		double values [HISTORY_MAX_VALUES];
+		Slot () : seq(0), time(0.0) {}
+	};
+
+	/// Copies sample k out of the ring; false if it has been overwritten meanwhile
+	bool read (uint64_t k, double& time, double* values) const;
+
+	/// Reads only the time of sample k
+	bool readTime (uint64_t k, double& time) const;
+
+	/// Interpolates between two samples with 0 <= alpha <= 1
+	void interpolate (const double* a, const double* b, double alpha, double* out) const;
+
+	size_t numValues, capacity;
+	std::vector <size_t> quaternions;
+	std::vector <Slot> slots;
+	std::atomic <uint64_t> written;		///< The number of samples pushed so far
+};
+
+/// Returns the latest time at which all the channels can be interpolated (the oldest of their
+/// newest samples), or false if one of them is empty
+bool snapshotTime (const ChannelHistory* const* channels, size_t numChannels, double& time);
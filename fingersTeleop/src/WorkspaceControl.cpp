@@ -0,0 +1,132 @@
+/**
+ * @file WorkspaceControl.cpp
+ * @date Oct 18, 2026
+ * @brief Palm pose to arm joint commands with warm-started damped least-squares IK.
+ */
+
+#include "WorkspaceControl.h"
+#include <math.h>
+#include <time.h>
+
+using namespace Eigen;
+
+/* ********************************************************************************************* */
+ArmModel::ArmModel () : base(0.0), upper(0.328), fore(0.2765), hand(0.2) {
+	upperLimit << 3.1, 2.0, 3.1, 2.0, 3.1, 2.0, 3.1;
+	lowerLimit = -upperLimit;
+}
+
+/* ********************************************************************************************* */
+void ArmModel::jacobian (const Vector7d& q, Jacobian& J, Isometry3d& ee) const {
+
+	// Walk down the chain, recording the axis and the origin of each joint
+	const double links [7] = {0.0, upper, 0.0, fore, 0.0, hand, 0.0};
+	Vector3d axes [7], origins [7];
+	Isometry3d T = Isometry3d::Identity();
+	T.translation() << 0.0, 0.0, base;
+	for(size_t i = 0; i < 7; i++) {
+		const Vector3d axis = (i % 2 == 0) ? Vector3d::UnitZ() : Vector3d::UnitY();
+		T.rotate(AngleAxisd(q(i), axis));
+		axes[i] = T.linear() * axis;
+		origins[i] = T.translation();
+		T.translate(Vector3d(0.0, 0.0, links[i]));
+	}
+	ee = T;
+
+	// Revolute joints: linear part is axis x (ee - origin), angular part is the axis
+	for(size_t i = 0; i < 7; i++) {
+		J.block <3,1> (0, i) = axes[i].cross(ee.translation() - origins[i]);
+		J.block <3,1> (3, i) = axes[i];
+	}
+}
+
+/* ********************************************************************************************* */
+Isometry3d ArmModel::forward (const Vector7d& q) const {
+	Jacobian J;
+	Isometry3d ee;
+	jacobian(q, J, ee);
+	return ee;
+}
+
+/* ********************************************************************************************* */
+IKParams::IKParams () : damping(0.05), maxStep(0.2), maxCommandStep(0.005), maxIterations(50), budget(5e-4),
+	tolerance(1e-4) {}
+
+/* ********************************************************************************************* */
+WorkspaceControl::WorkspaceControl (const ArmModel& arm, const IKParams& params) : scale(1.0),
+		mapping(Matrix3d::Identity()), arm(arm), params(params), isEngaged(false), lastError(0.0) {
+	solution.setZero();
+	commanded.setZero();
+}
+
+/* ********************************************************************************************* */
+void WorkspaceControl::engage (const Isometry3d& palm, const Vector7d& q) {
+	palmReference = palm;
+	eeReference = arm.forward(q);
+	solution = commanded = q;
+	isEngaged = true;
+}
+
+/* ********************************************************************************************* */
+Isometry3d WorkspaceControl::target (const Isometry3d& palm) const {
+	Isometry3d t = eeReference;
+	t.translation() += scale * mapping * (palm.translation() - palmReference.translation());
+	t.linear() = mapping * (palm.linear() * palmReference.linear().transpose()) * mapping.transpose() *
+		eeReference.linear();
+	return t;
+}
+
+/* ********************************************************************************************* */
+size_t WorkspaceControl::solve (const Isometry3d& target, Vector7d& q) const {
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	const double deadline = now.tv_sec + now.tv_nsec * 1e-9 + params.budget;
+	const double lambda2 = params.damping * params.damping;
+
+	Jacobian J;
+	Isometry3d ee;
+	Vector6d e;
+	size_t it = 0;
+	for(; it < params.maxIterations; it++) {
+
+		// Compute the pose error: the position difference and the rotation vector to the target
+		arm.jacobian(q, J, ee);
+		e.head <3> () = target.translation() - ee.translation();
+		AngleAxisd rotation (target.linear() * ee.linear().transpose());
+		e.tail <3> () = rotation.angle() * rotation.axis();
+		lastError = e.norm();
+		if(lastError < params.tolerance) break;
+
+		// Take the damped least-squares step dq = J^T (J J^T + lambda^2 I)^-1 e, limited in size
+		Matrix <double, 6, 6> A = J * J.transpose();
+		A.diagonal().array() += lambda2;
+		Vector7d dq = J.transpose() * A.ldlt().solve(e);
+		double largest = dq.cwiseAbs().maxCoeff();
+		if(largest > params.maxStep) dq *= params.maxStep / largest;
+		q = (q + dq).cwiseMax(arm.lowerLimit).cwiseMin(arm.upperLimit);
+
+		// Stop if the time budget is used up
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if(now.tv_sec + now.tv_nsec * 1e-9 > deadline) { it++; break; }
+	}
+	return it;
+}
+
+/* ********************************************************************************************* */
+bool WorkspaceControl::update (const Isometry3d& palm, Vector7d& command) {
+	if(!isEngaged) return false;
+	solve(target(palm), solution);
+	command = solution;
+	limit(command);
+	return true;
+}
+
+/* ********************************************************************************************* */
+void WorkspaceControl::limit (Vector7d& command) {
+	Vector7d change = command - commanded;
+	for(size_t i = 0; i < 7; i++) if(!isfinite(change(i))) change(i) = 0.0;
+	double largest = change.cwiseAbs().maxCoeff();
+	if(largest > params.maxCommandStep) change *= params.maxCommandStep / largest;
+	command = commanded = commanded + change;
+}
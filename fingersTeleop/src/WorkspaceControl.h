@@ -0,0 +1,98 @@
+/**
+ * @file WorkspaceControl.h
+ * @date Oct 18, 2026
+ * @brief Maps the palm pose (sensor 1) to an end-effector target for one of Krang's 7-dof arms
+ * and solves the damped least-squares inverse kinematics warm-started from the previous
+ * solution. Everything is fixed-size so that a solve does not allocate, and the number of
+ * iterations is bounded both by a count and by a time budget that fits the control period. The
+ * commands sent to the arm are rate limited apart from the solution: each one moves the joints at
+ * most IKParams::maxCommandStep from the previous one, whatever the IK or a stale policy asks.
+ */
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <stddef.h>
+
+typedef Eigen::Matrix <double, 7, 1> Vector7d;
+typedef Eigen::Matrix <double, 6, 1> Vector6d;
+typedef Eigen::Matrix <double, 6, 7> Jacobian;
+
+/* ********************************************************************************************* */
+/// The kinematics of a roll-pitch arm like the Schunk LWA3: the joints alternate between the z
+/// (roll) and y (pitch) axes with the links along z after the 2nd, 4th and 6th joints. The
+/// default lengths are the nominal LWA3 values; calibrate them for the real arm.
+struct ArmModel {
+	double base, upper, fore, hand;			///< Link lengths (m)
+	Vector7d lowerLimit, upperLimit;			///< Joint limits (rad)
+
+	ArmModel ();
+
+	/// Returns the end-effector pose in the arm base frame
+	Eigen::Isometry3d forward (const Vector7d& q) const;
+
+	/// Computes the geometric jacobian (linear rows first) and the end-effector pose
+	void jacobian (const Vector7d& q, Jacobian& J, Eigen::Isometry3d& ee) const;
+};
+
+/// The parameters of the solver
+struct IKParams {
+	double damping;				///< The damping factor lambda of the least-squares step
+	double maxStep;				///< The largest joint change per iteration (rad)
+	double maxCommandStep;		///< The largest joint change of a command from the last one (rad)
+	size_t maxIterations;
+	double budget;					///< Time budget of a solve (s), i.e. a fraction of the period
+	double tolerance;				///< Stops when the pose error norm is below this
+
+	IKParams ();
+};
+
+/* ********************************************************************************************* */
+class WorkspaceControl {
+public:
+
+	WorkspaceControl (const ArmModel& arm = ArmModel(), const IKParams& params = IKParams());
+
+	/// Clutches in: the current palm pose and arm configuration become the references, so that
+	/// the arm only follows the palm's motion from now on
+	void engage (const Eigen::Isometry3d& palm, const Vector7d& q);
+
+	bool engaged () const { return isEngaged; }
+	void disengage () { isEngaged = false; }
+
+	/// Returns the end-effector target for a palm pose: the palm's displacement since engage()
+	/// scaled and rotated into the arm base frame, applied to the reference end-effector pose
+	Eigen::Isometry3d target (const Eigen::Isometry3d& palm) const;
+
+	/// Moves q towards the target; returns the number of iterations used
+	size_t solve (const Eigen::Isometry3d& target, Vector7d& q) const;
+
+	/// Computes the target of the palm pose, solves it starting from the previous solution and
+	/// moves the command towards it (see limit); returns false if not engaged
+	bool update (const Eigen::Isometry3d& palm, Vector7d& command);
+
+	/// Scales the change of a command from the last one down to IKParams::maxCommandStep on the
+	/// joint that moves the most (one that is not finite stays at the last one), and makes it the
+	/// last one; engage() sets it to the configuration
+	void limit (Vector7d& command);
+
+	/// Changes the arm model and the solver parameters; the references and the last solution are
+	/// kept so that an engaged arm does not jump
+	void configure (const ArmModel& model, const IKParams& next) { arm = model, params = next; }
+
+	/// The pose error norm of the last solve before its last step, i.e. of its solution if it
+	/// stopped at the tolerance; not that of the rate limited command
+	double error () const { return lastError; }
+
+	double scale;						///< Workspace scaling from the palm to the end-effector motion
+	Eigen::Matrix3d mapping;		///< Rotation from the tracker (robot convention) to the arm base
+
+private:
+	ArmModel arm;
+	IKParams params;
+	bool isEngaged;
+	Eigen::Isometry3d palmReference, eeReference;
+	Vector7d solution, commanded;
+	mutable double lastError;
+};
@@ -1,7 +1,9 @@
 /** 
  * @date Sept 17, 2013
  * @brief This file shows an example of how to send a
- * Liberty message using ach and somatic.
+ * Liberty message using ach and somatic. With PLACEMENT set to a topology file (see placement.h),
+ * the client runs on the cores of its NUMA node, or of the channel's. Usage: client [rate (Hz),
+ * default 240]
  */
 
 #include "somatic.h"
@@ -14,6 +16,9 @@
 #include <fcntl.h>
 
 #include <iostream>
+#include "metrics.h"
+#include "eventLoop.h"
+#include "placement.h"
 
 using namespace std;
 
@@ -21,15 +26,21 @@ using namespace std;
 const char *argp_program_version = "client 0.0";
 #define ARGP_DESC "writes somatic events to syslog"
 
-// The somatic context and options
-somatic_d_t somaticContext;
+// The somatic options; the context lives in the event loop
 somatic_d_opts_t somaticOptions;
 
-// The ach channel and its name
-ach_channel_t achChannel;
+// The ach channel name and the publishing rate (Hz)
 const char *channelName;
+double rate = 240.0;
 
-// The Liberty message which is initialized in init() and filled out in run()
+// Runtime statistics, exported if METRICS_ENDPOINT is set
+MetricCounter sentMetric ("client_messages", "Liberty messages published", "channel=\"chan_liberty\"");
+MetricCounter failedMetric ("client_send_failures", "Messages that could not be put on the channel",
+	"channel=\"chan_liberty\"");
+MetricHistogram sendMetric ("client_send_seconds", "Time to pack and put a message", "channel=\"chan_liberty\"");
+MetricHistogram periodMetric ("client_loop_period_seconds", "Time between loop iterations");
+
+// The Liberty message which is initialized in init() and filled out in update()
 Somatic__Liberty* libertyMessage;
 
 /* ********************************************************************************************* */
@@ -42,58 +53,40 @@ void init() {
 	libertyMessage->meta = somatic_metadata_alloc();
 	libertyMessage->meta->type = SOMATIC__MSG_TYPE__LIBERTY;
 	libertyMessage->meta->has_type = 1;
-
-	// Initialize the somatic context 
-	somatic_d_init(&somaticContext, &somaticOptions);
-	somatic_d_channel_open(&somaticContext, &achChannel, channelName, NULL);
-}
-
-/* ********************************************************************************************* */
-void run() {
-
-	// Send a message; set the event code and the priority
-	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE, 
-			SOMATIC__EVENT__CODES__PROC_RUNNING, NULL, NULL);
-
-	double* x = new double [24];
-	while(!somatic_sig_received) { 
-
-		// get data
-		for(size_t i = 0; i < 24; i++) x[i] = ((double) rand()) / RAND_MAX;
-		somatic_verbprintf(1, "Liberty:\n%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n",
-				x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7], x[8], x[9], x[10], x[11], x[12], x[13], x[14], x[15], x[16], x[17], x[18], x[19], x[20], x[21], x[22], x[23]);
-
-		// fill message
-
-		aa_fcpy( libertyMessage->sensor1->data, x, 6 );
-		aa_fcpy( libertyMessage->sensor2->data, x+6, 6 );
-		aa_fcpy( libertyMessage->sensor3->data, x+12, 6 );
-    		aa_fcpy( libertyMessage->sensor4->data, x+18, 6 );
- 
-		somatic_metadata_set_time_now(libertyMessage->meta);
-		somatic_metadata_set_until_duration( libertyMessage->meta, .1);
-
-		// send message
-		ach_status_t result = SOMATIC_PACK_SEND(&achChannel, somatic__liberty, libertyMessage);
-		if(ACH_OK != result)
-			fprintf(stderr, "Couldn't send message: %s\n", ach_result_to_string(result));
-	}   
-
-	// Send the stoppig event
-	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE, 
-			SOMATIC__EVENT__CODES__PROC_STOPPING, NULL, NULL);
 }
 
 /* ********************************************************************************************* */
-void destroy() {
-
-	// Close the channel and end the daemon
-	somatic_d_channel_close(&somaticContext, &achChannel);
-	somatic_d_destroy(&somaticContext);
+void update(ach_channel_t* achChannel) {
+
+	// get data
+	double x [24];
+	for(size_t i = 0; i < 24; i++) x[i] = ((double) rand()) / RAND_MAX;
+	somatic_verbprintf(1, "Liberty:\n%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n",
+			x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7], x[8], x[9], x[10], x[11], x[12], x[13], x[14], x[15], x[16], x[17], x[18], x[19], x[20], x[21], x[22], x[23]);
+
+	// fill message
+
+	aa_fcpy( libertyMessage->sensor1->data, x, 6 );
+	aa_fcpy( libertyMessage->sensor2->data, x+6, 6 );
+	aa_fcpy( libertyMessage->sensor3->data, x+12, 6 );
+	aa_fcpy( libertyMessage->sensor4->data, x+18, 6 );
+
+	somatic_metadata_set_time_now(libertyMessage->meta);
+	somatic_metadata_set_until_duration( libertyMessage->meta, .1);
+
+	// send message
+	double start = metricsNow();
+	ach_status_t result = SOMATIC_PACK_SEND(achChannel, somatic__liberty, libertyMessage);
+	sendMetric.observe(metricsNow() - start);
+	if(ACH_OK != result) {
+		failedMetric.add();
+		fprintf(stderr, "Couldn't send message: %s\n", ach_result_to_string(result));
+	}
+	else sentMetric.add();
 }
 
 /* ********************************************************************************************* */
-int main() {
+int main(int argc, char* argv[]) {
 
 	// Set the somatic context options
 	somaticOptions.ident = "client";
@@ -102,10 +95,31 @@ int main() {
 
 	// Set the channel name
 	channelName = "chan_liberty";
-
+	if(argc > 1) {
+		char* end;
+		rate = strtod(argv[1], &end);
+		if(end == argv[1] || *end != '\0' || !(rate > 0.0 && rate <= 1e6)) {
+			fprintf(stderr, "Invalid rate '%s', expected a number of Hz in (0, 1e6]\n", argv[1]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	metricsServe(getenv("METRICS_ENDPOINT"));
 	init();
-	run();
-	destroy();
+
+	// Send a message every period until an interrupt or terminate signal is received
+	EventLoop loop (somaticOptions);
+	Placement placement (getenv("PLACEMENT"));
+	loop.pin(placement.daemonNode(somaticOptions.ident, channelName));
+	ach_channel_t* achChannel = loop.publish(channelName);
+	double lastCycle = metricsNow();
+	loop.every(1.0 / rate, [&]() {
+		double now = metricsNow();
+		periodMetric.observe(now - lastCycle);
+		lastCycle = now;
+		update(achChannel);
+	});
+	loop.run();
 
 	return 0;
 }
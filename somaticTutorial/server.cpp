@@ -1,7 +1,11 @@
 /**
  * @date Sept 17, 2013
  * @brief This file shows an example usage of the somatic library. The server
- * creates an ach channnel and processes the messages received on it.
+ * creates an ach channnel and processes the messages received on it. With PLACEMENT set to a
+ * topology file (see placement.h), the channel memory and the server threads are put on the
+ * NUMA nodes it names. The channel is chan_liberty unless named with -c; a channel that already
+ * exists, i.e. one a load sweep created (see 21-sweepLiberty), is read as it is.
+ * Usage: server [-c channel]
  */
 
 #include "somatic.h"
@@ -12,26 +16,58 @@
 #include <unistd.h>
 #include <syslog.h>
 #include <fcntl.h>
+#include "metrics.h"
+#include "eventLoop.h"
+#include "trace.h"
+#include "shedder.h"
+#include "placement.h"
 
 /// argp program version
 const char *argp_program_version = "server 0.0";
 #define ARGP_DESC "writes somatic events to syslog"
 
-// The somatic context and options
-somatic_d_t somaticContext;
+// The somatic options; the context lives in the event loop
 somatic_d_opts_t somaticOptions;
 
-// The ach channel and its name
-ach_channel_t achChannel;
+// The ach channel name
 const char *channelName;
 
+// The sequence number of the last frame read
+uint64_t lastSeq = 0;
+
+// Runtime statistics, exported if METRICS_ENDPOINT is set; the ones of the channel are labelled
+// with its name in main
+MetricCounter messagesMetric ("server_messages", "Liberty messages received");
+MetricCounter missedMetric ("server_missed_frames", "Frames overwritten before being read");
+MetricGauge depthMetric ("server_queue_depth", "Unread frames on the channel before a read");
+MetricHistogram decodeMetric ("server_decode_seconds", "Time to unpack a message");
+MetricHistogram latencyMetric ("server_latency_seconds", "Time from the message stamp to its unpacking");
+Metric* const channelMetrics [] = {&messagesMetric, &missedMetric, &depthMetric, &decodeMetric, &latencyMetric};
+MetricHistogram periodMetric ("server_loop_period_seconds", "Time between loop iterations");
+
+// Drops the printing before the reading falls behind the 240 Hz liberty frames on a busy host
+LoadShedder shedder ("server", 1.0 / 240);
+size_t printOutput = shedder.add("print", SHED_BEST_EFFORT, 2e-4);
+
 // Argument processing
 static int parse_opt( int key, char *arg, struct argp_state *state);
-extern struct argp_option argp_options[];
-extern struct argp argp;
+struct argp_option argp_options[] = {
+	{"chan", 'c', "channel", 0, "ach channel to create and read (default chan_liberty)", 0},
+	{0, 0, 0, 0, 0, 0}
+};
+struct argp argp = {argp_options, parse_opt, NULL, ARGP_DESC, NULL, NULL, NULL};
+
+/* ********************************************************************************************* */
+static int parse_opt( int key, char *arg, struct argp_state *state) {
+	switch(key) {
+		case 'c': channelName = arg; return 0;
+		case ARGP_KEY_ARG: argp_usage(state); return 0;
+		default: return ARGP_ERR_UNKNOWN;
+	}
+}
 
 /* ********************************************************************************************* */
-void init() {
+void init(Placement& placement) {
 
 	somatic_opt_verbosity = 9;
 
@@ -46,11 +82,18 @@ void init() {
 	const size_t messageCount = 512;
 	const size_t messageSize = ACH_DEFAULT_FRAME_SIZE;
 	ach_status_t result = ach_create(channelName, messageCount, messageSize, &attr);
+	if(result == ACH_EEXIST) {
+		fprintf(stderr, "Reading the existing channel %s\n", channelName);
+		return;
+	}
 	if(result != ACH_OK) {
 		fprintf(stderr, "Error creating channel %s: %s\n", channelName, ach_result_to_string(result));
 		exit(EXIT_FAILURE); 
 	}
 
+	// Move its memory to the node of its readers
+	if(!placement.placeChannel(channelName)) exit(EXIT_FAILURE);
+
 	// =======================================================
 	// B. Change the channel mode
 	// NOTE: To do that, we need to open the channel, set the option and then close it.
@@ -79,88 +122,66 @@ void init() {
 		exit(EXIT_FAILURE); 
 	}
 
-	// =======================================================
-	// C. Prepare the somatic context
-
-	// Initialize the somatic context 
-	// NOTE: somatic_d_init sends a SOMATIC__EVENT__CODES__PROC_STARTING message on the ach channel.
-	// NOTE: somatic_d_channel opens the channel back again. Maybe we did not need to close it!
-	somatic_d_init(&somaticContext, &somaticOptions);
-	somatic_d_channel_open(&somaticContext, &achChannel, channelName, NULL);
+	// NOTE: The somatic context is prepared by the EventLoop in main: somatic_d_init sends a 
+	// SOMATIC__EVENT__CODES__PROC_STARTING message and subscribe() opens the channel back again.
 }
 
 /* ********************************************************************************************* */
-void update() {
+void update(EventLoop& loop, ach_channel_t* achChannel, const uint8_t* buffer, size_t numBytes, int result) {
 
 	// =======================================================
 	// A. Get message
-	// NOTE: This is usually done with SOMATIC_D_GET which is a macro.
-
-	// Set the time to read (?)
-	struct timespec abstimeout = aa_tm_future( aa_tm_sec2timespec(1) );
+	// NOTE: The event loop reads the channel (with somatic_d_get) and calls us for every frame.
 
-	// Check if there is anything to read
-	int result;
-	size_t numBytes = 0;
-	uint8_t* buffer = (uint8_t*) somatic_d_get(&somaticContext, &achChannel, &numBytes, &abstimeout, ACH_O_WAIT, &result);
-
-	// Return if there is nothing to read
-	if(numBytes == 0) return;
+	if(result == ACH_MISSED_FRAME) missedMetric.add();
+	uint64_t seq = achChannel->seq_num;
+	if(lastSeq > 0 && seq > lastSeq) depthMetric.set(seq - lastSeq);
+	lastSeq = seq;
 
 	// =======================================================
 	// B. Read message
 
 	// Read the message with the base struct to check its type
-	Somatic__BaseMsg* msg = somatic__base_msg__unpack(&(somaticContext.pballoc), numBytes, buffer);
-	if((msg->meta == NULL) || !msg->meta->has_type) return;
-	if(msg->meta->type != SOMATIC__MSG_TYPE__LIBERTY) return;
-
-	// Read the liberty message
-	Somatic__Liberty* libertyMessage = somatic__liberty__unpack(&(somaticContext.pballoc), numBytes, buffer);
-	printf("[server] Liberty:\n");
-
-	for(size_t i = 0; i < 6; i++)
-        	printf("%6.2f  ", libertyMessage->sensor1->data[i]);
-	printf("\n");
-	for(size_t i = 0; i < 6; i++)
-                printf("%6.2f  ", libertyMessage->sensor2->data[i]);
-	printf("\n");
-	for(size_t i = 0; i < 6; i++)
-                printf("%6.2f  ", libertyMessage->sensor3->data[i]);
-	printf("\n");
-	for(size_t i = 0; i < 6; i++)
-                printf("%6.2f  ", libertyMessage->sensor4->data[i]);
-	printf("\n"); fflush(stdout);
-}
-
-/* ********************************************************************************************* */
-void run() {
-
-	// Send a message; set the event code and the priority
-	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE, 
-			SOMATIC__EVENT__CODES__PROC_RUNNING, NULL, NULL);
-
-	// Unless an interrupt or terminate message is received, process the new message
-	while(!somatic_sig_received) {
-		update();
-		aa_mem_region_release(&somaticContext.memreg);	// free buffers allocated during this cycle
+	double start = metricsNow();
+	Somatic__Liberty* libertyMessage;
+	{
+		TRACE_SCOPE("unpack");
+		Somatic__BaseMsg* msg = somatic__base_msg__unpack(&(loop.daemon()->pballoc), numBytes, buffer);
+		if((msg->meta == NULL) || !msg->meta->has_type) return;
+		if(msg->meta->type != SOMATIC__MSG_TYPE__LIBERTY) return;
+
+		// Read the liberty message
+		libertyMessage = somatic__liberty__unpack(&(loop.daemon()->pballoc), numBytes, buffer);
 	}
+	decodeMetric.observe(metricsNow() - start);
+	const Somatic__Metadata* meta = libertyMessage->meta;
+	if(meta != NULL && meta->time != NULL) latencyMetric.observe(metricsNow() - (meta->time->sec + meta->time->nsec * 1e-9));
+	messagesMetric.add();
 
-	// Send the stoppig event
-	somatic_d_event(&somaticContext, SOMATIC__EVENT__PRIORITIES__NOTICE,
-					 SOMATIC__EVENT__CODES__PROC_STOPPING, NULL, NULL);
-}
-
-/* ********************************************************************************************* */
-void destroy() {
-
-	// Close the channel and end the daemon
-	somatic_d_channel_close(&somaticContext, &achChannel);
-	somatic_d_destroy(&somaticContext);
+	// =======================================================
+	// C. Print message, unless the host is too busy for it
+
+	shedder.run(printOutput, [&]() {
+		TRACE_SCOPE("print");
+		printf("[server] Liberty:\n");
+
+		for(size_t i = 0; i < 6; i++)
+			printf("%6.2f  ", libertyMessage->sensor1->data[i]);
+		printf("\n");
+		for(size_t i = 0; i < 6; i++)
+			printf("%6.2f  ", libertyMessage->sensor2->data[i]);
+		printf("\n");
+		for(size_t i = 0; i < 6; i++)
+			printf("%6.2f  ", libertyMessage->sensor3->data[i]);
+		printf("\n");
+		for(size_t i = 0; i < 6; i++)
+			printf("%6.2f  ", libertyMessage->sensor4->data[i]);
+		printf("\n"); fflush(stdout);
+	});
 }
 
 /* ********************************************************************************************* */
-int main() {
+int main(int argc, char* argv[]) {
 
 	// Set the somatic context options
 	somaticOptions.ident = "server";
@@ -169,10 +190,30 @@ int main() {
 
 	// Set the channel name
 	channelName = "chan_liberty";
-
-	init();
-	run();
-	destroy();
+	argp_parse(&argp, argc, argv, 0, NULL, NULL);
+	std::string labels = std::string("channel=\"") + channelName + "\"";
+	for(size_t i = 0; i < sizeof(channelMetrics) / sizeof(channelMetrics[0]); i++)
+		channelMetrics[i]->relabel(labels.c_str());
+
+	metricsServe(getenv("METRICS_ENDPOINT"));
+	traceStart(getenv("TRACE"));
+	Placement placement (getenv("PLACEMENT"));
+	init(placement);
+
+	// Process the messages until an interrupt or terminate signal is received
+	EventLoop loop (somaticOptions);
+	loop.pin(placement.daemonNode(somaticOptions.ident, channelName));
+	double lastCycle = metricsNow();
+	ach_channel_t* achChannel = NULL;
+	achChannel = loop.subscribe(channelName, [&](const uint8_t* frame, size_t size, ach_status_t result) {
+		double now = metricsNow();
+		periodMetric.observe(now - lastCycle);
+		lastCycle = now;
+		shedder.begin();
+		update(loop, achChannel, frame, size, result);
+		shedder.end();
+	});
+	loop.run();
 
 	return 0;
 }